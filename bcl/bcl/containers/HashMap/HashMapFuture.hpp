@@ -21,9 +21,9 @@ public:
   HashMapFuture& operator=(const HashMapFuture&) = delete;
 
   HashMapFuture(const key_type& key, H& hash_map) : key_(key), hash_map_(hash_map) {
-    hash_ = hash_map_.hash_fn(key);
+    hash_ = hash_map_.hash_fn_(key);
 
-    uint64_t slot = (hash_ + hash_map_.get_probe(probe_++)) % hash_map_.size;
+    uint64_t slot = (hash_ + hash_map_.get_probe(probe_++)) % hash_map_.capacity();
     entry_ = std::move(hash_map_.arget_entry(slot));
   }
 
@@ -42,12 +42,12 @@ public:
         value_ = entry;
         return std::future_status::ready;
       } else {
-        if (entry.get_key() == key_) {
+        if (entry.get_key() == key_ || probe_ >= hash_map_.capacity()) {
           success_ = true;
           value_ = entry;
           return std::future_status::ready;
         } else {
-          uint64_t slot = (hash_ + hash_map_.get_probe(probe_++)) % hash_map_.size;
+          uint64_t slot = (hash_ + hash_map_.get_probe(probe_++)) % hash_map_.capacity();
           entry_ = std::move(hash_map_.arget_entry(slot));
           return std::future_status::timeout;
         }
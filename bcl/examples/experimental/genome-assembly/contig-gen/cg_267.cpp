@@ -4,6 +4,8 @@
 #include <list>
 #include <limits>
 #include <numeric>
+#include <algorithm>
+#include <optional>
 
 #include <unordered_set>
 
@@ -62,15 +64,19 @@ int main (int argc, char **argv) {
   BCL::init(2048);
 
   std::string kmer_fname = "/global/cscratch1/sd/brock/267-dataset/large.txt";
-
-  size_t n_kmers = 0;
-  if (BCL::rank() == 0) {
-    n_kmers = line_count(kmer_fname);
+  if (argc > 1) {
+    kmer_fname = argv[1];
   }
 
-  n_kmers = BCL::allreduce<size_t>(n_kmers, std::plus<size_t>{});
+  auto start_read_kmers = std::chrono::high_resolution_clock::now();
+
+  std::vector <kmer_pair> kmers = read_kmers(kmer_fname, BCL::nprocs(), BCL::rank());
+
+  size_t n_kmers = BCL::allreduce<size_t>(kmers.size(), std::plus<size_t>{});
 
-  BCL::print("Got %lu k-mers\n", n_kmers);
+  double read_kmers_time = std::chrono::duration<double>(
+    std::chrono::high_resolution_clock::now() - start_read_kmers).count();
+  BCL::print("Read %lu k-mers in %lf\n", n_kmers, read_kmers_time);
 
   double load_factor = 0.5;
   size_t hash_table_size = n_kmers * (1.0 / load_factor);
@@ -84,10 +90,6 @@ int main (int argc, char **argv) {
   BCL::print("Initializing hash table of size %lu for %lu kmers.\n",
              hash_table_size, n_kmers);
 
-  std::vector <kmer_pair> kmers = read_kmers(kmer_fname, BCL::nprocs(), BCL::rank());
-
-  BCL::print("Finished reading k-mers.\n");
-
   BCL::barrier();
 
   std::vector<kmer_pair> start_nodes;
@@ -124,17 +126,64 @@ int main (int argc, char **argv) {
 
   auto start_read = std::chrono::high_resolution_clock::now();
 
-  for (const auto& start_kmer : start_nodes) {
-    std::list<kmer_pair> contig;
-    contig.push_back(start_kmer);
-    while (contig.back().forwardExt() != 'F') {
-      pkmer_t next_kmer = pkmer_t(contig.back().next_kmer().get());
-      auto kmer_iter = kmer_hash.find(next_kmer, BCL::HashMapAL::find);
-      fb_ext fb = *kmer_iter;
-      kmer_pair kmer(next_kmer.get(), fb.get());
-      contig.push_back(kmer);
+  // Walk up to max_walks contigs at once.  Each round issues the next
+  // lookup of every active walk as an arfind future, grouped by the
+  // rank owning its first probe, and then completes them together, so
+  // a rank waits for one round trip per round rather than per base.
+  const size_t max_walks = 8192;
+  size_t next_start = 0;
+  std::vector<std::list<kmer_pair>> walks;
+
+  using future_type = decltype(kmer_hash.arfind(pkmer_t()));
+
+  while (!walks.empty() || next_start < start_nodes.size()) {
+    while (walks.size() < max_walks && next_start < start_nodes.size()) {
+      std::list<kmer_pair> contig;
+      contig.push_back(start_nodes[next_start++]);
+      if (contig.back().forwardExt() == 'F') {
+        contigs.push_back(std::move(contig));
+      } else {
+        walks.push_back(std::move(contig));
+      }
+    }
+
+    std::vector<std::pair<size_t, size_t>> owners;
+    std::vector<pkmer_t> next_kmers;
+    for (size_t i = 0; i < walks.size(); i++) {
+      next_kmers.push_back(pkmer_t(walks[i].back().next_kmer().get()));
+      size_t slot = kmer_hash.hash_fn_(next_kmers.back()) % kmer_hash.capacity();
+      owners.push_back({slot / kmer_hash.local_capacity(), i});
+    }
+    std::sort(owners.begin(), owners.end());
+
+    std::vector<future_type> futures;
+    futures.reserve(owners.size());
+    for (const auto& owner : owners) {
+      futures.push_back(kmer_hash.arfind(next_kmers[owner.second]));
+    }
+
+    // All first probes are in flight, so waiting on them in order
+    // costs about one round trip in total.
+    std::vector<std::optional<fb_ext>> fbs;
+    for (auto& future : futures) {
+      fbs.push_back(future.get());
+    }
+
+    std::vector<std::list<kmer_pair>> active;
+    for (size_t i = 0; i < owners.size(); i++) {
+      size_t walk = owners[i].second;
+      if (!fbs[i].has_value()) {
+        throw std::runtime_error("cg_267: k-mer " + next_kmers[walk].get() +
+                                 " not found");
+      }
+      walks[walk].push_back(kmer_pair(next_kmers[walk].get(), fbs[i]->get()));
+      if (walks[walk].back().forwardExt() == 'F') {
+        contigs.push_back(std::move(walks[walk]));
+      } else {
+        active.push_back(std::move(walks[walk]));
+      }
     }
-    contigs.push_back(contig);
+    walks = std::move(active);
   }
 
   BCL::barrier();
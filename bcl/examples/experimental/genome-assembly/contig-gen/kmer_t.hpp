@@ -7,34 +7,35 @@
 #include <string>
 #include <cstring>
 
-std::string rcomplement(std::string str) {
-  std::string rstr = std::string(str);
-  for (int i = 0; i < str.length(); i++) {
-    if (str[i] == 'A') {
-      rstr[i] = 'T';
-    }
-    if (str[i] == 'C') {
-      rstr[i] = 'G';
-    }
-    if (str[i] == 'G') {
-      rstr[i] = 'C';
-    }
-    if (str[i] == 'T') {
-      rstr[i] = 'A';
-    }
+inline char complement(char base) {
+  switch (base) {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+    default: return base;
+  }
+}
+
+std::string rcomplement(const std::string &str) {
+  std::string rstr(str.length(), 0);
+  for (size_t i = 0; i < str.length(); i++) {
+    rstr[i] = complement(str[str.length() - 1 - i]);
   }
-  std::reverse(rstr.begin(), rstr.end());
   return rstr;
 }
 
-std::string canonicalize(std::string str) {
-  std::string reverse = rcomplement(str);
-  int lex_ind = strncmp(str.data(), reverse.data(), str.length());
-  if (lex_ind < 0) {
-    return str;
-  } else {
-    return reverse;
+// Compares str with its reverse complement base by base, so the
+// reverse complement is only built when it is the result.
+std::string canonicalize(const std::string &str) {
+  size_t len = str.length();
+  for (size_t i = 0; i < len; i++) {
+    char rbase = complement(str[len - 1 - i]);
+    if (str[i] != rbase) {
+      return (str[i] < rbase) ? str : rcomplement(str);
+    }
   }
+  return str;
 }
 
 struct pkmer_t {
@@ -102,6 +103,14 @@ struct kmer_pair {
     }
   }
 
+  // kmer holds KMER_LEN bases and fb_ext two characters.
+  void init(const char *kmer, const char *fb_ext) {
+    packKmer(kmer, this->kmer.data);
+    for (int i = 0; i < 2; i++) {
+      this->fb_ext[i] = fb_ext[i];
+    }
+  }
+
   void init(const kmer_pair &kmer) {
     this->kmer = kmer.kmer;
     for (int i = 0; i < 2; i++) {
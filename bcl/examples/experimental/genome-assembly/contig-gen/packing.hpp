@@ -1,6 +1,12 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 
 #define KMER_LEN 51
 #define PACKED_KMER_LEN ((KMER_LEN+3)/4)
@@ -67,24 +73,78 @@ unsigned char packFourMer(const char *fourMer)
   return ((unsigned char) retval);
 }
 
+// 2-bit code of a base, A, C, G, T -> 0, 1, 2, 3, without branches:
+// bits 1-2 of the ASCII codes are 0, 1, 3 and 2.
+inline unsigned char baseCode(char base) {
+  unsigned char code = (base >> 1) & 0x3;
+  return code ^ (code >> 1);
+}
+
+#if defined(__AVX2__)
+// Packs 32 bases into 8 bytes.
+inline void packThirtyTwoMer(const char *mer, unsigned char *packed) {
+  __m256i bases = _mm256_loadu_si256((const __m256i *) mer);
+  // Indexed by the low nibble: A = 1, C = 3, G = 7, T = 4.
+  const __m256i codes_lut = _mm256_setr_epi8(0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i codes = _mm256_shuffle_epi8(codes_lut, _mm256_and_si256(bases, _mm256_set1_epi8(0x0f)));
+  __m256i pairs = _mm256_maddubs_epi16(codes, _mm256_set1_epi32(0x01041040));
+  __m256i fours = _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+  const __m256i gather = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  __m256i bytes = _mm256_shuffle_epi8(fours, gather);
+  uint32_t lo = _mm256_extract_epi32(bytes, 0);
+  uint32_t hi = _mm256_extract_epi32(bytes, 4);
+  memcpy(packed, &lo, 4);
+  memcpy(packed + 4, &hi, 4);
+}
+#endif
+
+#if defined(__SSSE3__)
+// Packs 16 bases into 4 bytes.
+inline void packSixteenMer(const char *mer, unsigned char *packed) {
+  __m128i bases = _mm_loadu_si128((const __m128i *) mer);
+  const __m128i codes_lut = _mm_setr_epi8(0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i codes = _mm_shuffle_epi8(codes_lut, _mm_and_si128(bases, _mm_set1_epi8(0x0f)));
+  // (64*c0 + 16*c1, 4*c2 + c3), then their sum.
+  __m128i pairs = _mm_maddubs_epi16(codes, _mm_set1_epi32(0x01041040));
+  __m128i fours = _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+  __m128i bytes = _mm_shuffle_epi8(fours, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1,
+                                                         -1, -1, -1, -1, -1, -1, -1, -1));
+  uint32_t word = _mm_cvtsi128_si32(bytes);
+  memcpy(packed, &word, 4);
+}
+#endif
+
 void packKmer(const char *kmer, unsigned char *packed_kmer) {
-  int ind, j = 0;
-  int i = 0;
+  int i = 0, j = 0;
 
-  for ( ; j <= KMER_LEN - 4; i++, j += 4) {
-    packed_kmer[i] = packFourMer(kmer + j);
+#if defined(__AVX2__)
+  for ( ; j + 32 <= KMER_LEN; i += 8, j += 32) {
+    packThirtyTwoMer(kmer + j, packed_kmer + i);
+  }
+#endif
+#if defined(__SSSE3__)
+  for ( ; j + 16 <= KMER_LEN; i += 4, j += 16) {
+    packSixteenMer(kmer + j, packed_kmer + i);
   }
+#endif
 
-  int remainder = KMER_LEN % 4;
-  char blockSeq[5] = "AAAA";
-  for (ind = 0; ind < remainder; ind++) {
-    blockSeq[ind] = kmer[j + ind];
+  for ( ; j + 4 <= KMER_LEN; i++, j += 4) {
+    packed_kmer[i] = (baseCode(kmer[j]) << 6) | (baseCode(kmer[j+1]) << 4) |
+                     (baseCode(kmer[j+2]) << 2) | baseCode(kmer[j+3]);
   }
 
-  packed_kmer[i] = packFourMer(blockSeq);
+  // Pad the last block with A's.
+  if (KMER_LEN % 4 != 0) {
+    unsigned char block = 0;
+    for (int ind = 0; j + ind < KMER_LEN; ind++) {
+      block |= baseCode(kmer[j + ind]) << (6 - 2*ind);
+    }
+    packed_kmer[i] = block;
+  }
 }
 
-
 void unpackKmer(const unsigned char packed_kmer[PACKED_KMER_LEN],
   char *kmer) {
   if (!packedCodeToFourMerCoded) {
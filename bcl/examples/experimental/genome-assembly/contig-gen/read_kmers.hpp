@@ -7,6 +7,12 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "kmer_t.hpp"
 
@@ -20,42 +26,76 @@ size_t line_count(const std::string &fname) {
   size_t n_lines = 0;
   size_t n_read;
 
-  const size_t buf_size = 16384;
-  char buf[buf_size];
+  const size_t buf_size = 1 << 20;
+  std::unique_ptr<char[]> buf(new char[buf_size]);
 
   do {
-    n_read = fread(buf, sizeof(char), buf_size, f);
-    for (size_t i = 0; i < n_read; i++) {
-      if (buf[i] == '\n') {
-        n_lines++;
-      }
+    n_read = fread(buf.get(), sizeof(char), buf_size, f);
+    const char *pos = buf.get();
+    const char *end = buf.get() + n_read;
+    while ((pos = (const char *) memchr(pos, '\n', end - pos)) != nullptr) {
+      n_lines++;
+      pos++;
     }
   } while (n_read != 0);
   fclose(f);
   return n_lines;
 }
 
+// Reads the k-mers of the lines starting in this rank's share of the
+// file's bytes.  A line belongs to the rank whose byte range holds its
+// first byte, so no line count is needed and lines may differ in
+// length.  Each line is a k-mer, a space and its two extensions.
 std::vector <kmer_pair> read_kmers(const std::string &fname, uint64_t nprocs = 1, uint64_t rank = 0) {
-  size_t num_lines = line_count(fname);
-  size_t split = (num_lines + nprocs - 1) / nprocs;
-  size_t start = split*rank;
-  size_t size = std::min(split, num_lines - start);
-
-  FILE *f = fopen(fname.c_str(), "r");
-  const size_t line_len = KMER_LEN + 4;
-  fseek(f, line_len*start, SEEK_SET);
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("read_kmers: could not open " + fname);
+  }
 
-  std::shared_ptr <char> buf(new char[line_len*size]);
-  size_t n_read = fread(buf.get(), sizeof(char), line_len*size, f);
+  struct stat st;
+  fstat(fd, &st);
+  size_t file_size = st.st_size;
+  size_t begin = (file_size * rank) / nprocs;
+  size_t end = (file_size * (rank + 1)) / nprocs;
 
   std::vector <kmer_pair> kmers;
+  if (begin == end) {
+    close(fd);
+    return kmers;
+  }
 
-  for (size_t line_offset = 0; line_offset < line_len*size; line_offset += line_len) {
-    char *kmer_buf = &buf.get()[line_offset];
-    char *fb_ext_buf = kmer_buf + KMER_LEN+1;
-    kmers.push_back(kmer_pair(std::string(kmer_buf, KMER_LEN), std::string(fb_ext_buf, 2)));
+  // Map from the page holding begin-1, which tells whether a line
+  // starts at begin, to the end of the file, for the last line.
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t map_offset = ((begin > 0 ? begin - 1 : 0) / page_size) * page_size;
+  size_t map_size = file_size - map_offset;
+  void *map = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, map_offset);
+  close(fd);
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("read_kmers: could not map " + fname);
   }
-  fclose(f);
+  madvise(map, map_size, MADV_SEQUENTIAL);
+  const char *data = (const char *) map - map_offset;
+
+  size_t pos = begin;
+  if (begin > 0 && data[begin - 1] != '\n') {
+    const char *newline = (const char *) memchr(data + begin, '\n', file_size - begin);
+    pos = (newline == nullptr) ? file_size : (newline - data) + 1;
+  }
+
+  kmers.reserve((end - begin) / (KMER_LEN + 4) + 1);
+  while (pos < end) {
+    const char *line = data + pos;
+    const char *newline = (const char *) memchr(line, '\n', file_size - pos);
+    size_t line_len = (newline == nullptr) ? file_size - pos : newline - line;
+    if (line_len >= KMER_LEN + 3) {
+      kmers.emplace_back();
+      kmers.back().init(line, line + KMER_LEN + 1);
+    }
+    pos += line_len + 1;
+  }
+
+  munmap(map, map_size);
   return kmers;
 }
 
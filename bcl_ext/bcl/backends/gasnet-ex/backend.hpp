@@ -40,7 +40,14 @@ inline void barrier() {
   gex_Event_Wait(event);
 }
 
-inline void flush() {}
+// Completes the NBI puts and atomics, e.g. of rput_async().
+inline void flush() {
+  gex_NBI_Wait(GEX_EC_ALL, 0);
+}
+
+inline void flush(const uint64_t &rank) {
+  gex_NBI_Wait(GEX_EC_ALL, 0);
+}
 
 template <typename T>
 inline void* gasnet_resolve_address(const GlobalPtr<T> ptr) {
@@ -5,10 +5,13 @@
 #include "request.hpp"
 
 #include <vector>
+#include <cstring>
 #include <functional>
+#include <type_traits>
 #include <gasnet_coll.h>
 
 #include "atomics.hpp"
+#include "detail/word_atomic_impl.hpp"
 
 namespace BCL {
 extern gasnet_seginfo_t *gasnet_seginfo;
@@ -42,6 +45,12 @@ inline void write(const T *src, const GlobalPtr <T> &dst, const size_t size) {
   gex_RMA_PutBlocking(tm, dst.rank, dst_ptr, (T *) src, size*sizeof(T), 0);
 }
 
+template <typename T>
+inline void atomic_write(const T *src, const GlobalPtr <T> &dst, const size_t size) {
+  void* dst_ptr = gasnet_resolve_address(dst);
+  gex_RMA_PutBlocking(tm, dst.rank, dst_ptr, (T *) src, size*sizeof(T), 0);
+}
+
 template <typename T>
 inline BCL::request async_read(const GlobalPtr<T>& src, T* dst, size_t size) {
   void* src_ptr = gasnet_resolve_address(src);
@@ -128,6 +137,32 @@ future<T> arfetch_and_op(const GlobalPtr <T> ptr, const T &val, const atomic_op
   return std::move(future);
 }
 
+// Apply op elementwise to size T's at dst, fetching the old
+// values into result.  AD ops act on a single word, so this
+// issues one op per element, all in flight together, and
+// completes before returning.
+template <typename T>
+inline BCL::request async_fetch_and_op(const T* src, T* result, const GlobalPtr<T>& dst,
+                                       size_t size, const atomic_op<T>& op) {
+  std::vector<gex_Event_t> events(size);
+  for (size_t i = 0; i < size; i++) {
+    events[i] = shim_gex_AD_OpNB<T>(get_gex_ad<T>(), &result[i], dst.rank,
+                                    gasnet_resolve_address(dst + i),
+                                    op.op(), src[i], src[i], 0);
+  }
+  gex_Event_WaitAll(events.data(), size, 0);
+  return BCL::request();
+}
+
+// Apply op elementwise to size T's at dst without keeping
+// the old values.
+template <typename T>
+inline BCL::request async_accumulate(const T* src, const GlobalPtr<T>& dst,
+                                     size_t size, const atomic_op<T>& op) {
+  std::vector<T> result(size);
+  return async_fetch_and_op(src, result.data(), dst, size, op);
+}
+
 int32_t int_compare_and_swap(GlobalPtr<int32_t> ptr, int32_t old_val,
                              int32_t new_val) {
   void* dst_ptr = gasnet_resolve_address(ptr);
@@ -139,4 +174,167 @@ int32_t int_compare_and_swap(GlobalPtr<int32_t> ptr, int32_t old_val,
   return rv;
 }
 
+/* Mine */
+
+// The DDS primitive set.  Atomic ones go through the atomic
+// domains, which the NIC may execute, so they never mix with
+// CPU atomics on the same words.  The *_async writes are NBI
+// and complete at BCL::flush(), or at the next fetching atomic,
+// as the MPI backend's window flush would.  The *_async reads
+// return their value, so they complete before returning.
+
+// The domain type of U: integral U's use the unsigned domain
+// of their size, so signed and unsigned ops on a word agree.
+template <typename U>
+using gex_ad_type_ = std::conditional_t<std::is_integral<U>::value,
+                                        std::conditional_t<sizeof(U) == 4, uint32_t, uint64_t>,
+                                        U>;
+
+template <typename T>
+inline void lwrite(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	std::memcpy(dst.local(), src, size*sizeof(T));
+}
+
+template <typename T>
+inline void rwrite_sync(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	void *dst_ptr = gasnet_resolve_address(dst);
+	gex_RMA_PutBlocking(tm, dst.rank, dst_ptr, const_cast<T *>(src), size*sizeof(T), 0);
+}
+
+template <typename T>
+inline void rwrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	void *dst_ptr = gasnet_resolve_address(dst);
+	gex_RMA_PutNBI(tm, dst.rank, dst_ptr, const_cast<T *>(src), size*sizeof(T), GEX_EVENT_NOW, 0);
+}
+
+template <typename T>
+inline void awrite_sync(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		word_atomic_impl_<T>::set(dst + i, src[i]);
+	gex_NBI_Wait(GEX_EC_ALL, 0);
+}
+
+template <typename T>
+inline void awrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		word_atomic_impl_<T>::set(dst + i, src[i]);
+}
+
+template <typename T>
+inline void lread(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	std::memcpy(dst, src.local(), size*sizeof(T));
+}
+
+template <typename T>
+inline void rread_sync(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	void *src_ptr = gasnet_resolve_address(src);
+	gex_RMA_GetBlocking(tm, dst, src.rank, src_ptr, size*sizeof(T), 0);
+}
+
+template <typename T>
+inline void rread_async(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	rread_sync(src, dst, size);
+}
+
+template <typename T>
+inline void aread_sync(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		dst[i] = word_atomic_impl_<T>::fetch(src + i);
+}
+
+template <typename T>
+inline void aread_async(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	aread_sync(src, dst, size);
+}
+
+template <typename T, typename U>
+inline void fetch_and_op_sync(const GlobalPtr<T> &dst, const T *val, const atomic_op <U> &op, T *result)
+{
+	// As with MPI, op's type only has to match T's size (e.g.
+	// replace<uint64_t> on a GlobalPtr-sized word).
+	static_assert(sizeof(T) == sizeof(U), "BCL fetch_and_op_sync(): op must act on T's size");
+	using D = gex_ad_type_<U>;
+	D dval, drv;
+	std::memcpy(&dval, val, sizeof(T));
+	gex_NBI_Wait(GEX_EC_ALL, 0);
+	void *dst_ptr = gasnet_resolve_address(dst);
+	gex_Event_Wait(shim_gex_AD_OpNB<D>(get_gex_ad<D>(), &drv, dst.rank, dst_ptr,
+	                                   op.op(), dval, dval, 0));
+	std::memcpy(result, &drv, sizeof(T));
+}
+
+template <typename T>
+inline void compare_and_swap_sync(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
+{
+	gex_NBI_Wait(GEX_EC_ALL, 0);
+	*result = word_atomic_impl_<T>::compare_swap(dst, *old_val, *new_val);
+}
+
+template <typename T>
+inline void compare_and_swap_async(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
+{
+	compare_and_swap_sync(dst, old_val, new_val, result);
+}
+
+// The other ranks apply op to a copy of dst_rank's values,
+// with all of a rank's ops in flight together.
+template <typename T, typename U>
+inline void reduce(const T *src_buf, T *dst_buf, const size_t &dst_rank, const atomic_op <U> &op, const size_t &size)
+{
+	static_assert(sizeof(T) == sizeof(U), "BCL reduce(): op must act on T's size");
+	using D = gex_ad_type_<U>;
+
+	GlobalPtr<T> acc = nullptr;
+	if (BCL::rank() == dst_rank)
+	{
+		acc = BCL::alloc<T>(size);
+		if (acc == nullptr)
+			throw std::runtime_error("BCL reduce(): not enough memory");
+		std::memcpy(acc.local(), src_buf, size*sizeof(T));
+	}
+	acc = BCL::broadcast(acc, dst_rank);
+
+	std::vector<D> vals(size);
+	std::vector<gex_Event_t> events(size);
+	if (BCL::rank() != dst_rank)
+	{
+		std::memcpy(vals.data(), src_buf, size*sizeof(T));
+		for (size_t i = 0; i < size; i++)
+			events[i] = shim_gex_AD_OpNB<D>(get_gex_ad<D>(), &vals[i], dst_rank,
+			                                gasnet_resolve_address(acc + i), op.op(), vals[i], vals[i], 0);
+		gex_Event_WaitAll(events.data(), size, 0);
+	}
+	BCL::barrier();
+
+	if (BCL::rank() == dst_rank)
+	{
+		for (size_t i = 0; i < size; i++)
+			events[i] = shim_gex_AD_OpNB<D>(get_gex_ad<D>(), &vals[i], dst_rank,
+			                                gasnet_resolve_address(acc + i), GEX_OP_GET, D(), D(), 0);
+		gex_Event_WaitAll(events.data(), size, 0);
+		std::memcpy(dst_buf, vals.data(), size*sizeof(T));
+		BCL::dealloc(acc);
+	}
+}
+
+template <typename T, typename U>
+inline void allreduce(const T *src_buf, T *dst_buf, const atomic_op <U> &op, const size_t &size)
+{
+	BCL::reduce(src_buf, dst_buf, 0, op, size);
+	for (size_t i = 0; i < size; i++)
+		dst_buf[i] = BCL::broadcast(dst_buf[i], 0);
+}
+
+/**/
+
 }
@@ -10,6 +10,13 @@ namespace BCL {
 extern gex_TM_t tm;
 gex_AD_t ad_i32;
 
+// Domains for the DDS primitives.  Every integral T is accessed
+// through the unsigned domain of its size, so that all atomics
+// on a word share one domain.
+gex_AD_t ad_u32;
+gex_AD_t ad_u64;
+gex_AD_t ad_dbl;
+
 template<typename T>
 constexpr gex_DT_t get_gex_dt();
 template<>
@@ -20,6 +27,17 @@ template<>
 constexpr gex_DT_t get_gex_dt<int64_t>() { return GEX_DT_I64; }
 template<>
 constexpr gex_DT_t get_gex_dt<uint64_t>() { return GEX_DT_U64; }
+template<>
+constexpr gex_DT_t get_gex_dt<double>() { return GEX_DT_DBL; }
+
+template<typename T>
+inline gex_AD_t get_gex_ad();
+template<>
+inline gex_AD_t get_gex_ad<uint32_t>() { return ad_u32; }
+template<>
+inline gex_AD_t get_gex_ad<uint64_t>() { return ad_u64; }
+template<>
+inline gex_AD_t get_gex_ad<double>() { return ad_dbl; }
 
 template<typename T>
 gex_Event_t shim_gex_AD_OpNB(
@@ -59,14 +77,33 @@ gex_Event_t shim_gex_AD_OpNB<uint64_t>(
   return gex_AD_OpNB_U64(ad, p, rank, addr, op, val1, val2, flags);
 }
 
+template<>
+gex_Event_t shim_gex_AD_OpNB<double>(
+    gex_AD_t ad, double *p, size_t rank, void *addr,
+    int op, double val1, double val2, int flags
+  ) {
+  return gex_AD_OpNB_DBL(ad, p, rank, addr, op, val1, val2, flags);
+}
+
 void init_atomics() {
   gex_OP_t ops = GEX_OP_FADD | GEX_OP_FCAS | GEX_OP_GET | GEX_OP_FXOR | GEX_OP_FOR | GEX_OP_FAND;
   gex_Flags_t flags = 0;
   gex_AD_Create(&ad_i32, tm, get_gex_dt<int32_t>(), ops, flags);
+
+  gex_OP_t word_ops = GEX_OP_GET | GEX_OP_SET | GEX_OP_SWAP | GEX_OP_FCAS |
+                      GEX_OP_FADD | GEX_OP_FXOR | GEX_OP_FOR | GEX_OP_FAND;
+  gex_AD_Create(&ad_u32, tm, get_gex_dt<uint32_t>(), word_ops, flags);
+  gex_AD_Create(&ad_u64, tm, get_gex_dt<uint64_t>(), word_ops, flags);
+
+  gex_OP_t dbl_ops = GEX_OP_GET | GEX_OP_SET | GEX_OP_FADD | GEX_OP_FMAX;
+  gex_AD_Create(&ad_dbl, tm, get_gex_dt<double>(), dbl_ops, flags);
 }
 
 void finalize_atomics() {
   gex_AD_Destroy(ad_i32);
+  gex_AD_Destroy(ad_u32);
+  gex_AD_Destroy(ad_u64);
+  gex_AD_Destroy(ad_dbl);
 }
 
 }
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <gasnet_ratomic.h>
+#include <bcl/core/GlobalPtr.hpp>
+
+namespace BCL {
+
+extern gex_AD_t ad_u32;
+extern gex_AD_t ad_u64;
+
+template <typename T>
+extern void* gasnet_resolve_address(const GlobalPtr<T> ptr);
+
+// Atomic fetch, set and compare-and-swap on any bytewise
+// copyable T (e.g. GlobalPtr), built from the U32 and U64
+// atomic domains.  T's of 4 or 8 bytes map to a single AD op.
+// Larger T's are handled one word at a time, with the words'
+// ops in flight together.  T's of 1 or 2 bytes (bool flags)
+// go through a CAS loop on their enclosing 4-byte word.
+
+template <size_t N>
+struct gex_word_;
+
+template <>
+struct gex_word_<4> {
+  using type = uint32_t;
+
+  static gex_Event_t op_nb(type* result, size_t rank, void* addr, gex_OP_t op,
+                           type val1, type val2) {
+    return gex_AD_OpNB_U32(ad_u32, result, rank, addr, op, val1, val2, 0);
+  }
+
+  static void op_nbi(size_t rank, void* addr, gex_OP_t op, type val1, type val2) {
+    gex_AD_OpNBI_U32(ad_u32, NULL, rank, addr, op, val1, val2, 0);
+  }
+};
+
+template <>
+struct gex_word_<8> {
+  using type = uint64_t;
+
+  static gex_Event_t op_nb(type* result, size_t rank, void* addr, gex_OP_t op,
+                           type val1, type val2) {
+    return gex_AD_OpNB_U64(ad_u64, result, rank, addr, op, val1, val2, 0);
+  }
+
+  static void op_nbi(size_t rank, void* addr, gex_OP_t op, type val1, type val2) {
+    gex_AD_OpNBI_U64(ad_u64, NULL, rank, addr, op, val1, val2, 0);
+  }
+};
+
+template <typename T>
+struct word_atomic_impl_ {
+  constexpr static bool small = sizeof(T) < 4;
+  constexpr static size_t word_size = (sizeof(T) % 8 == 0) ? 8 : 4;
+
+  static_assert(small ? (sizeof(T) == 1 || sizeof(T) == 2) : sizeof(T) % 4 == 0,
+                "BCL: GASNet-EX atomics need T of 1, 2 or a multiple of 4 bytes.");
+
+  using word = gex_word_<small ? 4 : word_size>;
+  using word_type = typename word::type;
+
+  constexpr static size_t n_words = small ? 1 : sizeof(T) / word_size;
+
+  // Enclosing word of a small T, and T's byte offset in it.
+  static char* enclosing_(const GlobalPtr<T>& ptr, size_t& offset) {
+    char* addr = reinterpret_cast<char*>(gasnet_resolve_address(ptr));
+    offset = reinterpret_cast<uintptr_t>(addr) % sizeof(word_type);
+    return addr - offset;
+  }
+
+  static T fetch(const GlobalPtr<T>& ptr) {
+    T rv;
+    if constexpr (small) {
+      size_t offset;
+      char* addr = enclosing_(ptr, offset);
+      word_type current;
+      gex_Event_Wait(word::op_nb(&current, ptr.rank, addr, GEX_OP_GET, 0, 0));
+      std::memcpy(&rv, reinterpret_cast<char*>(&current) + offset, sizeof(T));
+    } else {
+      word_type words[n_words];
+      gex_Event_t events[n_words];
+      word_type* addr = reinterpret_cast<word_type*>(gasnet_resolve_address(ptr));
+      for (size_t i = 0; i < n_words; i++) {
+        events[i] = word::op_nb(&words[i], ptr.rank, addr + i, GEX_OP_GET, 0, 0);
+      }
+      gex_Event_WaitAll(events, n_words, 0);
+      std::memcpy(&rv, words, sizeof(T));
+    }
+    return rv;
+  }
+
+  // Completes remotely only after the next gex_NBI_Wait()
+  // (BCL::flush()).
+  static void set(const GlobalPtr<T>& ptr, const T& val) {
+    if constexpr (small) {
+      T old_val = fetch(ptr);
+      T seen;
+      while (!equal_(seen = compare_swap(ptr, old_val, val), old_val)) {
+        old_val = seen;
+      }
+    } else {
+      word_type words[n_words];
+      std::memcpy(words, &val, sizeof(T));
+      word_type* addr = reinterpret_cast<word_type*>(gasnet_resolve_address(ptr));
+      for (size_t i = 0; i < n_words; i++) {
+        word::op_nbi(ptr.rank, addr + i, GEX_OP_SET, words[i], 0);
+      }
+    }
+  }
+
+  // T's of more than 8 bytes are not supported, as there is no
+  // wider AD op to swap them with.
+  static T compare_swap(const GlobalPtr<T>& ptr, const T& old_val, const T& new_val) {
+    static_assert(n_words == 1, "BCL: GASNet-EX compare-and-swap needs T of at most 8 bytes.");
+    if constexpr (small) {
+      size_t offset;
+      char* addr = enclosing_(ptr, offset);
+      word_type current;
+      gex_Event_Wait(word::op_nb(&current, ptr.rank, addr, GEX_OP_GET, 0, 0));
+      while (true) {
+        T seen;
+        std::memcpy(&seen, reinterpret_cast<char*>(&current) + offset, sizeof(T));
+        if (!equal_(seen, old_val)) {
+          return seen;
+        }
+        word_type desired = current;
+        std::memcpy(reinterpret_cast<char*>(&desired) + offset, &new_val, sizeof(T));
+        word_type prev;
+        gex_Event_Wait(word::op_nb(&prev, ptr.rank, addr, GEX_OP_FCAS, current, desired));
+        if (prev == current) {
+          return old_val;
+        }
+        current = prev;
+      }
+    } else {
+      word_type old_word, new_word, rv;
+      std::memcpy(&old_word, &old_val, sizeof(T));
+      std::memcpy(&new_word, &new_val, sizeof(T));
+      gex_Event_Wait(word::op_nb(&rv, ptr.rank, gasnet_resolve_address(ptr),
+                                 GEX_OP_FCAS, old_word, new_word));
+      T result;
+      std::memcpy(&result, &rv, sizeof(T));
+      return result;
+    }
+  }
+
+private:
+  static bool equal_(const T& a, const T& b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+  }
+};
+
+}
@@ -3,6 +3,7 @@
 #include <gasnetex.h>
 #include <gasnet_ratomic.h>
 #include <cassert>
+#include <algorithm>
 
 namespace BCL {
 
@@ -84,6 +85,11 @@ struct or_<int> : public abstract_or_<int>, public abstract_int, public atomic_o
   gex_OP_t op() const { return GEX_OP_FOR; }
 };
 
+template <>
+struct or_<uint64_t> : public abstract_or_<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
+  gex_OP_t op() const { return GEX_OP_FOR; }
+};
+
 template <typename T>
 struct abstract_and_: public virtual abstract_op<T>{};
 
@@ -98,6 +104,10 @@ struct and_<int> : public abstract_and_<int>, public abstract_int, public atomic
 template <typename T>
 struct abstract_plus : public virtual abstract_op <T> {
   gex_OP_t op() const { return GEX_OP_FADD; }
+
+  T operator()(const T& a, const T& b) const {
+    return a + b;
+  }
 };
 
 template <typename T> struct plus;
@@ -114,4 +124,49 @@ struct plus <float> : public abstract_plus <float>, public abstract_float {};
 template <>
 struct plus <double> : public abstract_plus <double>, public abstract_double {};
 
+/* Mine */
+
+template <typename T>
+struct abstract_replace : public virtual abstract_op<T> {
+  gex_OP_t op() const { return GEX_OP_SWAP; }
+};
+
+template <typename T> struct replace;
+
+template <>
+struct replace<uint64_t> : public abstract_replace<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {};
+
+template <typename T>
+struct abstract_max : public virtual abstract_op<T> {
+  gex_OP_t op() const { return GEX_OP_FMAX; }
+
+  T operator()(const T& a, const T& b) const {
+    return std::max(a, b);
+  }
+};
+
+template <typename T> struct max;
+
+template <>
+struct max<double> : public abstract_max<double>, public abstract_double, public atomic_op<double> {};
+
+template <typename T>
+struct abstract_sum : public virtual abstract_op<T> {
+  gex_OP_t op() const { return GEX_OP_FADD; }
+
+  T operator()(const T& a, const T& b) const {
+    return a + b;
+  }
+};
+
+template <typename T> struct sum;
+
+template <>
+struct sum<uint64_t> : public abstract_sum<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {};
+
+template <>
+struct sum<double> : public abstract_sum<double>, public abstract_double, public atomic_op<double> {};
+
+/**/
+
 }
@@ -44,14 +44,16 @@ inline void rwrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &si
 template <typename T>
 inline void awrite_sync(const T *src, const GlobalPtr<T> &dst, const size_t &size)
 {
-	MPI_Accumulate(src, size*sizeof(T), MPI_CHAR, dst.rank, dst.ptr, size*sizeof(T), MPI_CHAR, MPI_REPLACE, BCL::win);
+	const size_t count = size*get_mpi_atomic_type_impl_<T>::count;
+	MPI_Accumulate(src, count, get_mpi_atomic_type<T>(), dst.rank, dst.ptr, count, get_mpi_atomic_type<T>(), MPI_REPLACE, BCL::win);
 	MPI_Win_flush(dst.rank, BCL::win);
 }
 
 template <typename T>
 inline void awrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &size)
 {
-	MPI_Accumulate(src, size*sizeof(T), MPI_CHAR, dst.rank, dst.ptr, size*sizeof(T), MPI_CHAR, MPI_REPLACE, BCL::win);
+	const size_t count = size*get_mpi_atomic_type_impl_<T>::count;
+	MPI_Accumulate(src, count, get_mpi_atomic_type<T>(), dst.rank, dst.ptr, count, get_mpi_atomic_type<T>(), MPI_REPLACE, BCL::win);
 }
 
 template <typename T>
@@ -76,8 +78,9 @@ inline void aread_sync(const GlobalPtr <T> &src, T *dst, const size_t &size)
 {
 	T *origin_addr;
 
-	MPI_Get_accumulate(origin_addr, 0, MPI_CHAR, dst, size*sizeof(T), MPI_CHAR,
-				src.rank, src.ptr, size*sizeof(T), MPI_CHAR, MPI_NO_OP, BCL::win);
+	const size_t count = size*get_mpi_atomic_type_impl_<T>::count;
+	MPI_Get_accumulate(origin_addr, 0, get_mpi_atomic_type<T>(), dst, count, get_mpi_atomic_type<T>(),
+				src.rank, src.ptr, count, get_mpi_atomic_type<T>(), MPI_NO_OP, BCL::win);
 	MPI_Win_flush(src.rank, BCL::win);
 }
 
@@ -86,8 +89,9 @@ inline void aread_async(const GlobalPtr <T> &src, T *dst, const size_t &size)
 {
 	T *origin_addr;
 
-	MPI_Get_accumulate(origin_addr, 0, MPI_CHAR, dst, size*sizeof(T), MPI_CHAR,
-				src.rank, src.ptr, size*sizeof(T), MPI_CHAR, MPI_NO_OP, BCL::win);
+	const size_t count = size*get_mpi_atomic_type_impl_<T>::count;
+	MPI_Get_accumulate(origin_addr, 0, get_mpi_atomic_type<T>(), dst, count, get_mpi_atomic_type<T>(),
+				src.rank, src.ptr, count, get_mpi_atomic_type<T>(), MPI_NO_OP, BCL::win);
 }
 
 template <typename T, typename U>
@@ -100,28 +104,27 @@ inline void fetch_and_op_sync(const GlobalPtr<T> &dst, const T *val, const atomi
 template <typename T>
 inline void compare_and_swap_sync(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
 {
-	MPI_Datatype datatype;
-
-	if (sizeof(T) == 8)
-		datatype = MPI_UINT64_T;
-	else if (sizeof(T) == 4)
-		datatype = MPI_UINT32_T;
-	else if (sizeof(T) == 1)
-	{
-        	if (typeid(T) == typeid(bool))
-                	datatype = MPI_C_BOOL;
-		else if (typeid(T) == typeid(uint8_t))
-			datatype = MPI_UINT8_T;
-		else
-			printf("ERROR: The datatype not found!\n");
-	}
-	else
-		printf("ERROR: The datatype not found!\n");
-
-	MPI_Compare_and_swap(new_val, old_val, result, datatype, dst.rank, dst.ptr, BCL::win);
+	static_assert(get_mpi_atomic_type_impl_<T>::count == 1,
+	              "BCL compare_and_swap_sync(): T must be of 1, 2, 4 or 8 bytes");
+	MPI_Compare_and_swap(new_val, old_val, result, get_mpi_atomic_type<T>(), dst.rank, dst.ptr, BCL::win);
 	MPI_Win_flush(dst.rank, BCL::win);
 }
 
+// The buffers must stay valid, and result is undefined,
+// until flush(dst.rank) returns.
+template <typename T>
+inline void compare_and_swap_async(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
+{
+	static_assert(get_mpi_atomic_type_impl_<T>::count == 1,
+	              "BCL compare_and_swap_async(): T must be of 1, 2, 4 or 8 bytes");
+	MPI_Compare_and_swap(new_val, old_val, result, get_mpi_atomic_type<T>(), dst.rank, dst.ptr, BCL::win);
+}
+
+inline void flush(const uint64_t &rank)
+{
+	MPI_Win_flush(rank, BCL::win);
+}
+
 template <typename T, typename U>
 inline void reduce(const T *src_buf, T *dst_buf, const size_t &dst_rank, const atomic_op <U> &op, const size_t &size)
 {
@@ -575,6 +578,45 @@ inline BCL::future<T> arfetch_and_op(const GlobalPtr<T> ptr, const T& val, const
   return std::move(future);
 }
 
+// Apply op elementwise to size T's at dst without fetching
+// the old values.  src must stay valid until the request
+// completes.
+template <typename T>
+inline BCL::request async_accumulate(const T* src, const GlobalPtr<T>& dst,
+                                     size_t size, const atomic_op<T>& op) {
+  MPI_Request request;
+
+  int error_code = MPI_Raccumulate(src, size, op.type(),
+                                   dst.rank, dst.ptr, size, op.type(),
+                                   op.op(), BCL::win, &request);
+  BCL_DEBUG(
+          if (error_code != MPI_SUCCESS) {
+            throw debug_error("BCL async_accumulate(): MPI_Raccumulate return error code " + std::to_string(error_code));
+          }
+  )
+  return BCL::request(request);
+}
+
+// Apply op elementwise to size T's at dst, fetching the
+// old values into result.  The whole range is updated
+// by a single RMA operation.
+template <typename T>
+inline BCL::request async_fetch_and_op(const T* src, T* result, const GlobalPtr<T>& dst,
+                                       size_t size, const atomic_op<T>& op) {
+  MPI_Request request;
+
+  int error_code = MPI_Rget_accumulate(src, size, op.type(),
+                                       result, size, op.type(),
+                                       dst.rank, dst.ptr, size, op.type(),
+                                       op.op(), BCL::win, &request);
+  BCL_DEBUG(
+          if (error_code != MPI_SUCCESS) {
+            throw debug_error("BCL async_fetch_and_op(): MPI_Rget_accumulate return error code " + std::to_string(error_code));
+          }
+  )
+  return BCL::request(request);
+}
+
 // MPI one-sided is basically terrible :/
 // TODO: beter CAS syntax
 inline int int_compare_and_swap(const GlobalPtr <int> ptr, const int old_val,
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <mpi.h>
+#include <cstdint>
+#include <cstddef>
 
 namespace BCL {
 
@@ -92,4 +94,53 @@ MPI_Datatype get_mpi_type() {
   return get_mpi_type_impl_<T>::mpi_type();
 }
 
+// The datatype MPI atomics move a T in: bool as MPI_C_BOOL, any
+// other T as the widest unsigned integers that tile it (e.g. a
+// GlobalPtr as one MPI_UINT64_T).  Unlike MPI_CHAR, single
+// 4- and 8-byte integers can be executed by the network.
+
+template <size_t N>
+struct get_mpi_uint_impl_;
+
+template <>
+struct get_mpi_uint_impl_<1> {
+  static MPI_Datatype mpi_type() { return MPI_UINT8_T; }
+};
+
+template <>
+struct get_mpi_uint_impl_<2> {
+  static MPI_Datatype mpi_type() { return MPI_UINT16_T; }
+};
+
+template <>
+struct get_mpi_uint_impl_<4> {
+  static MPI_Datatype mpi_type() { return MPI_UINT32_T; }
+};
+
+template <>
+struct get_mpi_uint_impl_<8> {
+  static MPI_Datatype mpi_type() { return MPI_UINT64_T; }
+};
+
+template <typename T>
+struct get_mpi_atomic_type_impl_ {
+  static constexpr size_t word_size = (sizeof(T) % 8 == 0) ? 8 :
+                                      (sizeof(T) % 4 == 0) ? 4 :
+                                      (sizeof(T) % 2 == 0) ? 2 : 1;
+  // Number of datatype elements per T.
+  static constexpr size_t count = sizeof(T) / word_size;
+  static MPI_Datatype mpi_type() { return get_mpi_uint_impl_<word_size>::mpi_type(); }
+};
+
+template <>
+struct get_mpi_atomic_type_impl_<bool> {
+  static constexpr size_t count = 1;
+  static MPI_Datatype mpi_type() { return MPI_C_BOOL; }
+};
+
+template <typename T>
+MPI_Datatype get_mpi_atomic_type() {
+  return get_mpi_atomic_type_impl_<T>::mpi_type();
+}
+
 }
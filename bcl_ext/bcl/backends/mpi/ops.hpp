@@ -41,6 +41,11 @@ namespace BCL {
     MPI_Op op() const { return MPI_BOR; }
   };
 
+  template <>
+  struct or_<uint64_t> : public abstract_or_<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
+    MPI_Op op() const { return MPI_BOR; }
+  };
+
   template <typename T>
   struct abstract_xor_: public virtual abstract_op<T>{};
 
@@ -41,6 +41,11 @@ inline void flush() {
   shmem_quiet();
 }
 
+// SHMEM has no per-PE quiet.
+inline void flush(const uint64_t &rank) {
+  shmem_quiet();
+}
+
 // MPI communicator, shared_segment_size in MB,
 // and whether to start the progress thread.
 inline void init(uint64_t shared_segment_size = 256, bool thread_safe = false) {
@@ -8,6 +8,7 @@
 #include "ops.hpp"
 #include "atomics.hpp"
 #include "request.hpp"
+#include "detail/word_atomic_impl.hpp"
 
 namespace BCL {
 
@@ -61,6 +62,20 @@ inline void write(const T *src, const GlobalPtr <T> &dst, const size_t size) {
   }
 }
 
+// Write size T's from src -> dst
+// Returns after src buffer is sent
+// and okay to be modified.
+template <typename T>
+inline void atomic_write(const T *src, const GlobalPtr <T> &dst, const size_t size) {
+  BCL_DEBUG(
+    if (dst.rank > BCL::backend::nprocs()) {
+      throw debug_error("atomic_write(): request to write to rank "
+                        + std::to_string(dst.rank) + ", which does not exist");
+    }
+  )
+  shmem_putmem(dst.rptr(), src, sizeof(T)*size, dst.rank);
+}
+
 template <typename T>
 inline BCL::request async_read(const GlobalPtr<T>& src, T* dst, size_t size) {
   shmem_getmem_nbi(dst, src.rptr(), sizeof(T)*size, src.rank);
@@ -140,6 +155,26 @@ T fetch_and_op(const GlobalPtr <T> ptr, const T &val, const atomic_op <T> &op) {
   return op.shmem_atomic_op(ptr, val);
 }
 
+// SHMEM has no vector AMOs, so these issue one AMO per
+// element.  They complete before returning.
+template <typename T>
+inline BCL::request async_accumulate(const T* src, const GlobalPtr<T>& dst,
+                                     size_t size, const atomic_op<T>& op) {
+  for (size_t i = 0; i < size; i++) {
+    op.shmem_atomic_op(dst + i, src[i]);
+  }
+  return BCL::request();
+}
+
+template <typename T>
+inline BCL::request async_fetch_and_op(const T* src, T* result, const GlobalPtr<T>& dst,
+                                       size_t size, const atomic_op<T>& op) {
+  for (size_t i = 0; i < size; i++) {
+    result[i] = op.shmem_atomic_op(dst + i, src[i]);
+  }
+  return BCL::request();
+}
+
 int int_compare_and_swap(const GlobalPtr <int> ptr, int old_val,
   const int new_val) {
   old_val = shmem_int_cswap(ptr.rptr(), old_val, new_val, ptr.rank);
@@ -168,4 +203,152 @@ uint64_t uint64_atomic_fetch_or(const GlobalPtr <uint64_t> ptr, uint64_t val) {
 }
 */
 
+/* Mine */
+
+// The DDS primitive set.  Plain reads and writes to a PE on this
+// node go through shmem_ptr() as loads and stores.  Atomic ones
+// always use AMOs, which the NIC may execute, so they never mix
+// with CPU atomics on the same words.  SHMEM 1.4 has no
+// non-blocking fetching AMOs, so the *_async atomic variants
+// complete before returning.
+
+template <typename T>
+inline void lwrite(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	std::memcpy(dst.local(), src, size*sizeof(T));
+}
+
+template <typename T>
+inline void rwrite_sync(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	void *ptr = shmem_ptr(dst.rptr(), dst.rank);
+	if (ptr != nullptr)
+		std::memcpy(ptr, src, size*sizeof(T));
+	else
+	{
+		shmem_putmem(dst.rptr(), src, size*sizeof(T), dst.rank);
+		shmem_quiet();
+	}
+}
+
+template <typename T>
+inline void rwrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	shmem_putmem_nbi(dst.rptr(), src, size*sizeof(T), dst.rank);
+}
+
+template <typename T>
+inline void awrite_sync(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		word_atomic_impl_<T>::set(dst + i, src[i]);
+	shmem_quiet();
+}
+
+template <typename T>
+inline void awrite_async(const T *src, const GlobalPtr<T> &dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		word_atomic_impl_<T>::set(dst + i, src[i]);
+}
+
+template <typename T>
+inline void lread(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	std::memcpy(dst, src.local(), size*sizeof(T));
+}
+
+template <typename T>
+inline void rread_sync(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	const void *ptr = shmem_ptr(src.rptr(), src.rank);
+	if (ptr != nullptr)
+		std::memcpy(dst, ptr, size*sizeof(T));
+	else
+		shmem_getmem(dst, src.rptr(), size*sizeof(T), src.rank);
+}
+
+template <typename T>
+inline void rread_async(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	shmem_getmem_nbi(dst, src.rptr(), size*sizeof(T), src.rank);
+}
+
+template <typename T>
+inline void aread_sync(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	for (size_t i = 0; i < size; i++)
+		dst[i] = word_atomic_impl_<T>::fetch(src + i);
+}
+
+template <typename T>
+inline void aread_async(const GlobalPtr <T> &src, T *dst, const size_t &size)
+{
+	aread_sync(src, dst, size);
+}
+
+template <typename T, typename U>
+inline void fetch_and_op_sync(const GlobalPtr<T> &dst, const T *val, const atomic_op <U> &op, T *result)
+{
+	// As with MPI, op's type only has to match T's size (e.g.
+	// replace<uint64_t> on a GlobalPtr-sized word).
+	static_assert(sizeof(T) == sizeof(U), "BCL fetch_and_op_sync(): op must act on T's size");
+	U uval, urv;
+	std::memcpy(&uval, val, sizeof(T));
+	urv = op.shmem_atomic_op(reinterpret_pointer_cast<U>(dst), uval);
+	std::memcpy(result, &urv, sizeof(T));
+}
+
+template <typename T>
+inline void compare_and_swap_sync(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
+{
+	*result = word_atomic_impl_<T>::compare_swap(dst, *old_val, *new_val);
+}
+
+template <typename T>
+inline void compare_and_swap_async(const GlobalPtr<T> &dst, const T *old_val, const T *new_val, T *result)
+{
+	compare_and_swap_sync(dst, old_val, new_val, result);
+}
+
+// The other PEs apply op to a copy of dst_rank's values.
+template <typename T, typename U>
+inline void reduce(const T *src_buf, T *dst_buf, const size_t &dst_rank, const atomic_op <U> &op, const size_t &size)
+{
+	GlobalPtr<T> acc = nullptr;
+	if (BCL::rank() == dst_rank)
+	{
+		acc = BCL::alloc<T>(size);
+		if (acc == nullptr)
+			throw std::runtime_error("BCL reduce(): not enough memory");
+		std::memcpy(acc.local(), src_buf, size*sizeof(T));
+	}
+	acc = BCL::broadcast(acc, dst_rank);
+
+	if (BCL::rank() != dst_rank)
+	{
+		for (size_t i = 0; i < size; i++)
+			op.shmem_atomic_op(acc + i, src_buf[i]);
+		shmem_quiet();
+	}
+	shmem_barrier_all();
+
+	if (BCL::rank() == dst_rank)
+	{
+		for (size_t i = 0; i < size; i++)
+			dst_buf[i] = word_atomic_impl_<T>::fetch(acc + i);
+		BCL::dealloc(acc);
+	}
+}
+
+template <typename T, typename U>
+inline void allreduce(const T *src_buf, T *dst_buf, const atomic_op <U> &op, const size_t &size)
+{
+	BCL::reduce(src_buf, dst_buf, 0, op, size);
+	for (size_t i = 0; i < size; i++)
+		dst_buf[i] = BCL::broadcast(dst_buf[i], 0);
+}
+
+/**/
+
 } // end BCL
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <mpp/shmem.h>
+#include <bcl/core/GlobalPtr.hpp>
+
+namespace BCL {
+
+// Atomic fetch, set and compare-and-swap on any bytewise
+// copyable T (e.g. GlobalPtr), built from the 4- and 8-byte
+// AMOs every SHMEM offers.  T's of 4 or 8 bytes map to a single AMO.  Larger
+// T's are handled one word at a time, which is as atomic as
+// MPI's byte-wise accumulates.  T's of 1 or 2 bytes (bool
+// flags) go through a CAS loop on their enclosing 4-byte word.
+
+template <size_t N>
+struct shmem_word_;
+
+template <>
+struct shmem_word_<4> {
+  using type = unsigned int;
+
+  static type fetch(const type* addr, int pe) {
+    return shmem_uint_atomic_fetch(addr, pe);
+  }
+
+  static void set(type* addr, type val, int pe) {
+    shmem_uint_atomic_set(addr, val, pe);
+  }
+
+  static type compare_swap(type* addr, type old_val, type new_val, int pe) {
+    return shmem_uint_atomic_compare_swap(addr, old_val, new_val, pe);
+  }
+};
+
+template <>
+struct shmem_word_<8> {
+  static_assert(sizeof(unsigned long) == 8,
+                "BCL: SHMEM backend expects an LP64 platform.");
+
+  using type = unsigned long;
+
+  static type fetch(const type* addr, int pe) {
+    return shmem_ulong_atomic_fetch(addr, pe);
+  }
+
+  static void set(type* addr, type val, int pe) {
+    shmem_ulong_atomic_set(addr, val, pe);
+  }
+
+  static type compare_swap(type* addr, type old_val, type new_val, int pe) {
+    return shmem_ulong_atomic_compare_swap(addr, old_val, new_val, pe);
+  }
+};
+
+template <typename T>
+struct word_atomic_impl_ {
+  constexpr static bool small = sizeof(T) < 4;
+  constexpr static size_t word_size = (sizeof(T) % 8 == 0) ? 8 : 4;
+
+  static_assert(small ? (sizeof(T) == 1 || sizeof(T) == 2) : sizeof(T) % 4 == 0,
+                "BCL: SHMEM atomics need T of 1, 2 or a multiple of 4 bytes.");
+
+  using word = shmem_word_<small ? 4 : word_size>;
+  using word_type = typename word::type;
+
+  constexpr static size_t n_words = small ? 1 : sizeof(T) / word_size;
+
+  // Enclosing word of a small T, and T's byte offset in it.
+  static word_type* enclosing_(const GlobalPtr<T>& ptr, size_t& offset) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(ptr.rptr());
+    offset = addr % sizeof(word_type);
+    return reinterpret_cast<word_type*>(addr - offset);
+  }
+
+  static T fetch(const GlobalPtr<T>& ptr) {
+    T rv;
+    if constexpr (small) {
+      size_t offset;
+      word_type* addr = enclosing_(ptr, offset);
+      word_type current = word::fetch(addr, ptr.rank);
+      std::memcpy(&rv, reinterpret_cast<char*>(&current) + offset, sizeof(T));
+    } else {
+      word_type words[n_words];
+      word_type* addr = reinterpret_cast<word_type*>(ptr.rptr());
+      for (size_t i = 0; i < n_words; i++) {
+        words[i] = word::fetch(addr + i, ptr.rank);
+      }
+      std::memcpy(&rv, words, sizeof(T));
+    }
+    return rv;
+  }
+
+  // Completes remotely only after the next shmem_quiet().
+  static void set(const GlobalPtr<T>& ptr, const T& val) {
+    if constexpr (small) {
+      T old_val = fetch(ptr);
+      T seen;
+      while (!equal_(seen = compare_swap(ptr, old_val, val), old_val)) {
+        old_val = seen;
+      }
+    } else {
+      word_type words[n_words];
+      std::memcpy(words, &val, sizeof(T));
+      word_type* addr = reinterpret_cast<word_type*>(ptr.rptr());
+      for (size_t i = 0; i < n_words; i++) {
+        word::set(addr + i, words[i], ptr.rank);
+      }
+    }
+  }
+
+  // T's of more than 8 bytes are not supported, as there is no
+  // wider AMO to swap them with.
+  static T compare_swap(const GlobalPtr<T>& ptr, const T& old_val, const T& new_val) {
+    static_assert(n_words == 1, "BCL: SHMEM compare-and-swap needs T of at most 8 bytes.");
+    if constexpr (small) {
+      size_t offset;
+      word_type* addr = enclosing_(ptr, offset);
+      word_type current = word::fetch(addr, ptr.rank);
+      while (true) {
+        T seen;
+        std::memcpy(&seen, reinterpret_cast<char*>(&current) + offset, sizeof(T));
+        if (!equal_(seen, old_val)) {
+          return seen;
+        }
+        word_type desired = current;
+        std::memcpy(reinterpret_cast<char*>(&desired) + offset, &new_val, sizeof(T));
+        word_type prev = word::compare_swap(addr, current, desired, ptr.rank);
+        if (prev == current) {
+          return old_val;
+        }
+        current = prev;
+      }
+    } else {
+      word_type old_word, new_word;
+      std::memcpy(&old_word, &old_val, sizeof(T));
+      std::memcpy(&new_word, &new_val, sizeof(T));
+      word_type rv = word::compare_swap(reinterpret_cast<word_type*>(ptr.rptr()),
+                                        old_word, new_word, ptr.rank);
+      T result;
+      std::memcpy(&result, &rv, sizeof(T));
+      return result;
+    }
+  }
+
+private:
+  static bool equal_(const T& a, const T& b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+  }
+};
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+#include <algorithm>
 #include <mpp/shmem.h>
 
 namespace BCL {
@@ -31,7 +33,7 @@ namespace BCL {
   template <>
   struct swap<uint64_t> : public abstract_swap<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
     uint64_t shmem_atomic_op(const GlobalPtr<uint64_t> ptr, const uint64_t& val) const {
-      return shmem_uint64_atomic_swap(ptr.rptr(), val, ptr.rank);
+      return shmem_ulong_atomic_swap(ptr.rptr(), val, ptr.rank);
     }
   };
 
@@ -66,6 +68,13 @@ namespace BCL {
     }
   };
 
+  template <>
+  struct or_<uint64_t> : public abstract_or_<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
+    uint64_t shmem_atomic_op(const GlobalPtr<uint64_t> ptr, const uint64_t& val) const {
+      return shmem_uint64_atomic_fetch_or(ptr.rptr(), val, ptr.rank);
+    }
+  };
+
   template <typename T>
   struct abstract_and_: public virtual abstract_op<T>{};
 
@@ -80,12 +89,20 @@ namespace BCL {
 
   // Define the plus operation
   template <typename T>
-  struct abstract_plus : public virtual abstract_op <T> {};
+  struct abstract_plus : public virtual abstract_op <T> {
+    T operator()(const T &a, const T &b) const {
+      return a + b;
+    }
+  };
 
   template <typename T> struct plus;
 
   template <>
-  struct plus <uint64_t> : public abstract_plus <uint64_t>, public abstract_uint64_t {};
+  struct plus <uint64_t> : public abstract_plus <uint64_t>, public abstract_uint64_t, public atomic_op <uint64_t> {
+    uint64_t shmem_atomic_op(const GlobalPtr <uint64_t> ptr, const uint64_t &val) const {
+      return shmem_ulong_atomic_fetch_add(ptr.rptr(), val, ptr.rank);
+    }
+  };
 
   template <>
   struct plus <int> : public abstract_plus <int>, public abstract_int, public atomic_op <int> {
@@ -106,6 +123,9 @@ namespace BCL {
 
   template <typename T>
   struct abstract_max : public virtual abstract_op <T> {
+    T operator()(const T &a, const T &b) const {
+      return std::max(a, b);
+    }
   };
 
   template <typename T> struct land;
@@ -116,4 +136,70 @@ namespace BCL {
 
   template <>
   struct max <int> : public abstract_max <int>, public abstract_int {};
+
+  // SHMEM has no floating-point AMOs, so the double ops CAS on
+  // the bits.  Returns the old value.
+  template <typename Fn>
+  inline double shmem_double_cas_op_(const GlobalPtr <double> ptr, const double &val, Fn fn) {
+    unsigned long *addr = reinterpret_cast <unsigned long *> (ptr.rptr());
+    unsigned long current = shmem_ulong_atomic_fetch(addr, ptr.rank);
+    while (true) {
+      double seen;
+      std::memcpy(&seen, &current, sizeof(double));
+      double desired_val = fn(seen, val);
+      unsigned long desired;
+      std::memcpy(&desired, &desired_val, sizeof(double));
+      unsigned long prev = shmem_ulong_atomic_compare_swap(addr, current, desired, ptr.rank);
+      if (prev == current) {
+        return seen;
+      }
+      current = prev;
+    }
+  }
+
+  template <>
+  struct max <double> : public abstract_max <double>, public abstract_double, public atomic_op <double> {
+    double shmem_atomic_op(const GlobalPtr <double> ptr, const double &val) const {
+      return shmem_double_cas_op_(ptr, val, *this);
+    }
+  };
+
+  /* Mine */
+
+  template <typename T>
+  struct abstract_replace : public virtual abstract_op<T> {};
+
+  template <typename T>
+  struct replace;
+
+  template <>
+  struct replace<uint64_t> : public abstract_replace<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
+    uint64_t shmem_atomic_op(const GlobalPtr<uint64_t> ptr, const uint64_t& val) const {
+      return shmem_ulong_atomic_swap(ptr.rptr(), val, ptr.rank);
+    }
+  };
+
+  template <typename T>
+  struct abstract_sum : public virtual abstract_op<T> {
+    T operator()(const T& a, const T& b) const {
+      return a + b;
+    }
+  };
+
+  template <typename T>
+  struct sum;
+
+  template <>
+  struct sum<uint64_t> : public abstract_sum<uint64_t>, public abstract_uint64_t, public atomic_op<uint64_t> {
+    uint64_t shmem_atomic_op(const GlobalPtr<uint64_t> ptr, const uint64_t& val) const {
+      return shmem_ulong_atomic_fetch_add(ptr.rptr(), val, ptr.rank);
+    }
+  };
+
+  template <>
+  struct sum<double> : public abstract_sum<double>, public abstract_double, public atomic_op<double> {
+    double shmem_atomic_op(const GlobalPtr<double> ptr, const double& val) const {
+      return shmem_double_cas_op_(ptr, val, *this);
+    }
+  };
 }
@@ -2,33 +2,50 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstdint>
 #include <cmath>
 
-#include <set>
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  #include <immintrin.h>
+#endif
 
 #include <bcl/bcl.hpp>
 
 namespace BCL {
+  // A blocked Bloom filter.  Each element maps to a single
+  // 512-bit (cache line) block, and sets at most one bit in each
+  // of k of the block's sixteen 32-bit lanes.  An insert or find
+  // therefore touches exactly one block, which is updated with a
+  // single remote accumulate.
   template <typename T>
   struct BloomFilter {
+    static constexpr size_t block_bits = 512;
+    static constexpr size_t words_per_block = block_bits / (8*sizeof(uint64_t));
+    static constexpr size_t lanes_per_block = block_bits / (8*sizeof(uint32_t));
+
+    using block_type = std::array<uint64_t, words_per_block>;
+
     std::vector <BCL::GlobalPtr <uint64_t>> data;
+    // Number of blocks, total and per rank.
     size_t num_buckets;
     size_t local_size;
 
-    // "Number of hash functions"
+    // "Number of hash functions," i.e. lanes set per element.
     size_t k = 0;
 
     std::hash <T> hash_fn;
 
-    // TODO: Better hash function
-    uint64_t hash(uint64_t key) {
-      key = (~key) + (key << 21); // key = (key << 21) - key - 1;
-      key = key ^ (key >> 24);
-      key = (key + (key << 3)) + (key << 8); // key * 265
-      key = key ^ (key >> 14);
-      key = (key + (key << 2)) + (key << 4); // key * 21
-      key = key ^ (key >> 28);
-      key = key + (key << 31);
+    // 64-bit finalizer from MurmurHash3.
+    uint64_t hash(uint64_t key) const {
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= key >> 33;
+      key *= 0xc4ceb9fe1a85ec53ULL;
+      key ^= key >> 33;
       return key;
     }
 
@@ -37,37 +54,27 @@ namespace BCL {
     // n - expected size of data
     // p - desired false positive rate
     BloomFilter(size_t n, double p = 0.01) {
-      double bits_per_elem = -log2(p) / log(2);
-      double elems_per_bucket = (8*sizeof(uint64_t)) / bits_per_elem;
-      elems_per_bucket /= -log(p);
-      num_buckets = (n / elems_per_bucket) + 0.5;
+      double bits_per_elem = -log(p) / (log(2)*log(2));
 
       k = (- (log(p) / log(2))) + 0.5;
+      k = std::max<size_t>(1, std::min(k, lanes_per_block));
 
-      if (k < 1) {
-        k = 1;
-      }
-
-      /*
-      BCL::print("%d uniue elements, %lf bits per elem, %lf elems per 64-bit bucket, %d buckets, %d bits total, %lf (%d) hash fns\n",
-        n, bits_per_elem, elems_per_bucket, num_buckets, num_buckets*8*sizeof(uint64_t), (-(log(p) / log(2))), k);
-      */
+      num_buckets = (n*bits_per_elem + block_bits - 1) / block_bits;
+      num_buckets = std::max<size_t>(num_buckets, 1);
 
       local_size = (num_buckets + BCL::nprocs() - 1) / BCL::nprocs();
 
       num_buckets = local_size * BCL::nprocs();
 
-      /*
-      BCL::print("local buckets %d, num_buckets now %d\n", local_size, num_buckets);
-      */
-
       data.resize(BCL::nprocs(), nullptr);
-      for (int rank = 0; rank < BCL::nprocs(); rank++) {
+      for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
         if (BCL::rank() == rank) {
-          data[rank] = BCL::alloc <uint64_t> (local_size);
+          data[rank] = BCL::alloc <uint64_t> (local_size*words_per_block);
 
-          for (int i = 0; i < local_size; i++) {
-            data[rank].local()[i] = 0x0;
+          if (data[rank] != nullptr) {
+            for (size_t i = 0; i < local_size*words_per_block; i++) {
+              data[rank].local()[i] = 0x0;
+            }
           }
         }
         data[rank] = BCL::broadcast(data[rank], rank);
@@ -86,52 +93,99 @@ namespace BCL {
     }
 
     bool insert(const T &val) {
-      size_t my_hash = hash(hash_fn(val));
-      size_t my_filter = my_hash % num_buckets;
+      block_type mask;
+      BCL::GlobalPtr<uint64_t> block = locate_(val, mask);
 
-      uint64_t my_bits = 0x0;
+      block_type old_block;
+      BCL::async_fetch_and_op(mask.data(), old_block.data(), block,
+                              words_per_block, BCL::or_<uint64_t>{}).wait();
 
-      for (int i = 0; i < k; i++) {
-        my_hash = hash(my_hash);
-        int my_bit = my_hash % (8*sizeof(uint64_t));
-        my_bits |= 0x1 << my_bit;
-      }
+      return contains_(old_block, mask);
+    }
 
-      size_t node = my_filter / local_size;
-      size_t node_slot = my_filter - node*local_size;
+    bool find(const T &val) {
+      block_type mask;
+      BCL::GlobalPtr<uint64_t> block = locate_(val, mask);
 
-      uint64_t old_filter = BCL::uint64_atomic_fetch_or(data[node] + node_slot, my_bits);
+      block_type filter;
+      BCL::rget(block, filter.data(), words_per_block);
 
-      return ((old_filter & my_bits) == my_bits);
+      return contains_(filter, mask);
     }
 
-    bool find(const T &val) {
-      size_t my_hash = hash(hash_fn(val));
-      size_t my_filter = my_hash % num_buckets;
+    // Insert a batch of values.  Masks falling into the same
+    // block are combined locally, so each distinct block
+    // costs one remote accumulate.
+    void insert_many(const std::vector<T> &vals) {
+      std::vector<std::unordered_map<size_t, block_type>> blocks(data.size());
+
+      for (const T &val : vals) {
+        block_type mask;
+        size_t block = block_idx_(val, mask);
+        size_t node = block / local_size;
+
+        auto result = blocks[node].emplace(block - node*local_size, mask);
+        if (!result.second) {
+          for (size_t i = 0; i < words_per_block; i++) {
+            result.first->second[i] |= mask[i];
+          }
+        }
+      }
 
-      uint64_t my_bits = 0x0;
+      std::vector<BCL::request> requests;
+      for (size_t node = 0; node < blocks.size(); node++) {
+        for (auto &block : blocks[node]) {
+          requests.push_back(BCL::async_accumulate(block.second.data(),
+                                                   data[node] + block.first*words_per_block,
+                                                   words_per_block, BCL::or_<uint64_t>{}));
+        }
+      }
 
-      for (int i = 0; i < k; i++) {
-        my_hash = hash(my_hash);
-        int my_bit = my_hash % (8*sizeof(uint64_t));
-        my_bits |= 0x1 << my_bit;
+      for (auto &request : requests) {
+        request.wait();
       }
+    }
 
-      size_t node = my_filter / local_size;
-      size_t node_slot = my_filter - node*local_size;
+    // Look up a batch of values.  Each distinct block is
+    // fetched once.
+    std::vector<bool> find_many(const std::vector<T> &vals) {
+      std::vector<block_type> masks(vals.size());
+      std::vector<size_t> idx(vals.size());
+      std::unordered_map<size_t, size_t> slots;
 
-      uint64_t filter = BCL::rget(data[node] + node_slot);
+      for (size_t i = 0; i < vals.size(); i++) {
+        size_t block = block_idx_(vals[i], masks[i]);
+        idx[i] = slots.emplace(block, slots.size()).first->second;
+      }
 
-      return ((filter & my_bits) == my_bits);
+      std::vector<block_type> filters(slots.size());
+      std::vector<BCL::request> requests;
+      for (auto &slot : slots) {
+        size_t node = slot.first / local_size;
+        size_t node_slot = slot.first - node*local_size;
+        requests.push_back(BCL::arget(data[node] + node_slot*words_per_block,
+                                      filters[slot.second].data(), words_per_block));
+      }
+
+      for (auto &request : requests) {
+        request.wait();
+      }
+
+      std::vector<bool> found(vals.size());
+      for (size_t i = 0; i < vals.size(); i++) {
+        found[i] = contains_(filters[idx[i]], masks[i]);
+      }
+      return found;
     }
 
     BloomFilter(const BloomFilter &bloom_filter) = delete;
 
-    operator=(BloomFilter &&bloom_filter) {
+    BloomFilter &operator=(BloomFilter &&bloom_filter) {
       this->data = std::move(bloom_filter.data);
       this->num_buckets = bloom_filter.num_buckets;
       this->local_size = bloom_filter.local_size;
       this->k = bloom_filter.k;
+      return *this;
     }
 
     BloomFilter(BloomFilter &&bloom_filter) {
@@ -140,5 +194,77 @@ namespace BCL {
       this->local_size = bloom_filter.local_size;
       this->k = bloom_filter.k;
     }
+
+  private:
+    // Global block index for val; fills in the bits val sets.
+    size_t block_idx_(const T &val, block_type &mask) const {
+      uint64_t my_hash = hash(hash_fn(val));
+      uint64_t lane_hash = hash(my_hash);
+      make_mask_(lane_hash, mask);
+      return my_hash % num_buckets;
+    }
+
+    BCL::GlobalPtr<uint64_t> locate_(const T &val, block_type &mask) const {
+      size_t block = block_idx_(val, mask);
+      size_t node = block / local_size;
+      size_t node_slot = block - node*local_size;
+      return data[node] + node_slot*words_per_block;
+    }
+
+    static bool contains_(const block_type &filter, const block_type &mask) {
+      uint64_t missing = 0x0;
+      for (size_t i = 0; i < words_per_block; i++) {
+        missing |= mask[i] & ~filter[i];
+      }
+      return missing == 0x0;
+    }
+
+    // Lane i gets bit (h * salt[i]) >> 27.  Only the k lanes
+    // starting at lane (hash >> 60) are enabled, so every lane
+    // sees use even when k < 16.
+    void make_mask_(uint64_t lane_hash, block_type &mask) const {
+      alignas(64) static const uint32_t salt[lanes_per_block] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+        0x9e3779b1U, 0x85ebca77U, 0xc2b2ae3dU, 0x27d4eb2fU,
+        0x165667b1U, 0xfd7046c5U, 0xb55a4f09U, 0x1b873593U
+      };
+      uint32_t h = lane_hash;
+      uint32_t first = lane_hash >> 60;
+
+#if defined(__AVX512F__)
+      __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                        8, 9, 10, 11, 12, 13, 14, 15);
+      lanes = _mm512_and_si512(_mm512_sub_epi32(lanes, _mm512_set1_epi32(first)),
+                               _mm512_set1_epi32(lanes_per_block - 1));
+      __mmask16 enabled = _mm512_cmplt_epu32_mask(lanes, _mm512_set1_epi32(k));
+
+      __m512i bits = _mm512_mullo_epi32(_mm512_set1_epi32(h),
+                                        _mm512_load_si512((const void *) salt));
+      bits = _mm512_srli_epi32(bits, 27);
+      bits = _mm512_maskz_sllv_epi32(enabled, _mm512_set1_epi32(1), bits);
+      _mm512_storeu_si512((void *) mask.data(), bits);
+#elif defined(__AVX2__)
+      for (size_t half = 0; half < 2; half++) {
+        __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        lanes = _mm256_add_epi32(lanes, _mm256_set1_epi32(int(8*half) - int(first)));
+        lanes = _mm256_and_si256(lanes, _mm256_set1_epi32(lanes_per_block - 1));
+        __m256i enabled = _mm256_cmpgt_epi32(_mm256_set1_epi32(k), lanes);
+
+        __m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32(h),
+                         _mm256_load_si256((const __m256i *) &salt[8*half]));
+        bits = _mm256_srli_epi32(bits, 27);
+        bits = _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+        bits = _mm256_and_si256(bits, enabled);
+        _mm256_storeu_si256((__m256i *) &mask[4*half], bits);
+      }
+#else
+      uint32_t *lane_mask = reinterpret_cast<uint32_t *>(mask.data());
+      for (size_t i = 0; i < lanes_per_block; i++) {
+        size_t lane = (i - first) & (lanes_per_block - 1);
+        lane_mask[i] = (lane < k) ? (0x1U << ((h * salt[i]) >> 27)) : 0x0;
+      }
+#endif
+    }
   };
 }
@@ -1,11 +1,13 @@
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <numeric>
 #include <stdexcept>
 
 #include <bcl/bcl.hpp>
 #include <bcl/containers/Container.hpp>
 #include <bcl/containers/Array.hpp>
+#include <bcl/containers/detail/SequencedRing.hpp>
 #include <bcl/core/util/Backoff.hpp>
 
 #include <unistd.h>
@@ -46,12 +48,21 @@ struct CircularQueue {
   BCL::GlobalPtr<int> reserved_head;
   BCL::GlobalPtr<int> reserved_tail;
 
+  // Sequenced mode only: one sequence number per slot.  Slot
+  // p % capacity is free for position p when seq == p, holds
+  // position p's element when seq == p + 1, and a pop of p
+  // frees it for p + capacity.  Pushes and pops complete
+  // per element, so reserved_head/reserved_tail are unused.
+  BCL::GlobalPtr<int> seq = nullptr;
+  bool sequenced_ = false;
+
   uint64_t my_host;
   size_t my_capacity;
 
   // Buffered location of head.
   // This allows us to get a strict overestimation
   // of the current queue size without an AMO!
+  // In sequenced mode these cache head and tail.
   int head_buf = 0;
   int tail_buf = 0;
 
@@ -68,9 +79,13 @@ struct CircularQueue {
     }
   }
 
-  CircularQueue(const uint64_t host, const size_t capacity) {
+  // With sequenced = true, a slow pusher or popper only holds
+  // up the slots it claimed instead of every later operation.
+  CircularQueue(const uint64_t host, const size_t capacity,
+                const bool sequenced = false) {
     this->my_host = host;
     this->my_capacity = capacity;
+    this->sequenced_ = sequenced;
     try {
       this->data = std::move(BCL::Array <T, TSerialize> (host, capacity));
     } catch (std::runtime_error e) {
@@ -92,12 +107,23 @@ struct CircularQueue {
       *tail.local() = 0;
       *reserved_head.local() = 0;
       *reserved_tail.local() = 0;
+
+      if (sequenced) {
+        seq = BCL::alloc<int>(capacity);
+        if (seq == nullptr) {
+          throw std::runtime_error("BCL: CircularQueue does not have enough memory");
+        }
+        BCL::SequencedRing::init(seq.local(), capacity, 0, 0);
+      }
     }
 
     head = BCL::broadcast(head, host);
     tail = BCL::broadcast(tail, host);
     reserved_head = BCL::broadcast(reserved_head, host);
     reserved_tail = BCL::broadcast(reserved_tail, host);
+    if (sequenced) {
+      seq = BCL::broadcast(seq, host);
+    }
   }
 
   CircularQueue(const CircularQueue &queue) = delete;
@@ -108,17 +134,22 @@ struct CircularQueue {
     this->tail = queue.tail;
     this->reserved_head = queue.reserved_head;
     this->reserved_tail = queue.reserved_tail;
+    this->seq = queue.seq;
+    this->sequenced_ = queue.sequenced_;
     this->my_capacity = queue.my_capacity;
     this->my_host = queue.my_host;
     this->head_buf = queue.head_buf;
+    this->tail_buf = queue.tail_buf;
 
     queue.head = nullptr;
     queue.tail = nullptr;
     queue.reserved_head = nullptr;
     queue.reserved_tail = nullptr;
+    queue.seq = nullptr;
     queue.my_capacity = 0;
     queue.my_host = 0;
     queue.head_buf = 0;
+    queue.tail_buf = 0;
     return *this;
   }
 
@@ -128,17 +159,22 @@ struct CircularQueue {
     this->tail = queue.tail;
     this->reserved_head = queue.reserved_head;
     this->reserved_tail = queue.reserved_tail;
+    this->seq = queue.seq;
+    this->sequenced_ = queue.sequenced_;
     this->my_capacity = queue.my_capacity;
     this->my_host = queue.my_host;
     this->head_buf = queue.head_buf;
+    this->tail_buf = queue.tail_buf;
 
     queue.head = nullptr;
     queue.tail = nullptr;
     queue.reserved_head = nullptr;
     queue.reserved_tail = nullptr;
+    queue.seq = nullptr;
     queue.my_capacity = 0;
     queue.my_host = 0;
     queue.head_buf = 0;
+    queue.tail_buf = 0;
   }
 
   ~CircularQueue() {
@@ -155,6 +191,9 @@ struct CircularQueue {
       if (reserved_tail != nullptr) {
         dealloc(reserved_tail);
       }
+      if (seq != nullptr) {
+        dealloc(seq);
+      }
     }
   }
 
@@ -193,6 +232,9 @@ struct CircularQueue {
   }
 
   bool push_atomic_impl_(const T &val, bool synchronized = false) {
+    if (sequenced_) {
+      return push_sequenced_(&val, 1, synchronized);
+    }
     int old_tail = BCL::fetch_and_op<int>(tail, 1, BCL::plus<int>{});
     int new_tail = old_tail + 1;
 
@@ -228,6 +270,9 @@ struct CircularQueue {
   }
 
   bool push_nonatomic_impl_(const T &val) {
+    if (sequenced_) {
+      return push_sequenced_(&val, 1);
+    }
     int old_tail = BCL::fetch_and_op<int>(tail, 1, BCL::plus<int>{});
     int new_tail = old_tail + 1;
 
@@ -277,6 +322,11 @@ struct CircularQueue {
         return finished_;
       }
 
+      if (queue_->sequenced_) {
+        finished_ = queue_->push_sequenced_(value_->data(), value_->size());
+        return finished_;
+      }
+
       if (!reserved_) {
         if (new_tail_ - queue_->head_buf > queue_->capacity()) {
           queue_->head_buf = BCL::fetch_and_op<int>(queue_->reserved_head, 0, BCL::plus<int>{});
@@ -315,7 +365,12 @@ struct CircularQueue {
     bool finished_ = false;
   };
 
+  // In sequenced mode nothing is reserved up front; the
+  // future claims slots and writes when is_ready() is polled.
   auto async_push(std::vector<T>&& vals) {
+    if (sequenced_) {
+      return push_future(std::move(vals), 0, 0, *this);
+    }
     int old_tail = BCL::fetch_and_op<int>(tail, vals.size(), BCL::plus<int>{});
     int new_tail = old_tail + vals.size();
     return push_future(std::move(vals), old_tail, new_tail, *this);
@@ -325,6 +380,9 @@ struct CircularQueue {
     if (vals.size() == 0) {
       return true;
     }
+    if (sequenced_) {
+      return push_sequenced_(vals.data(), vals.size(), synchronized);
+    }
 
     int old_tail = BCL::fetch_and_op<int>(tail, vals.size(), BCL::plus<int>{});
     int new_tail = old_tail + vals.size();
@@ -375,6 +433,9 @@ struct CircularQueue {
   }
 
   bool push_nonatomic_impl_(const std::vector <T> &vals) {
+    if (sequenced_) {
+      return push_sequenced_(vals.data(), vals.size());
+    }
     int old_tail = BCL::fetch_and_op<int>(tail, vals.size(), BCL::plus<int>{});
     int new_tail = old_tail + vals.size();
 
@@ -404,6 +465,9 @@ struct CircularQueue {
   }
 
   bool pop_atomic_impl_(T &val) {
+    if (sequenced_) {
+      return pop_sequenced_(&val, 1);
+    }
     int old_head = BCL::fetch_and_op<int>(head, 1, BCL::plus<int>{});
     int new_head = old_head + 1;
 
@@ -437,6 +501,9 @@ struct CircularQueue {
   }
 
   bool pop_nonatomic_impl_(T &val) {
+    if (sequenced_) {
+      return pop_sequenced_(&val, 1);
+    }
     int old_head = BCL::fetch_and_op<int>(head, 1, BCL::plus<int>{});
     int new_head = old_head + 1;
 
@@ -519,6 +586,16 @@ struct CircularQueue {
       return false;
     }
     int *head_ptr = head.local();
+    if (sequenced_) {
+      size_t slot = *head_ptr % capacity();
+      if (seq.local()[slot] != *head_ptr + 1) {
+        return false;
+      }
+      val = *data[slot];
+      seq.local()[slot] = *head_ptr + capacity();
+      *head_ptr += 1;
+      return true;
+    }
     int *tail_ptr = tail.local();
     if (*head_ptr + 1 > *tail_ptr) {
       return false;
@@ -528,6 +605,51 @@ struct CircularQueue {
     return true;
   }
 
+  // Sequenced mode.  Claim n consecutive free slots by CAS on
+  // tail, write them, then mark each one full.  With synchronized,
+  // wait for space instead of returning false.
+  bool push_sequenced_(const T *vals, size_t n, bool synchronized = false) {
+    if (n == 0) {
+      return true;
+    }
+    int old_tail;
+    Backoff backoff;
+    while (!ring_().claim(tail, tail_buf, n, 0, old_tail)) {
+      if (!synchronized || n > capacity()) {
+        return false;
+      }
+      backoff.backoff();
+    }
+
+    ring_().for_each_run(old_tail, n, [&](size_t slot, size_t offset, size_t len) {
+      data.put(slot, vals + offset, len);
+    });
+    ring_().publish(old_tail, n, 1);
+    return true;
+  }
+
+  // Sequenced mode.  Returns false unless n elements are ready,
+  // i.e. their pushes have completed.
+  bool pop_sequenced_(T *vals, size_t n) {
+    if (n == 0) {
+      return true;
+    }
+    int old_head;
+    if (!ring_().claim(head, head_buf, n, 1, old_head)) {
+      return false;
+    }
+
+    ring_().for_each_run(old_head, n, [&](size_t slot, size_t offset, size_t len) {
+      data.get(slot, vals + offset, len);
+    });
+    ring_().publish(old_head, n, capacity());
+    return true;
+  }
+
+  BCL::SequencedRing ring_() const {
+    return BCL::SequencedRing(seq, capacity());
+  }
+
   // TODO: deal properly with queues that wrap around.
   std::vector <T> as_vector() {
     if (BCL::rank() != host()) {
@@ -580,13 +702,25 @@ struct CircularQueue {
 
       head = new_head;
       tail = new_tail;
+
+      if (sequenced_) {
+        BCL::GlobalPtr<int> new_seq = BCL::alloc<int>(new_capacity);
+        BCL::SequencedRing::init(new_seq.local(), new_capacity, 0, *new_tail.local());
+        BCL::dealloc(seq);
+        seq = new_seq;
+      }
     }
 
     std::swap(data, new_data);
 
     head = BCL::broadcast(head, host());
     tail = BCL::broadcast(tail, host());
+    if (sequenced_) {
+      seq = BCL::broadcast(seq, host());
+    }
     my_capacity = new_capacity;
+    head_buf = 0;
+    tail_buf = 0;
 
     BCL::barrier();
   }
@@ -620,6 +754,14 @@ struct CircularQueue {
     new_head = BCL::broadcast(new_head, new_host);
     new_tail = BCL::broadcast(new_tail, new_host);
 
+    BCL::GlobalPtr<int> new_seq;
+    if (sequenced_) {
+      if (BCL::rank() == new_host) {
+        new_seq = BCL::alloc<int>(capacity());
+      }
+      new_seq = BCL::broadcast(new_seq, new_host);
+    }
+
     if (BCL::rank() == host()) {
       for (int i = *head.local(); i < *tail.local(); i++) {
         new_data[i % capacity()] = *data[i % capacity()];
@@ -633,13 +775,24 @@ struct CircularQueue {
 
       head = new_head;
       tail = new_tail;
+
+      if (sequenced_) {
+        BCL::rput(seq.local(), new_seq, capacity());
+        BCL::dealloc(seq);
+        seq = new_seq;
+      }
     }
 
     std::swap(data, new_data);
 
     head = BCL::broadcast(head, host());
     tail = BCL::broadcast(tail, host());
+    if (sequenced_) {
+      seq = BCL::broadcast(seq, host());
+    }
     my_host = new_host;
+    head_buf = 0;
+    tail_buf = 0;
 
     BCL::barrier();
   }
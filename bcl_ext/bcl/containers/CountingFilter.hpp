@@ -0,0 +1,434 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+#include <bcl/bcl.hpp>
+
+namespace BCL {
+  // A counting filter: a cuckoo-style table of 16-bit fingerprints,
+  // each paired with a 16-bit (saturating) counter.  Every key has two
+  // candidate buckets of eight slots on the same rank, so all operations
+  // on a key go to one owner.  Entries are never relocated; an insert
+  // fails once both of a new key's buckets are full.
+  //
+  // Like a Bloom filter, count() may overestimate when two keys share a
+  // fingerprint and a bucket, but it never underestimates.
+  //
+  // Concurrent first inserts of the same key may each claim an empty
+  // slot, leaving the key in two slots.  Counts stay exact, since
+  // count() sums every slot holding the fingerprint and remove()
+  // decrements whichever it finds first, but the duplicate slot costs
+  // capacity until its count drops to zero.
+  template <typename T, typename Hash = std::hash<T>>
+  struct CountingFilter {
+    using slot_type = uint32_t;
+
+    static constexpr size_t slots_per_bucket = 8;
+    static constexpr size_t count_bits = 16;
+    static constexpr slot_type count_mask = (slot_type(1) << count_bits) - 1;
+
+    using bucket_type = std::array<slot_type, slots_per_bucket>;
+
+    std::vector <BCL::GlobalPtr <slot_type>> data;
+    // Number of buckets, total and per rank.
+    size_t num_buckets;
+    size_t local_size;
+
+    Hash hash_fn;
+
+    uint64_t hash(uint64_t key) const {
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= key >> 33;
+      key *= 0xc4ceb9fe1a85ec53ULL;
+      key ^= key >> 33;
+      return key;
+    }
+
+    CountingFilter() {}
+
+    // n - expected number of distinct keys
+    // max_load - fraction of slots expected to be used
+    CountingFilter(size_t n, double max_load = 0.7) {
+      num_buckets = std::ceil(n / (slots_per_bucket * max_load));
+      num_buckets = std::max<size_t>(num_buckets, 1);
+
+      local_size = (num_buckets + BCL::nprocs() - 1) / BCL::nprocs();
+
+      num_buckets = local_size * BCL::nprocs();
+
+      data.resize(BCL::nprocs(), nullptr);
+      for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+        if (BCL::rank() == rank) {
+          data[rank] = BCL::alloc <slot_type> (local_size*slots_per_bucket);
+
+          if (data[rank] != nullptr) {
+            for (size_t i = 0; i < local_size*slots_per_bucket; i++) {
+              data[rank].local()[i] = 0x0;
+            }
+          }
+        }
+        data[rank] = BCL::broadcast(data[rank], rank);
+        if (data[rank] == nullptr) {
+          throw std::runtime_error("CountingFilter: ran out of space.");
+        }
+      }
+    }
+
+    ~CountingFilter() {
+      if (!BCL::bcl_finalized) {
+        if (BCL::rank() < data.size() && data[BCL::rank()] != nullptr) {
+          BCL::dealloc(data[BCL::rank()]);
+        }
+      }
+    }
+
+    CountingFilter(const CountingFilter &) = delete;
+    CountingFilter &operator=(const CountingFilter &) = delete;
+
+    CountingFilter(CountingFilter &&filter) {
+      *this = std::move(filter);
+    }
+
+    CountingFilter &operator=(CountingFilter &&filter) {
+      this->data = std::move(filter.data);
+      this->num_buckets = filter.num_buckets;
+      this->local_size = filter.local_size;
+      return *this;
+    }
+
+    // Increment val's count.  Returns false if the filter is full.
+    bool insert(const T &val) {
+      return update_(locate_(val), 1);
+    }
+
+    // Decrement val's count.  Returns false if val is not present.
+    bool remove(const T &val) {
+      return update_(locate_(val), -1);
+    }
+
+    size_t count(const T &val) {
+      location_ loc = locate_(val);
+      bucket_type b1, b2;
+      BCL::rget(bucket_ptr_(loc.node, loc.b1), b1.data(), slots_per_bucket);
+      if (loc.b2 != loc.b1) {
+        BCL::rget(bucket_ptr_(loc.node, loc.b2), b2.data(), slots_per_bucket);
+      } else {
+        b2.fill(0x0);
+      }
+      return count_(b1, loc.fp) + count_(b2, loc.fp);
+    }
+
+    // Batched versions.  Updates to the same key are combined
+    // locally; each round fetches every bucket involved once, then
+    // issues all of its CASes before a single flush per owner.
+    // Returns false if any insert found the filter full (or any
+    // remove found its key absent).
+    bool insert_many(const std::vector<T> &vals) {
+      return update_many_(vals, 1);
+    }
+
+    bool remove_many(const std::vector<T> &vals) {
+      return update_many_(vals, -1);
+    }
+
+    std::vector<size_t> count_many(const std::vector<T> &vals) {
+      std::vector<location_> locs(vals.size());
+      std::unordered_map<uint64_t, size_t> buckets;
+      for (size_t i = 0; i < vals.size(); i++) {
+        locs[i] = locate_(vals[i]);
+        buckets.emplace(bucket_key_(locs[i].node, locs[i].b1), buckets.size());
+        buckets.emplace(bucket_key_(locs[i].node, locs[i].b2), buckets.size());
+      }
+
+      std::vector<bucket_type> snapshot = fetch_buckets_(buckets);
+
+      std::vector<size_t> counts(vals.size());
+      for (size_t i = 0; i < vals.size(); i++) {
+        const location_ &loc = locs[i];
+        counts[i] = count_(snapshot[buckets[bucket_key_(loc.node, loc.b1)]], loc.fp);
+        if (loc.b2 != loc.b1) {
+          counts[i] += count_(snapshot[buckets[bucket_key_(loc.node, loc.b2)]], loc.fp);
+        }
+      }
+      return counts;
+    }
+
+  private:
+    struct location_ {
+      size_t node;
+      size_t b1;
+      size_t b2;
+      slot_type fp;
+    };
+
+    location_ locate_(const T &val) const {
+      location_ loc;
+      uint64_t my_hash = hash(hash_fn(val));
+      size_t bucket = my_hash % num_buckets;
+      loc.node = bucket / local_size;
+      loc.b1 = bucket - loc.node*local_size;
+
+      loc.fp = hash(my_hash) >> (64 - count_bits);
+      if (loc.fp == 0) {
+        loc.fp = 1;
+      }
+
+      // The alternate bucket is a function of the fingerprint,
+      // always on the same rank.
+      if (local_size > 1) {
+        loc.b2 = (loc.b1 + 1 + hash(loc.fp) % (local_size - 1)) % local_size;
+      } else {
+        loc.b2 = loc.b1;
+      }
+      return loc;
+    }
+
+    BCL::GlobalPtr<slot_type> bucket_ptr_(size_t node, size_t bucket) const {
+      return data[node] + bucket*slots_per_bucket;
+    }
+
+    uint64_t bucket_key_(size_t node, size_t bucket) const {
+      return node*local_size + bucket;
+    }
+
+    static slot_type fp_(slot_type slot) {
+      return slot >> count_bits;
+    }
+
+    static size_t count_(const bucket_type &bucket, slot_type fp) {
+      size_t count = 0;
+      for (slot_type slot : bucket) {
+        if (fp_(slot) == fp) {
+          count += slot & count_mask;
+        }
+      }
+      return count;
+    }
+
+    static size_t load_(const bucket_type &bucket) {
+      return std::count_if(bucket.begin(), bucket.end(),
+                           [](slot_type slot) { return slot != 0x0; });
+    }
+
+    // New value of a slot holding fp after adding delta.
+    // Counts saturate; a count that reaches zero frees the slot.
+    static slot_type updated_(slot_type slot, slot_type fp, int64_t delta, bool &underflow) {
+      int64_t count = (slot == 0x0) ? 0 : (slot & count_mask);
+      if (count == count_mask && delta > 0) {
+        return slot;
+      }
+      count += delta;
+      underflow = count < 0;
+      count = std::max<int64_t>(0, std::min<int64_t>(count, count_mask));
+      return (count == 0) ? 0x0 : ((fp << count_bits) | slot_type(count));
+    }
+
+    struct target_ {
+      BCL::GlobalPtr<slot_type> ptr;
+      size_t bucket;
+      size_t slot;
+      slot_type old_slot;
+      slot_type new_slot;
+      bool underflow = false;
+      // Failed only because of slots claimed by other ops.
+      bool contended = false;
+    };
+
+    // Choose the slot to CAS for adding delta to fp, given the
+    // current contents of both candidate buckets.  Returns false if
+    // there is nowhere to put it.  Slots in claimed are off limits.
+    template <typename Claimed>
+    bool plan_(const location_ &loc, const bucket_type &b1, const bucket_type &b2,
+               int64_t delta, const Claimed &claimed, target_ &target) const {
+      const bucket_type *buckets[2] = {&b1, &b2};
+      size_t idx[2] = {loc.b1, loc.b2};
+      size_t n_buckets = (loc.b1 == loc.b2) ? 1 : 2;
+
+      for (size_t b = 0; b < n_buckets; b++) {
+        for (size_t i = 0; i < slots_per_bucket; i++) {
+          slot_type slot = (*buckets[b])[i];
+          if (slot != 0x0 && fp_(slot) == loc.fp) {
+            target.ptr = bucket_ptr_(loc.node, idx[b]) + i;
+            target.bucket = idx[b];
+            target.slot = i;
+            if (claimed(target.ptr)) {
+              target.contended = true;
+              return false;
+            }
+            target.old_slot = slot;
+            target.new_slot = updated_(slot, loc.fp, delta, target.underflow);
+            return true;
+          }
+        }
+      }
+
+      if (delta < 0) {
+        target.underflow = true;
+        return false;
+      }
+
+      // Insert into the emptier bucket.
+      if (n_buckets == 2 && load_(b2) < load_(b1)) {
+        std::swap(buckets[0], buckets[1]);
+        std::swap(idx[0], idx[1]);
+      }
+      for (size_t b = 0; b < n_buckets; b++) {
+        for (size_t i = 0; i < slots_per_bucket; i++) {
+          BCL::GlobalPtr<slot_type> ptr = bucket_ptr_(loc.node, idx[b]) + i;
+          if ((*buckets[b])[i] == 0x0) {
+            if (claimed(ptr)) {
+              target.contended = true;
+              continue;
+            }
+            target.ptr = ptr;
+            target.bucket = idx[b];
+            target.slot = i;
+            target.old_slot = 0x0;
+            target.new_slot = updated_(0x0, loc.fp, delta, target.underflow);
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    bool update_(const location_ &loc, int64_t delta) {
+      auto unclaimed = [](const BCL::GlobalPtr<slot_type> &) { return false; };
+      while (true) {
+        bucket_type b1, b2;
+        BCL::rget(bucket_ptr_(loc.node, loc.b1), b1.data(), slots_per_bucket);
+        if (loc.b2 != loc.b1) {
+          BCL::rget(bucket_ptr_(loc.node, loc.b2), b2.data(), slots_per_bucket);
+        } else {
+          b2 = b1;
+        }
+
+        target_ target;
+        if (!plan_(loc, b1, b2, delta, unclaimed, target)) {
+          return false;
+        }
+        if (target.old_slot == target.new_slot) {
+          return true;
+        }
+        slot_type result = BCL::compare_and_swap(target.ptr, target.old_slot,
+                                                 target.new_slot);
+        if (result == target.old_slot) {
+          return !target.underflow;
+        }
+      }
+    }
+
+    std::vector<bucket_type> fetch_buckets_(const std::unordered_map<uint64_t, size_t> &buckets) {
+      std::vector<bucket_type> snapshot(buckets.size());
+      std::vector<BCL::request> requests;
+      for (const auto &bucket : buckets) {
+        size_t node = bucket.first / local_size;
+        requests.push_back(BCL::arget(bucket_ptr_(node, bucket.first - node*local_size),
+                                      snapshot[bucket.second].data(), slots_per_bucket));
+      }
+      for (auto &request : requests) {
+        request.wait();
+      }
+      return snapshot;
+    }
+
+    bool update_many_(const std::vector<T> &vals, int64_t sign) {
+      struct pending_ {
+        location_ loc;
+        int64_t delta;
+      };
+
+      // Combine updates to the same (bucket, fingerprint).
+      std::unordered_map<uint64_t, pending_> combined;
+      for (const T &val : vals) {
+        location_ loc = locate_(val);
+        uint64_t key = (bucket_key_(loc.node, loc.b1) << count_bits) | loc.fp;
+        auto result = combined.emplace(key, pending_{loc, sign});
+        if (!result.second) {
+          result.first->second.delta += sign;
+        }
+      }
+
+      std::vector<pending_> pending;
+      for (auto &entry : combined) {
+        pending.push_back(entry.second);
+      }
+
+      bool success = true;
+      while (!pending.empty()) {
+        std::unordered_map<uint64_t, size_t> buckets;
+        for (const pending_ &op : pending) {
+          buckets.emplace(bucket_key_(op.loc.node, op.loc.b1), buckets.size());
+          buckets.emplace(bucket_key_(op.loc.node, op.loc.b2), buckets.size());
+        }
+        std::vector<bucket_type> snapshot = fetch_buckets_(buckets);
+
+        // Plan one CAS per pending op, never two on the same slot.
+        std::unordered_map<uint64_t, size_t> claimed_slots;
+        auto claimed = [&](const BCL::GlobalPtr<slot_type> &ptr) {
+          return claimed_slots.count((uint64_t(ptr.rank) << 32) | ptr.ptr) > 0;
+        };
+
+        std::vector<pending_> retry;
+        std::vector<pending_> issued;
+        std::vector<target_> targets;
+        for (const pending_ &op : pending) {
+          const bucket_type b1 = snapshot[buckets[bucket_key_(op.loc.node, op.loc.b1)]];
+          const bucket_type b2 = snapshot[buckets[bucket_key_(op.loc.node, op.loc.b2)]];
+
+          target_ target;
+          if (plan_(op.loc, b1, b2, op.delta, claimed, target)) {
+            if (target.old_slot == target.new_slot) {
+              continue;
+            }
+            // Later ops in this round see the planned update.
+            snapshot[buckets[bucket_key_(op.loc.node, target.bucket)]][target.slot] = target.new_slot;
+            claimed_slots[(uint64_t(target.ptr.rank) << 32) | target.ptr.ptr] = targets.size();
+            targets.push_back(target);
+            issued.push_back(op);
+          } else if (target.contended) {
+            retry.push_back(op);
+          } else if (target.underflow) {
+            success = false;
+          } else {
+            // Both buckets are full.
+            success = false;
+          }
+        }
+
+        std::vector<slot_type> results(targets.size());
+        std::vector<bool> touched(data.size(), false);
+        for (size_t i = 0; i < targets.size(); i++) {
+          BCL::compare_and_swap_async(targets[i].ptr, &targets[i].old_slot,
+                                      &targets[i].new_slot, &results[i]);
+          touched[targets[i].ptr.rank] = true;
+        }
+        for (size_t rank = 0; rank < touched.size(); rank++) {
+          if (touched[rank]) {
+            BCL::flush(rank);
+          }
+        }
+
+        for (size_t i = 0; i < targets.size(); i++) {
+          if (results[i] != targets[i].old_slot) {
+            retry.push_back(issued[i]);
+          } else if (targets[i].underflow) {
+            success = false;
+          }
+        }
+
+        pending = std::move(retry);
+      }
+      return success;
+    }
+  };
+}
@@ -7,9 +7,12 @@
 #include <iostream>
 #include <list>
 #include <memory>
+#include <array>
 
 #include <bcl/containers/algorithms/gemm.hpp>
 #include <bcl/containers/detail/Blocking.hpp>
+#include <bcl/containers/detail/TileFile.hpp>
+#include <bcl/containers/detail/TileCache.hpp>
 
 namespace BCL
 {
@@ -42,6 +45,9 @@ public:
 
   std::unique_ptr<BCL::Team> team_ptr_;
 
+  // Identifies this matrix in BCL::tile_cache().
+  size_t cache_id_ = BCL::TileCache::new_id();
+
   DMatrix(const DMatrix&) = delete;
   DMatrix(DMatrix&&) = default;
 
@@ -139,6 +145,72 @@ public:
     init(m, n, std::move(blocking));
   }
 
+  // Reload a matrix checkpointed with save().
+  template <typename TeamType>
+  DMatrix(const std::string& fname, const TeamType& team) : team_ptr_(team.clone()) {
+    load_(fname);
+  }
+
+  explicit DMatrix(const std::string& fname) : team_ptr_(new BCL::WorldTeam()) {
+    load_(fname);
+  }
+
+  // Collective.  Checkpoint the matrix to fname, each rank
+  // writing its own tiles.
+  void save(const std::string& fname) const {
+    TileFileHeader header = make_tile_file_header_(false, sizeof(T), 0,
+                                                   m_, n_, m_*n_,
+                                                   tile_size_m_, tile_size_n_,
+                                                   grid_dim_m_, grid_dim_n_,
+                                                   pm_, pn_);
+
+    std::vector<size_t> bytes(ptrs_.size(), sizeof(T)*tile_size());
+    std::vector<size_t> nnzs(ptrs_.size(), tile_size());
+    std::vector<TileFileEntry> tiles = tile_file_layout_(bytes, nnzs);
+    int fd = create_tile_file(fname, header, tiles);
+
+    for (size_t i = 0; i < ptrs_.size(); i++) {
+      if (ptrs_[i].is_local()) {
+        tile_file_pwrite_(fd, ptrs_[i].local(), tiles[i].bytes, tiles[i].offset);
+      }
+    }
+    close(fd);
+    BCL::barrier();
+  }
+
+  void load_(const std::string& fname) {
+    TileFileHeader header;
+    std::vector<TileFileEntry> tiles;
+    int fd = open_tile_file(fname, header, tiles);
+
+    if (header.sparse || header.value_size != sizeof(T)) {
+      close(fd);
+      throw std::runtime_error("DMatrix: " + fname + " does not hold a matrix of this type.");
+    }
+
+    // Restarting on fewer ranks than wrote the file
+    // keeps the tiles, but not the processor grid.
+    size_t pm = header.pm;
+    size_t pn = header.pn;
+    if (pm*pn > BCL::nprocs(this->team())) {
+      std::vector<size_t> pgrid = factor(BCL::nprocs(this->team()));
+      pm = pgrid[0];
+      pn = pgrid[1];
+    }
+
+    m_ = header.m;
+    n_ = header.n;
+    init(m_, n_, BCL::BlockCustom({header.tile_m, header.tile_n}, {pm, pn}));
+
+    for (size_t i = 0; i < ptrs_.size(); i++) {
+      if (ptrs_[i].is_local()) {
+        tile_file_pread_(fd, ptrs_[i].local(), tiles[i].bytes, tiles[i].offset);
+      }
+    }
+    close(fd);
+    BCL::barrier();
+  }
+
   const BCL::Team& team() const {
     return *team_ptr_;
   }
@@ -153,14 +225,40 @@ public:
 
   template <typename Allocator = BCL::bcl_allocator<T>>
   auto arget_tile(size_t i, size_t j) const {
-    return std::make_tuple(BCL::arget<T, Allocator>(tile_ptr(i, j), tile_size()), is_transpose());
+    using tile_type = std::vector<T, Allocator>;
+    using future_type = BCL::cached_future<BCL::future<tile_type>>;
+    auto& cache = BCL::tile_cache();
+    if (!cache.enabled() || tile_ptr(i, j).is_local()) {
+      return std::make_tuple(future_type(BCL::arget<T, Allocator>(tile_ptr(i, j), tile_size())),
+                             is_transpose());
+    }
+
+    BCL::TileCache::Key key{cache_id_, i, j};
+    if (auto* entry = cache.find(key)) {
+      BCL::future<tile_type> tile(tile_cache_vector_<T, Allocator>((*entry)[0]),
+                                  std::vector<BCL::request>());
+      return std::make_tuple(future_type(std::move(tile)), is_transpose());
+    }
+
+    size_t epoch = cache.epoch(cache_id_);
+    future_type tile(BCL::arget<T, Allocator>(tile_ptr(i, j), tile_size()),
+                     [key, epoch](const tile_type& tile) {
+                       BCL::tile_cache().insert(key, epoch, {tile_cache_bytes_(tile)});
+                     });
+    return std::make_tuple(std::move(tile), is_transpose());
   }
 
   template <typename Allocator>
   auto arput_tile(size_t i, size_t j, std::vector<T, Allocator>&& tile) {
+    BCL::tile_cache().invalidate(cache_id_, i, j);
     return BCL::arput(tile_ptr(i, j), std::move(tile));
   }
 
+  // Drop this matrix's tiles from the calling rank's tile cache.
+  void invalidate_cache() const {
+    BCL::tile_cache().invalidate(cache_id_);
+  }
+
   std::vector<T> get_tile(size_t i, size_t j) const {
     std::vector<T> vals(tile_size());
     BCL::rget(tile_ptr(i, j), vals.data(), tile_size());
@@ -191,6 +289,7 @@ public:
 
   template <typename U>
   DMatrix& operator=(const U& value) {
+    invalidate_cache();
     for (size_t i = 0; i < ptrs_.size(); i++) {
       if (ptrs_[i].is_local()) {
         T* lptr = ptrs_[i].local();
@@ -247,6 +346,7 @@ public:
 
   template <typename Fn>
   DMatrix& apply_inplace(const Fn& fn) {
+    invalidate_cache();
     for (size_t i = 0; i < ptrs_.size(); i++) {
       if (ptrs_[i].is_local()) {
         T* lptr = ptrs_[i].local();
@@ -304,6 +404,7 @@ public:
 
   template <typename Fn>
   DMatrix<T>& binary_op_inplace(const DMatrix<T>& other, const Fn& bin_op) {
+    invalidate_cache();
     if (!team().in_team()) {
       return *this;
     }
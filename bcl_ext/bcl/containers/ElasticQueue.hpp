@@ -0,0 +1,375 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/detail/SequencedRing.hpp>
+
+namespace BCL {
+
+// A queue hosted on one rank, built from a chain of ring segments
+// so it can grow while in use.  Unlike CircularQueue::resize(),
+// growing is not collective and copies nothing: when the newest
+// segment fills past grow_threshold, the host appends a segment
+// twice its size and publishes it through the tail segment id.
+// Pushers that find their segment closed or full re-read that id
+// and move on; poppers move on once a closed segment is drained.
+//
+// The host does this in progress(), which it runs on each of its
+// own pushes and pops.  A host that does neither should call
+// progress() now and then, or the queue stays at its current size.
+//
+// Drained segments are retired to a free list and reused by later
+// growth, never freed while the queue is live, since a rank with a
+// stale view may still touch them.  shrink_to_fit() (collective)
+// releases them.
+//
+// Each segment is a sequenced ring, as in FastQueue.  Positions
+// keep counting when a segment is reused, so a stale claim either
+// fails or lands in a live segment.  Values from one pusher come
+// out in order; a pop of n values takes them from one segment.
+//
+// Positions must stay below closed_bit, so a segment that has
+// taken about 2^30 pushes over its lifetime is exhausted: it
+// refuses pushes that would reach closed_bit, progress() replaces
+// it as the tail, and it is never reused.
+template <typename T>
+struct ElasticQueue {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "BCL::ElasticQueue: T must be trivially copyable.");
+
+  struct segment_t {
+    BCL::GlobalPtr<T> data;
+    // head, tail, then one sequence number per slot.
+    BCL::GlobalPtr<int> ctrl;
+    size_t capacity;
+  };
+
+  // Set in a segment's tail once it takes no more pushes.
+  constexpr static int closed_bit = 1 << 30;
+
+  uint64_t my_host;
+  size_t max_segments_;
+  double grow_threshold_;
+
+  // Head and tail segment ids.
+  BCL::GlobalPtr<int> segment_ids_;
+  // Segment id % max_segments -> segment.
+  BCL::GlobalPtr<segment_t> directory_;
+
+  // Per-rank view of the segments, indexed like the directory.
+  // head_buf and tail_buf are last seen counters, never ahead
+  // of the real ones.
+  struct cached_segment_t {
+    int id = -1;
+    segment_t segment;
+    int head_buf = 0;
+    int tail_buf = 0;
+  };
+  std::vector<cached_segment_t> cache_;
+  int head_id_buf_ = 0;
+  int tail_id_buf_ = 0;
+
+  // Host only.  live_ holds segment ids
+  // [live_begin_, live_begin_ + live_.size()).
+  std::deque<segment_t> live_;
+  int live_begin_ = 0;
+  std::vector<segment_t> free_;
+
+  ElasticQueue(const uint64_t host, const size_t capacity,
+               const size_t max_segments = 16,
+               const double grow_threshold = 0.75)
+    : my_host(host), max_segments_(max_segments),
+      grow_threshold_(grow_threshold), cache_(max_segments) {
+    if (capacity == 0 || max_segments == 0) {
+      throw std::runtime_error("BCL::ElasticQueue: capacity and max_segments must be nonzero.");
+    }
+    if (BCL::rank() == host) {
+      segment_ids_ = BCL::alloc<int>(2);
+      directory_ = BCL::alloc<segment_t>(max_segments);
+      if (segment_ids_ == nullptr || directory_ == nullptr) {
+        throw std::runtime_error("BCL: ElasticQueue does not have enough memory");
+      }
+      segment_ids_.local()[0] = 0;
+      segment_ids_.local()[1] = 0;
+
+      live_.push_back(new_segment_(capacity));
+      directory_.local()[0] = live_.back();
+    }
+    segment_ids_ = BCL::broadcast(segment_ids_, host);
+    directory_ = BCL::broadcast(directory_, host);
+  }
+
+  ElasticQueue(const ElasticQueue&) = delete;
+  ElasticQueue& operator=(const ElasticQueue&) = delete;
+
+  ElasticQueue(ElasticQueue&& other)
+    : my_host(other.my_host), max_segments_(other.max_segments_),
+      grow_threshold_(other.grow_threshold_),
+      segment_ids_(other.segment_ids_), directory_(other.directory_),
+      cache_(std::move(other.cache_)), head_id_buf_(other.head_id_buf_),
+      tail_id_buf_(other.tail_id_buf_), live_(std::move(other.live_)),
+      live_begin_(other.live_begin_), free_(std::move(other.free_)) {
+    other.segment_ids_ = nullptr;
+    other.directory_ = nullptr;
+    other.live_.clear();
+    other.free_.clear();
+  }
+
+  ~ElasticQueue() {
+    if (BCL::rank() == host() && !BCL::bcl_finalized &&
+        segment_ids_ != nullptr) {
+      for (auto& segment : live_) {
+        free_segment_(segment);
+      }
+      for (auto& segment : free_) {
+        free_segment_(segment);
+      }
+      BCL::dealloc(segment_ids_);
+      BCL::dealloc(directory_);
+    }
+  }
+
+  uint64_t host() const noexcept {
+    return my_host;
+  }
+
+  // Number of segments between the head and tail, inclusive.
+  size_t n_segments() const {
+    return BCL::rget(segment_ids_ + 1) - BCL::rget(segment_ids_) + 1;
+  }
+
+  // Like CircularQueue::size(), this counts pushes in progress.
+  size_t size() {
+    size_t size = 0;
+    for_each_segment_([&](const segment_t& segment) {
+      size += (BCL::rget(segment.ctrl + 1) & ~closed_bit) - BCL::rget(segment.ctrl);
+    });
+    return size;
+  }
+
+  // Total slots in the segments between the head and tail.
+  size_t capacity() {
+    size_t capacity = 0;
+    for_each_segment_([&](const segment_t& segment) {
+      capacity += segment.capacity;
+    });
+    return capacity;
+  }
+
+  bool empty() {
+    return size() == 0;
+  }
+
+  bool push(const T& val) {
+    return push(&val, 1);
+  }
+
+  bool push(const std::vector<T>& vals) {
+    return push(vals.data(), vals.size());
+  }
+
+  // Returns false if the newest segment has no room for n values.
+  bool push(const T* vals, const size_t n) {
+    if (n == 0) {
+      return true;
+    }
+    if (BCL::rank() == host()) {
+      progress();
+    }
+    int id = tail_id_buf_;
+    while (true) {
+      auto& entry = segment_(id);
+      int pos;
+      const segment_t& segment = entry.segment;
+      // Also fails once the tail is closed.
+      if (ring_(segment).claim(segment.ctrl + 1, entry.tail_buf, n, 0, pos, closed_bit)) {
+        ring_(segment).for_each_run(pos, n, [&](size_t slot, size_t offset, size_t len) {
+          BCL::rput(vals + offset, segment.data + slot, len);
+        });
+        ring_(segment).publish(pos, n, 1);
+        return true;
+      }
+      int tail_id = BCL::rget(segment_ids_ + 1);
+      if (tail_id == id) {
+        return false;
+      }
+      id = tail_id_buf_ = tail_id;
+    }
+  }
+
+  bool pop(T& val) {
+    return pop(&val, 1);
+  }
+
+  // Returns false unless n values are ready in the head segment.
+  bool pop(T* vals, const size_t n) {
+    if (n == 0) {
+      return true;
+    }
+    if (BCL::rank() == host()) {
+      progress();
+    }
+    int id = head_id_buf_;
+    while (true) {
+      auto& entry = segment_(id);
+      const segment_t& segment = entry.segment;
+      int pos;
+      if (ring_(segment).claim(segment.ctrl, entry.head_buf, n, 1, pos)) {
+        ring_(segment).for_each_run(pos, n, [&](size_t slot, size_t offset, size_t len) {
+          BCL::rget(segment.data + slot, vals + offset, len);
+        });
+        ring_(segment).publish(pos, n, int(segment.capacity));
+        return true;
+      }
+
+      int head_id = BCL::rget(segment_ids_);
+      if (head_id != id) {
+        id = head_id_buf_ = head_id;
+        continue;
+      }
+      // Move past the head segment only once it is closed and every
+      // value pushed to it has been popped.
+      int tail = BCL::rget(segment.ctrl + 1);
+      if (!(tail & closed_bit) || BCL::rget(segment.ctrl) != (tail & ~closed_bit)) {
+        return false;
+      }
+      head_id = BCL::compare_and_swap<int>(segment_ids_, id, id + 1);
+      id = head_id_buf_ = (head_id == id) ? id + 1 : head_id;
+    }
+  }
+
+  // Host only, not collective.  Retire segments the poppers have
+  // moved past, and grow if the tail segment is past the threshold.
+  void progress() {
+    if (BCL::rank() != host()) {
+      return;
+    }
+    int head_id = BCL::rget(segment_ids_);
+    while (live_begin_ < head_id) {
+      free_.push_back(live_.front());
+      live_.pop_front();
+      live_begin_++;
+    }
+
+    const segment_t& tail = live_.back();
+    int tail_pos = BCL::rget(tail.ctrl + 1);
+    int occupancy = tail_pos - BCL::rget(tail.ctrl);
+    if (live_.size() >= max_segments_) {
+      return;
+    }
+    if (occupancy >= grow_threshold_*tail.capacity) {
+      append_segment_(2*tail.capacity);
+    } else if (exhausted_(tail_pos, tail.capacity)) {
+      append_segment_(tail.capacity);
+    }
+  }
+
+  // Collective.  Free the retired segments.
+  void shrink_to_fit() {
+    BCL::barrier();
+    if (BCL::rank() == host()) {
+      progress();
+      for (auto& segment : free_) {
+        free_segment_(segment);
+      }
+      free_.clear();
+    }
+    for (auto& entry : cache_) {
+      entry = cached_segment_t();
+    }
+    head_id_buf_ = BCL::rget(segment_ids_);
+    tail_id_buf_ = BCL::rget(segment_ids_ + 1);
+    BCL::barrier();
+  }
+
+private:
+  segment_t new_segment_(size_t capacity) {
+    segment_t segment;
+    segment.capacity = capacity;
+    segment.data = BCL::alloc<T>(capacity);
+    segment.ctrl = BCL::alloc<int>(capacity + 2);
+    if (segment.data == nullptr || segment.ctrl == nullptr) {
+      throw std::runtime_error("BCL: ElasticQueue does not have enough memory");
+    }
+    int* ctrl = segment.ctrl.local();
+    ctrl[0] = 0;
+    ctrl[1] = 0;
+    std::iota(ctrl + 2, ctrl + 2 + capacity, 0);
+    return segment;
+  }
+
+  void free_segment_(segment_t& segment) {
+    BCL::dealloc(segment.data);
+    BCL::dealloc(segment.ctrl);
+  }
+
+  // Publish a segment of at least capacity slots as the new tail,
+  // then close the old tail.  In that order, a pusher that sees the
+  // old tail closed always finds the new id.
+  void append_segment_(size_t capacity) {
+    segment_t segment;
+    auto iter = std::find_if(free_.begin(), free_.end(),
+                             [&](const segment_t& segment) {
+                               return segment.capacity >= capacity &&
+                                    !exhausted_(BCL::rget(segment.ctrl + 1) & ~closed_bit,
+                                                segment.capacity);
+                             });
+    if (iter != free_.end()) {
+      segment = *iter;
+      free_.erase(iter);
+      BCL::fetch_and_op<int>(segment.ctrl + 1, -closed_bit, BCL::plus<int>{});
+    } else {
+      segment = new_segment_(capacity);
+    }
+
+    segment_t old_tail = live_.back();
+    int id = live_begin_ + live_.size();
+    // Other ranks read the directory remotely, so complete the
+    // entry before the new tail id can send them to it.
+    BCL::rput(segment, directory_ + id % max_segments_);
+    BCL::flush(host());
+    live_.push_back(segment);
+
+    BCL::fetch_and_op<int>(segment_ids_ + 1, 1, BCL::plus<int>{});
+    BCL::fetch_and_op<int>(old_tail.ctrl + 1, closed_bit, BCL::plus<int>{});
+  }
+
+  // True once a segment's tail is too close to closed_bit
+  // to take a push of its full capacity.
+  static bool exhausted_(int tail_pos, size_t capacity) {
+    return tail_pos >= closed_bit - int(capacity);
+  }
+
+  cached_segment_t& segment_(int id) {
+    auto& entry = cache_[id % max_segments_];
+    if (entry.id != id) {
+      entry = cached_segment_t();
+      entry.id = id;
+      entry.segment = BCL::rget(directory_ + id % max_segments_);
+    }
+    return entry;
+  }
+
+  template <typename Fn>
+  void for_each_segment_(Fn&& fn) {
+    int head_id = BCL::rget(segment_ids_);
+    int tail_id = BCL::rget(segment_ids_ + 1);
+    for (int id = head_id; id <= tail_id; id++) {
+      fn(segment_(id).segment);
+    }
+  }
+
+  // The segment's sequence numbers follow its head and tail.
+  static BCL::SequencedRing ring_(const segment_t& segment) {
+    return BCL::SequencedRing(segment.ctrl + 2, segment.capacity);
+  }
+};
+
+} // end BCL
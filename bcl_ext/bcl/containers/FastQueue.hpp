@@ -1,12 +1,15 @@
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <algorithm>
+#include <numeric>
 #include <bcl/core/detail/optional.hpp>
 #include <stdexcept>
 
 #include <bcl/bcl.hpp>
 #include <bcl/containers/Container.hpp>
 #include <bcl/containers/Array.hpp>
+#include <bcl/containers/detail/SequencedRing.hpp>
 
 #include <unistd.h>
 
@@ -18,15 +21,23 @@ struct FastQueue {
   BCL::GlobalPtr <int> head;
   BCL::GlobalPtr <int> tail;
 
+  // Per-slot sequence numbers.  Slot i is free for the push at
+  // position p when seq[i] == p, and holds that push's value once
+  // seq[i] == p + 1.  Popping position p hands the slot on to
+  // position p + capacity().  Producers and consumers only ever
+  // wait on these, so pops can run concurrently with pushes.
+  BCL::GlobalPtr <int> seq;
+
   using value_type = T;
   using iterator = BCL::GlobalPtr<T>;
 
   uint64_t my_host;
   size_t my_capacity;
 
-  // Buffered location of head, tail.
-  // This allows us to get a strict overestimation
-  // of the current queue size without an AMO!
+  // Last seen values of head, tail.  These are never ahead of
+  // the real counters, and serve as the expected value of the
+  // first CAS on a push or pop, saving a round trip when
+  // there is no contention.
   int head_buf = 0;
   int tail_buf = 0;
 
@@ -56,13 +67,15 @@ struct FastQueue {
 
     head = BCL::alloc<int>(1);
     tail = BCL::alloc<int>(1);
+    seq = BCL::alloc<int>(capacity);
 
-    if (head == nullptr || tail == nullptr) {
+    if (head == nullptr || tail == nullptr || seq == nullptr) {
       throw std::runtime_error("BCL: FastQueue does not have enough memory");
     }
 
     *head.local() = 0;
     *tail.local() = 0;
+    std::iota(seq.local(), seq.local() + capacity, 0);
   }
 
   FastQueue(const uint64_t host, const size_t capacity) {
@@ -77,17 +90,20 @@ struct FastQueue {
     if (BCL::rank() == host) {
       head = BCL::alloc <int> (1);
       tail = BCL::alloc <int> (1);
+      seq = BCL::alloc <int> (capacity);
 
-      if (head == nullptr || tail == nullptr) {
+      if (head == nullptr || tail == nullptr || seq == nullptr) {
         throw std::runtime_error("BCL: FastQueue does not have enough memory");
       }
 
       *head.local() = 0;
       *tail.local() = 0;
+      std::iota(seq.local(), seq.local() + capacity, 0);
     }
 
     head = BCL::broadcast(head, host);
     tail = BCL::broadcast(tail, host);
+    seq = BCL::broadcast(seq, host);
   }
 
   FastQueue(const FastQueue&) = delete;
@@ -104,6 +120,9 @@ struct FastQueue {
       if (tail != nullptr) {
         dealloc(tail);
       }
+      if (seq != nullptr) {
+        dealloc(seq);
+      }
     }
   }
 
@@ -129,79 +148,79 @@ struct FastQueue {
   }
 
   bool push(const T &val) {
-    int old_tail = BCL::fetch_and_op <int> (tail, 1, BCL::plus <int> ());
-    int new_tail = old_tail + 1;
-
-    if (new_tail - head_buf > capacity()) {
-      head_buf = BCL::rget(head);
-      if (new_tail - head_buf > capacity()) {
-        BCL::fetch_and_op <int> (tail, -1, BCL::plus <int> ());
-        return false;
-      }
-    }
-    data[old_tail % capacity()] = val;
-    return true;
+    return push(&val, 1);
   }
 
   bool pop(T &val) {
-    int old_head = BCL::fetch_and_op <int> (head, 1, BCL::plus <int> ());
-    int new_head = old_head + 1;
-
-    if (new_head > tail_buf) {
-      tail_buf = BCL::rget(tail);
-      if (new_head > tail_buf) {
-        BCL::fetch_and_op<int>(head, -1, BCL::plus<int>{});
-        return false;
-      }
-    }
-
-    val = *data[old_head % capacity()];
-    return true;
+    return pop(&val, 1);
   }
 
   bool push(const std::vector <T> &vals) {
-    int old_tail = BCL::fetch_and_op <int> (tail, vals.size(), BCL::plus <int> ());
-    int new_tail = old_tail + vals.size();
-
-    if (new_tail - head_buf > capacity()) {
-      head_buf = BCL::rget(head);
-      if (new_tail - head_buf > capacity()) {
-        BCL::fetch_and_op <int> (tail, -vals.size(), BCL::plus <int> ());
-        return false;
-      }
-    }
-    data.put(old_tail % capacity(), vals);
-    return true;
+    return push(vals.data(), vals.size());
   }
 
   bool pop(std::vector <T> &vals, const size_t n_to_pop) {
     vals.resize(n_to_pop);
-    int my_tail = BCL::rget(tail);
-    int old_head = BCL::fetch_and_op <int> (head, n_to_pop, BCL::plus <int> ());
-    if (tail_buf - old_head < n_to_pop) {
-      tail_buf = BCL::rget(tail);
-      if (tail_buf - old_head < n_to_pop) {
-        BCL::fetch_and_op <int> (head, -n_to_pop, BCL::plus <int> ());
-        return false;
-      }
+    return pop(vals.data(), n_to_pop);
+  }
+
+  // Push n values straight from the caller's buffer.  Returns
+  // false if the queue does not have room for all n.  The data
+  // goes out in at most two contiguous writes (two only if the
+  // reservation wraps around the ring), followed by the sequence
+  // numbers for the same slots.
+  bool push(const T *vals, const size_t n) {
+    int pos;
+    return push(vals, n, pos);
+  }
+
+  // As above, and sets pos to the position of the first value.
+  // A pushed value has been popped once head passes its position.
+  bool push(const T *vals, const size_t n, int &pos) {
+    pos = tail_buf;
+    if (n == 0) {
+      return true;
+    }
+    int old_tail;
+    if (!ring_().claim(tail, tail_buf, n, 0, old_tail)) {
+      return false;
+    }
+    pos = old_tail;
+
+    ring_().for_each_run(old_tail, n, [&](size_t slot, size_t offset, size_t len) {
+      data.put(slot, vals + offset, len);
+    });
+    ring_().publish(old_tail, n, 1);
+    return true;
+  }
+
+  // Pop n values straight into the caller's buffer.  Returns
+  // false unless n values are ready, i.e. their pushes have
+  // completed.
+  bool pop(T *vals, const size_t n) {
+    if (n == 0) {
+      return true;
+    }
+    int old_head;
+    if (!ring_().claim(head, head_buf, n, 1, old_head)) {
+      return false;
     }
-    data.get(old_head % capacity(), vals, n_to_pop);
+
+    ring_().for_each_run(old_head, n, [&](size_t slot, size_t offset, size_t len) {
+      data.get(slot, vals + offset, len);
+    });
+    ring_().publish(old_head, n, capacity());
     return true;
   }
 
+  // XXX: The sequence numbers must land after the data, so this
+  //      completes the push before returning.  Callers on a hot
+  //      path should push from a reused buffer with push(ptr, n).
   std::experimental::optional<future<std::vector<T>>> push(std::vector<T>&& vals) {
-    int old_tail = BCL::fetch_and_op <int> (tail, vals.size(), BCL::plus <int> ());
-    int new_tail = old_tail + vals.size();
-
-    if (new_tail - head_buf > capacity()) {
-      head_buf = BCL::rget(head);
-      if (new_tail - head_buf > capacity()) {
-        BCL::fetch_and_op <int> (tail, -vals.size(), BCL::plus <int> ());
-        return {};
-      }
+    if (!push(vals.data(), vals.size())) {
+      return {};
     }
-    BCL::GlobalPtr<T> data_ptr = BCL::decay_container(data.data);
-    return BCL::arput(&data_ptr[old_tail % capacity()], std::move(vals));
+    return future<std::vector<T>>(std::move(vals), BCL::request());
   }
 
   // Nonatomic with respect to remote pops or pushes
@@ -210,15 +229,39 @@ struct FastQueue {
       return false;
     }
     int *head_ptr = head.local();
-    int *tail_ptr = tail.local();
-    if (*head_ptr + 1 > *tail_ptr) {
+    size_t slot = *head_ptr % capacity();
+    if (seq.local()[slot] != *head_ptr + 1) {
       return false;
     }
-    val = *data[*head_ptr % capacity()];
+    val = *data[slot];
+    seq.local()[slot] = *head_ptr + capacity();
     *head_ptr += 1;
     return true;
   }
 
+  // Pop one value on the host without claiming head, for a host
+  // that is the queue's only consumer.  Safe against concurrent
+  // remote pushes: seq and head are accessed atomically, and the
+  // window is synced before the value is read locally.
+  bool local_pop(T &val) {
+    if (BCL::rank() != host()) {
+      return false;
+    }
+    int pos = BCL::aget_sync(head);
+    size_t slot = pos % capacity();
+    if (BCL::aget_sync(seq + slot) != pos + 1) {
+      return false;
+    }
+#if !defined(SHMEM) && !defined(GASNET_EX) && !defined(UPCXX)
+    MPI_Win_sync(BCL::win);
+#endif
+    val = *data[slot];
+    BCL::aput_async(pos + int(capacity()), seq + slot);
+    BCL::aput_sync(pos + 1, head);
+    head_buf = pos + 1;
+    return true;
+  }
+
   // TODO: deal properly with queues that wrap around.
   std::vector <T> as_vector() {
     if (BCL::rank() != host()) {
@@ -250,15 +293,13 @@ struct FastQueue {
 
 
   bool pop() {
-    int my_tail = BCL::rget(tail);
-    int old_head = BCL::fetch_and_op <int> (head, 1, BCL::plus <int> ());
-    if (my_tail - old_head < 1) {
-      BCL::fetch_and_op <int> (head, -1, BCL::plus <int> ());
+    int old_head;
+    if (!ring_().claim(head, head_buf, 1, 1, old_head)) {
       return false;
-    } else {
-      data[old_head % capacity()].free();
-      return true;
     }
+    data[old_head % capacity()].free();
+    ring_().publish(old_head, 1, capacity());
+    return true;
   }
 
   void resize(const size_t new_capacity) {
@@ -273,10 +314,17 @@ struct FastQueue {
     if (BCL::rank() == host()) {
       BCL::GlobalPtr <int> new_head = BCL::alloc <int> (1);
       BCL::GlobalPtr <int> new_tail = BCL::alloc <int> (1);
+      BCL::GlobalPtr <int> new_seq = BCL::alloc <int> (new_capacity);
 
       *new_head.local() = 0;
       *new_tail.local() = std::min(size(), new_capacity);
 
+      // Positions [0, new_tail) are full, the rest free.
+      std::iota(new_seq.local(), new_seq.local() + new_capacity, 0);
+      for (int j = 0; j < *new_tail.local(); j++) {
+        new_seq.local()[j] += 1;
+      }
+
       for (int i = *head.local(), j = 0; i < *tail.local() && j < *new_tail.local(); i++, j++) {
         new_data[j] = *data[i % capacity()];
       }
@@ -289,16 +337,21 @@ struct FastQueue {
 
       BCL::dealloc(head);
       BCL::dealloc(tail);
+      BCL::dealloc(seq);
 
       head = new_head;
       tail = new_tail;
+      seq = new_seq;
     }
 
     std::swap(data, new_data);
 
     head = BCL::broadcast(head, host());
     tail = BCL::broadcast(tail, host());
+    seq = BCL::broadcast(seq, host());
     my_capacity = new_capacity;
+    head_buf = 0;
+    tail_buf = 0;
 
     BCL::barrier();
   }
@@ -323,14 +376,17 @@ struct FastQueue {
 
     BCL::GlobalPtr<int> new_head;
     BCL::GlobalPtr<int> new_tail;
+    BCL::GlobalPtr<int> new_seq;
 
     if (BCL::rank() == new_host) {
       new_head = BCL::alloc<int>(1);
       new_tail = BCL::alloc<int>(1);
+      new_seq = BCL::alloc<int>(capacity());
     }
 
     new_head = BCL::broadcast(new_head, new_host);
     new_tail = BCL::broadcast(new_tail, new_host);
+    new_seq = BCL::broadcast(new_seq, new_host);
 
     if (BCL::rank() == host()) {
       for (int i = *head.local(); i < *tail.local(); i++) {
@@ -339,18 +395,22 @@ struct FastQueue {
 
       BCL::rput(*head.local(), new_head);
       BCL::rput(*tail.local(), new_tail);
+      BCL::rput(seq.local(), new_seq, capacity());
 
       BCL::dealloc(head);
       BCL::dealloc(tail);
+      BCL::dealloc(seq);
 
       head = new_head;
       tail = new_tail;
+      seq = new_seq;
     }
 
     std::swap(data, new_data);
 
     head = BCL::broadcast(head, host());
     tail = BCL::broadcast(tail, host());
+    seq = BCL::broadcast(seq, host());
     my_host = new_host;
 
     BCL::barrier();
@@ -369,6 +429,11 @@ struct FastQueue {
       T retrv = this->begin()[idx];
     }
   }
+
+private:
+  BCL::SequencedRing ring_() const {
+    return BCL::SequencedRing(seq, capacity());
+  }
 };
 
 }
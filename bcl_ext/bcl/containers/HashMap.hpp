@@ -24,7 +24,8 @@ template <
   typename T,
   typename Hash = std::hash<Key>,
   typename KeySerialize = BCL::serialize <Key>,
-  typename ValSerialize = BCL::serialize <T>
+  typename ValSerialize = BCL::serialize <T>,
+  typename TeamType = BCL::WorldTeam
   >
 class HashMap {
 public:
@@ -37,6 +38,7 @@ public:
   using difference_type = std::ptrdiff_t;
 
   using hasher = Hash;
+  using team_type = TeamType;
 
   using HME = HashMapEntry <Key, T, KeySerialize, ValSerialize>;
   using KPTR = typename BCL::GlobalPtr <BCL::Container <Key, KeySerialize>>;
@@ -51,7 +53,7 @@ public:
   HashMap() = delete;
 
   // Initialize a HashMap of at least size size.
-  HashMap(size_type capacity) : capacity_(capacity), team_ptr_(new BCL::WorldTeam()) {
+  HashMap(size_type capacity) : capacity_(capacity) {
     local_capacity_ = (capacity_ + BCL::nprocs(team()) - 1) / BCL::nprocs(team());
     hash_table_.resize(BCL::nprocs(team()), nullptr);
 
@@ -72,7 +74,9 @@ public:
     BCL::barrier();
   }
 
-  HashMap(size_type capacity, const BCL::Team& team_) : capacity_(capacity), team_ptr_(team_.clone()) {
+  // With TeamType = BCL::Team, any team may be passed, at the
+  // cost of a virtual call per rank translation.
+  HashMap(size_type capacity, const TeamType& team_) : capacity_(capacity), team_holder_(team_) {
     local_capacity_ = (capacity_ + BCL::nprocs(team()) - 1) / BCL::nprocs(team());
     hash_table_.resize(BCL::nprocs(team()), nullptr);
 
@@ -104,8 +108,8 @@ public:
     }
   }
 
-  const BCL::Team& team() const {
-    return *team_ptr_;
+  const TeamType& team() const {
+    return team_holder_.get();
   }
 
   KPTR key_ptr(size_type slot) {
@@ -426,7 +430,7 @@ public:
   size_type capacity_;
   size_type local_capacity_;
 
-  std::unique_ptr<BCL::Team> team_ptr_;
+  BCL::team_holder<TeamType> team_holder_;
 
   Hash hash_fn_;
 
@@ -3,9 +3,12 @@
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <memory>
+#include <algorithm>
 
 #include <bcl/bcl.hpp>
 #include <bcl/containers/FastQueue.hpp>
+#include <bcl/containers/detail/NodeMap.hpp>
 
 namespace BCL {
 
@@ -31,7 +34,39 @@ struct HashMapBuffer {
 
   std::vector <BCL::FastQueue <HME>> queues;
   std::vector <std::vector <HME>> buffers;
-  std::vector <BCL::future <std::vector <HME>>> futures;
+
+  // With node aggregation, entries bound for another node are buffered
+  // per relay, the rank on this node that serves their node.  Relays
+  // coalesce them per node and push them to that node's receiver,
+  // which hands them to their owners through queues.  Entries for
+  // this node go straight to their owners via local_buffers.
+  std::unique_ptr <NodeMap> nodes;
+  std::vector <BCL::FastQueue <HME>> relay_queues;
+  std::vector <BCL::FastQueue <HME>> node_queues;
+  std::vector <std::vector <HME>> node_buffers;
+  std::vector <std::vector <HME>> local_buffers;
+
+  // Termination detection for flush().  Every rank counts the entries
+  // it pushes to each host's queues of each kind (sent) and pops from
+  // its own (received).  Once done pushing to one kind of queue, it
+  // adds its count plus report_unit to a word per kind on every host
+  // (reports).  A host has popped everything once all nprocs() reports
+  // are in and the counts in them add up to received.
+  constexpr static size_t owner_kind = 0;
+  constexpr static size_t relay_kind = 1;
+  constexpr static size_t node_kind = 2;
+  constexpr static size_t n_kinds = 3;
+
+  constexpr static uint64_t report_unit = uint64_t(1) << 40;
+
+  std::vector <BCL::GlobalPtr <uint64_t>> reports;
+  std::vector <std::vector <uint64_t>> sent;
+  std::vector <uint64_t> received;
+  std::vector <uint64_t> report_vals;
+
+  // Popped entries that did not fit in the local segment.  They
+  // are inserted remotely at the end of flush().
+  std::vector <HME> failed_inserts;
 
   HashMapBuffer(const HashMapBuffer&) = delete;
   HashMapBuffer& operator=(const HashMapBuffer&) = delete;
@@ -40,7 +75,12 @@ struct HashMapBuffer {
   HashMapBuffer& operator=(HashMapBuffer&&) = default;
 
   HashMapBuffer() = delete;
-  ~HashMapBuffer() = default;
+
+  ~HashMapBuffer() {
+    if (!reports.empty() && !BCL::bcl_finalized) {
+      BCL::dealloc(reports[BCL::rank()]);
+    }
+  }
 
   size_t buffer_size;
 
@@ -61,97 +101,318 @@ struct HashMapBuffer {
     for (auto& buffer : buffers) {
       buffer.reserve(buffer_size);
     }
+
+    init_reports_();
+  }
+
+  // Two-level aggregation.  Each rank keeps buffers for the ranks on
+  // its node only, and messages between nodes carry the entries of
+  // all ranks on the sending node.  Collective.
+  //
+  // Every rank hosts three queues of queue_capacity entries (owner,
+  // relay and node), so this takes three times the queue memory of
+  // the constructor above; pass a third of the capacity to keep the
+  // same footprint.  The buffers shrink from nprocs() to a few per
+  // rank on the node.
+  HashMapBuffer(hashmap_type& hashmap, size_t queue_capacity,
+                size_t buffer_size, const NodeMap& nodes) {
+    this->hashmap = &hashmap;
+    this->buffer_size = buffer_size;
+    this->nodes.reset(new NodeMap(nodes));
+
+    for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+      queues.emplace_back(rank, queue_capacity);
+      relay_queues.emplace_back(rank, queue_capacity);
+      node_queues.emplace_back(rank, queue_capacity);
+    }
+
+    size_t n_local = nodes.n_local(nodes.node());
+    buffers.resize(std::min(n_local, nodes.n_nodes()));
+    local_buffers.resize(n_local);
+    node_buffers.resize(nodes.n_nodes());
+
+    for (auto& buffer : buffers) {
+      buffer.reserve(buffer_size);
+    }
+    for (auto& buffer : local_buffers) {
+      buffer.reserve(buffer_size);
+    }
+
+    init_reports_();
   }
 
+  // Returns false if a full buffer could not be pushed.  Its
+  // entries stay buffered and go out on a later push or flush().
   bool insert(const Key& key, const T& val) {
     size_t hash = hashmap->hash_fn_(key);
     size_t slot = hash % hashmap->capacity();
     size_t node = slot / hashmap->local_capacity();
+
+    if (nodes) {
+      return node_insert_(node, HME(key, val));
+    }
+
     buffers[node].push_back(HME(key, val));
 
     if (buffers[node].size() >= buffer_size) {
-      auto future = queues[node].push(std::move(buffers[node]));
-      if (bool(future)) {
-        futures.emplace_back(std::move(future.value()));
-        buffers[node].reserve(buffer_size);
-        return true;
-      } else {
-        return false;
-      }
+      bool success = push_buffer_(buffers[node], owner_kind, node, buffer_size);
+      progress();
+      return success;
     } else {
       return true;
     }
   }
 
+  // Insert the entries that have arrived in this rank's queues, and
+  // in node aggregation mode forward those it relays or receives.
+  // Never waits on other ranks.  Returns the number of entries popped.
+  size_t progress() {
+    return progress_(false);
+  }
+
+  // Collective.  Each rank keeps inserting arriving entries while its
+  // own are still being pushed, and leaves once every rank has
+  // reported its pushes and it has popped all of them.  Returns false
+  // if the hash table is full.
   bool flush() {
-    bool full_queues = false;
-    bool success = true;
-    do {
-      // Flush local buffers to remote queues.
-      // Only returns false if remote queues
-      // are full.
-      full_queues = !flush_buffers();
-
-      for (auto& future : futures) {
-        future.get();
-      }
-      futures.clear();
-      BCL::barrier();
-      // Flush local queues to hash table.
-      // Only returns false if hash table is full.
-      success = flush_queues();
-    } while (success && full_queues);
-    return success;
+    flush_buffers();
+    return flush_queues();
   }
 
-  // Flush HMEs sitting in local queues
+  // Collective.  The first half of flush(): push out every buffer,
+  // inserting arriving entries meanwhile so that full queues drain,
+  // and report the counts pushed to every rank.  Must be followed by
+  // flush_queues() before the next insert().  Always returns true.
+  bool flush_buffers() {
+    if (nodes) {
+      finish_(relay_kind, buffers);
+      finish_(node_kind, node_buffers, relay_kind);
+      finish_(owner_kind, local_buffers, node_kind);
+    } else {
+      finish_(owner_kind, buffers);
+    }
+    return true;
+  }
+
+  // Collective.  The second half of flush(): insert entries until all
+  // those reported to this rank have been popped, then reset the
+  // counters and insert remotely the entries that did not fit in the
+  // local segment.  Returns false if the hash table is full.
   bool flush_queues() {
-    std::vector <HME> failed_inserts;
-    int num = 0;
-    bool success;
-    HME entry;
-    do {
-      num++;
-      success = queues[BCL::rank()].local_nonatomic_pop(entry);
-      if (success) {
-        bool inserted = hashmap->local_nonatomic_insert(entry);
-        if (!inserted) {
-          failed_inserts.push_back(entry);
-        }
-      }
-    } while (success);
-    BCL::barrier();
+    while (!complete_(owner_kind)) {
+      progress_(true);
+    }
+
+    // Everyone has reported, so the counters can be reset before
+    // anyone can start the next flush.
+    for (auto& counts : sent) {
+      std::fill(counts.begin(), counts.end(), 0);
+    }
+    std::fill(received.begin(), received.end(), 0);
+    // Reports are written by remote accumulates, so reset
+    // them atomically too.
+    std::vector <uint64_t> zeros(n_kinds, 0);
+    BCL::awrite_sync(zeros.data(), reports[BCL::rank()], n_kinds);
+
+    // Remote inserts must wait until all local inserts are done.
+    uint64_t n_failed = BCL::allreduce<uint64_t>(failed_inserts.size(),
+                                                 BCL::plus<uint64_t>());
+    if (n_failed == 0) {
+      return true;
+    }
 
-    success = true;
+    bool success = true;
     for (HME &entry : failed_inserts) {
       if (!hashmap->insert_atomic_impl_(entry.get_key(), entry.get_val())) {
         success = false;
         break;
       }
     }
+    failed_inserts.clear();
 
     int success_ = (success) ? 0 : 1;
-    success_ = BCL::allreduce(success_, std::plus <int> ());
+    success_ = BCL::allreduce(success_, BCL::plus <int> ());
 
     return (success_ == 0);
   }
 
-  // Flush local HME buffers to remote queues
-  bool flush_buffers() {
-    bool success = true;
-    for (int rank = 0; rank < buffers.size(); rank++) {
-      auto future = queues[rank].push(std::move(buffers[rank]));
-      if (bool(future)) {
-        futures.emplace_back(std::move(future.value()));
-      } else {
-        success = false;
+private:
+  void init_reports_() {
+    sent.assign(n_kinds, std::vector<uint64_t>(BCL::nprocs(), 0));
+    received.assign(n_kinds, 0);
+    report_vals.resize(BCL::nprocs());
+
+    BCL::GlobalPtr<uint64_t> mine = BCL::alloc<uint64_t>(n_kinds);
+    if (mine == nullptr) {
+      throw std::runtime_error("BCL: HashMapBuffer does not have enough memory");
+    }
+    std::fill(mine.local(), mine.local() + n_kinds, 0);
+
+    for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+      BCL::GlobalPtr<uint64_t> ptr = mine;
+      reports.push_back(BCL::broadcast(ptr, rank));
+    }
+  }
+
+  std::vector <BCL::FastQueue <HME>>& queues_(size_t kind) {
+    if (kind == relay_kind) {
+      return relay_queues;
+    } else if (kind == node_kind) {
+      return node_queues;
+    } else {
+      return queues;
+    }
+  }
+
+  size_t owner_(const HME& entry) const {
+    size_t slot = hashmap->hash_fn_(entry.get_key()) % hashmap->capacity();
+    return slot / hashmap->local_capacity();
+  }
+
+  size_t relay_(size_t node) const {
+    return nodes->ranks(nodes->node())[node % nodes->n_local(nodes->node())];
+  }
+
+  size_t receiver_(size_t node) const {
+    return nodes->ranks(node)[nodes->node() % nodes->n_local(node)];
+  }
+
+  size_t node_push_() const {
+    return buffer_size * nodes->n_local(nodes->node());
+  }
+
+  bool node_insert_(size_t owner, const HME& entry) {
+    size_t node = nodes->node(owner);
+    bool success;
+    if (node == nodes->node()) {
+      auto& buffer = local_buffers[nodes->local_rank(owner)];
+      buffer.push_back(entry);
+      if (buffer.size() < buffer_size) {
+        return true;
+      }
+      success = push_buffer_(buffer, owner_kind, owner, buffer_size);
+    } else {
+      auto& buffer = buffers[node % buffers.size()];
+      buffer.push_back(entry);
+      if (buffer.size() < buffer_size) {
+        return true;
       }
+      success = push_buffer_(buffer, relay_kind, relay_(node), buffer_size);
     }
+    progress();
+    return success;
+  }
 
-    int success_ = (success) ? 0 : 1;
-    success_ = BCL::allreduce(success_, std::plus <int> ());
+  // Push buffer to the queue of kind on rank in pieces of at most
+  // max_push entries, keeping whatever does not fit.
+  bool push_buffer_(std::vector <HME>& buffer, size_t kind, size_t rank,
+                    size_t max_push) {
+    auto& queue = queues_(kind)[rank];
+    max_push = std::max<size_t>(std::min<size_t>(max_push, queue.capacity()), 1);
+    while (!buffer.empty()) {
+      size_t n = std::min(buffer.size(), max_push);
+      if (!queue.push(buffer.data() + buffer.size() - n, n)) {
+        return false;
+      }
+      buffer.resize(buffer.size() - n);
+      sent[kind][rank] += n;
+    }
+    return true;
+  }
 
-    return (success_ == 0);
+  bool pop_(size_t kind, HME& entry) {
+    if (queues_(kind)[BCL::rank()].local_pop(entry)) {
+      received[kind]++;
+      return true;
+    }
+    return false;
+  }
+
+  // Pop everything that has arrived.  Buffers are pushed once full,
+  // or, with push_all, whenever they are not empty.
+  size_t progress_(bool push_all) {
+    size_t n_popped = 0;
+    HME entry;
+
+    if (nodes) {
+      // As a relay, coalesce entries per node.
+      while (pop_(relay_kind, entry)) {
+        n_popped++;
+        size_t node = nodes->node(owner_(entry));
+        auto& buffer = node_buffers[node];
+        buffer.push_back(entry);
+        if (buffer.size() >= node_push_()) {
+          push_buffer_(buffer, node_kind, receiver_(node), node_push_());
+        }
+      }
+
+      // As a receiver, hand entries to their owners on this node.
+      while (pop_(node_kind, entry)) {
+        n_popped++;
+        size_t owner = owner_(entry);
+        auto& buffer = local_buffers[nodes->local_rank(owner)];
+        buffer.push_back(entry);
+        if (buffer.size() >= buffer_size) {
+          push_buffer_(buffer, owner_kind, owner, buffer_size);
+        }
+      }
+
+      if (push_all) {
+        const auto& my_ranks = nodes->ranks(nodes->node());
+        for (size_t i = 0; i < buffers.size(); i++) {
+          push_buffer_(buffers[i], relay_kind, my_ranks[i], buffer_size);
+        }
+        for (size_t node = 0; node < node_buffers.size(); node++) {
+          push_buffer_(node_buffers[node], node_kind, receiver_(node), node_push_());
+        }
+        for (size_t i = 0; i < local_buffers.size(); i++) {
+          push_buffer_(local_buffers[i], owner_kind, my_ranks[i], buffer_size);
+        }
+      }
+    } else if (push_all) {
+      for (size_t rank = 0; rank < buffers.size(); rank++) {
+        push_buffer_(buffers[rank], owner_kind, rank, buffer_size);
+      }
+    }
+
+    while (pop_(owner_kind, entry)) {
+      n_popped++;
+      if (!hashmap->local_nonatomic_insert(entry)) {
+        failed_inserts.push_back(entry);
+      }
+    }
+    return n_popped;
+  }
+
+  // True once everything pushed to this rank's queue of kind
+  // has been popped.  The report is read atomically, since
+  // other ranks may be accumulating into it.
+  bool complete_(size_t kind) {
+    uint64_t report = BCL::aget_sync(reports[BCL::rank()] + kind);
+    return report / report_unit == BCL::nprocs() &&
+           report % report_unit == received[kind];
+  }
+
+  // Push out the buffers feeding queues of kind, after the queues
+  // of kind prev feeding those buffers are complete, then report.
+  void finish_(size_t kind, std::vector <std::vector <HME>>& feed,
+               size_t prev = n_kinds) {
+    auto empty = [](const std::vector <HME>& buffer) { return buffer.empty(); };
+    while ((prev < n_kinds && !complete_(prev)) ||
+           !std::all_of(feed.begin(), feed.end(), empty)) {
+      progress_(true);
+    }
+
+    std::vector <BCL::request> requests;
+    for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+      report_vals[rank] = sent[kind][rank] + report_unit;
+      requests.push_back(BCL::async_accumulate(report_vals.data() + rank,
+                                               reports[rank] + kind, 1,
+                                               BCL::plus<uint64_t>()));
+    }
+    for (auto& request : requests) {
+      request.wait();
+    }
   }
 };
 
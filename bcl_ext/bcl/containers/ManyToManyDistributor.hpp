@@ -4,37 +4,54 @@
 
 #include <vector>
 #include <list>
+#include <deque>
+#include <functional>
+#include <stdexcept>
 
 namespace BCL {
 
-template <typename T, typename Serialize = BCL::serialize<T>>
+template <typename T, typename Serialize = BCL::serialize<T>,
+          typename TeamType = BCL::WorldTeam>
 class ManyToManyDistributor {
   std::vector<std::vector<T>> buffers;
   std::vector<BCL::FastQueue<T, Serialize>> queues;
 
-  std::list<BCL::future<std::vector<T>>> futures;
-
   size_t message_size_;
   size_t queue_size_;
 
-  std::unique_ptr<BCL::Team> team_ptr_;
+  BCL::team_holder<TeamType> team_holder_;
+
+  // Streaming mode, enabled by set_handler().  A sender may have
+  // at most credit_ values outstanding in any one receiver's
+  // queue, where a value stops being outstanding once the
+  // receiver's head passes it.  in_flight_[rank] holds the end
+  // position and size of each outstanding push to rank.
+  std::function<void(const T&)> handler_;
+  size_t credit_ = 0;
+  std::vector<std::deque<std::pair<int, size_t>>> in_flight_;
+  std::vector<size_t> n_in_flight_;
+
+  // done_[rank] counts senders that have finished a stream
+  // to rank; flushes_ counts the streams we have finished.
+  std::vector<BCL::GlobalPtr<int>> done_;
+  int flushes_ = 0;
 
 public:
 
   using value_type = T;
+  using team_type = TeamType;
 
   ManyToManyDistributor(const ManyToManyDistributor&) = delete;
   ManyToManyDistributor(ManyToManyDistributor&&) = default;
 
-  const BCL::Team& team() const {
-    return *team_ptr_;
+  const TeamType& team() const {
+    return team_holder_.get();
   }
 
-  template <typename TeamType>
   ManyToManyDistributor(size_t queue_size, size_t message_size,
                         const TeamType& team) :
                         message_size_(message_size), queue_size_(queue_size),
-                        team_ptr_(team.clone()) {
+                        team_holder_(team) {
     buffers.resize(BCL::nprocs(this->team()));
 
     if (this->team().in_team()) {
@@ -46,11 +63,11 @@ public:
     for (size_t rank = 0; rank < BCL::nprocs(this->team()); rank++) {
       queues.push_back(BCL::FastQueue<T, Serialize>(this->team().to_world(rank), queue_size));
     }
+    alloc_done_();
   }
 
   ManyToManyDistributor(size_t queue_size, size_t message_size) :
-                        message_size_(message_size), queue_size_(queue_size),
-                        team_ptr_(new BCL::WorldTeam()) {
+                        message_size_(message_size), queue_size_(queue_size) {
     buffers.resize(BCL::nprocs(team()));
 
     if (team().in_team()) {
@@ -62,6 +79,47 @@ public:
     for (size_t rank = 0; rank < BCL::nprocs(team()); rank++) {
       queues.push_back(BCL::FastQueue<T, Serialize>(team().to_world(rank), queue_size));
     }
+    alloc_done_();
+  }
+
+  ~ManyToManyDistributor() {
+    if (!BCL::bcl_finalized && !done_.empty() && team().in_team()) {
+      if (done_[BCL::rank(team())] != nullptr) {
+        BCL::dealloc(done_[BCL::rank(team())]);
+      }
+    }
+  }
+
+  // Switch to streaming mode.  Values sent to this rank are passed
+  // to fn as they arrive, by drain() or from within insert() and
+  // flush().  insert() no longer fails when a remote queue is
+  // full; it waits for credit, handling incoming values meanwhile.
+  // fn must not call insert().
+  template <typename Fn>
+  void set_handler(Fn&& fn) {
+    credit_ = queue_size_ / BCL::nprocs(team());
+    if (credit_ == 0) {
+      throw std::runtime_error("BCL::ManyToManyDistributor: queue_size too small for streaming on " +
+                               std::to_string(BCL::nprocs(team())) + " ranks");
+    }
+    handler_ = std::forward<Fn>(fn);
+    in_flight_.resize(BCL::nprocs(team()));
+    n_in_flight_.resize(BCL::nprocs(team()), 0);
+  }
+
+  // Pass each value that has arrived in this rank's queue
+  // to fn, in order.  May run while other ranks are still
+  // inserting.  Returns the number of values handled.
+  template <typename Fn>
+  size_t drain(Fn&& fn) {
+    auto& queue = queues[BCL::rank(team())];
+    size_t n_handled = 0;
+    T value;
+    while (queue.local_pop(value)) {
+      fn(value);
+      n_handled++;
+    }
+    return n_handled;
   }
 
   // Insert value into the queue owned by rank,
@@ -71,30 +129,31 @@ public:
     assert(rank < buffers.size());
     buffers[rank].push_back(value);
 
-    if (buffers[rank].size() >= message_size_) {
-      auto future = queues[rank].push(std::move(buffers[rank]));
-      if (!future.has_value()) {
+    if (handler_ && buffers[rank].size() >= message_size_) {
+      stream_push_(rank);
+    } else if (buffers[rank].size() >= message_size_) {
+      if (!queues[rank].push(buffers[rank].data(), buffers[rank].size())) {
         return false;
       }
-      futures.emplace_back(std::move(future.value()));
-      buffers[rank].reserve(message_size_);
+      buffers[rank].clear();
     }
     return true;
   }
 
+  // In streaming mode, returns once every value sent to this
+  // rank has been handled, without a barrier.
   bool flush() {
+    if (handler_) {
+      flush_stream_();
+      return true;
+    }
+
     for (size_t rank = 0; rank < buffers.size(); rank++) {
-      auto future = queues[rank].push(std::move(buffers[rank]));
-      if (!future.has_value()) {
+      if (!queues[rank].push(buffers[rank].data(), buffers[rank].size())) {
         return false;
       }
-      futures.emplace_back(std::move(future.value()));
-    }
-
-    for (auto& future : futures) {
-      future.get();
+      buffers[rank].clear();
     }
-    // futures.clear();
 
     BCL::barrier();
     return true;
@@ -111,6 +170,76 @@ public:
   auto end() const {
     return queues[BCL::rank(team())].end();
   }
+
+private:
+  void alloc_done_() {
+    done_.resize(BCL::nprocs(team()), nullptr);
+    for (size_t rank = 0; rank < BCL::nprocs(team()); rank++) {
+      if (BCL::rank() == team().to_world(rank)) {
+        done_[rank] = BCL::alloc<int>(1);
+        if (done_[rank] == nullptr) {
+          throw std::runtime_error("BCL::ManyToManyDistributor: ran out of memory");
+        }
+        *done_[rank].local() = 0;
+      }
+      done_[rank] = BCL::broadcast(done_[rank], team().to_world(rank));
+    }
+  }
+
+  // Credit left for pushes to rank.  Only re-reads the
+  // receiver's head when the cached credit is short of wanted.
+  size_t credit_for_(size_t rank, size_t wanted) {
+    if (credit_ - n_in_flight_[rank] < wanted) {
+      int head = BCL::rget(queues[rank].head);
+      auto& flights = in_flight_[rank];
+      while (!flights.empty() && flights.front().first <= head) {
+        n_in_flight_[rank] -= flights.front().second;
+        flights.pop_front();
+      }
+    }
+    return credit_ - n_in_flight_[rank];
+  }
+
+  // Push all of buffers[rank], in pieces no larger than our
+  // credit, handling incoming values while we wait.
+  void stream_push_(size_t rank) {
+    const T* vals = buffers[rank].data();
+    size_t n = buffers[rank].size();
+    size_t offset = 0;
+    while (offset < n) {
+      size_t len = std::min(n - offset, credit_for_(rank, n - offset));
+      int pos;
+      // The push can still fail briefly while the receiver
+      // finishes reading slots it has already claimed.
+      if (len > 0 && queues[rank].push(vals + offset, len, pos)) {
+        in_flight_[rank].emplace_back(pos + int(len), len);
+        n_in_flight_[rank] += len;
+        offset += len;
+      } else {
+        drain(handler_);
+      }
+    }
+    buffers[rank].clear();
+  }
+
+  void flush_stream_() {
+    for (size_t rank = 0; rank < buffers.size(); rank++) {
+      stream_push_(rank);
+    }
+
+    // Our values must land before the done counts do.
+    BCL::flush();
+    for (size_t rank = 0; rank < done_.size(); rank++) {
+      BCL::fetch_and_op<int>(done_[rank], 1, BCL::plus<int>());
+    }
+    flushes_++;
+
+    int expected = flushes_ * int(BCL::nprocs(team()));
+    while (BCL::rget(done_[BCL::rank(team())]) < expected) {
+      drain(handler_);
+    }
+    drain(handler_);
+  }
 };
 
 }
@@ -15,6 +15,9 @@
 #include <bcl/containers/sequential/CSRMatrix.hpp>
 #include <bcl/containers/sequential/SparseAccumulator.hpp>
 #include <bcl/containers/detail/Blocking.hpp>
+#include <bcl/containers/detail/MatrixMarket.hpp>
+#include <bcl/containers/detail/TileFile.hpp>
+#include <bcl/containers/detail/TileCache.hpp>
 
 namespace BCL
 {
@@ -83,6 +86,9 @@ public:
 
   std::unique_ptr<BCL::Team> team_ptr_;
 
+  // Identifies this matrix in BCL::tile_cache().
+  size_t cache_id_ = BCL::TileCache::new_id();
+
   SPMatrix(const SPMatrix&) = delete;
   SPMatrix(SPMatrix&&) = default;
 
@@ -99,33 +105,134 @@ public:
     init(fname, std::move(blocking), format);
   }
 
+  // An m x n matrix with no nonzeros, e.g. to hold a product.
+  template <typename TeamType>
+  SPMatrix(size_t m, size_t n, Block&& blocking, const TeamType& team) :
+           team_ptr_(team.clone()) {
+    init_empty_(m, n, std::move(blocking));
+  }
+
+  SPMatrix(size_t m, size_t n, Block&& blocking = BCL::BlockOpt()) :
+           team_ptr_(new BCL::WorldTeam()) {
+    init_empty_(m, n, std::move(blocking));
+  }
+
+  void init_empty_(size_t m, size_t n, Block&& blocking) {
+    init_shape_(m, n, 0, blocking);
+
+    for (size_t i = 0; i < grid_shape()[0]; i++) {
+      for (size_t j = 0; j < grid_shape()[1]; j++) {
+        size_t proc = tile_owner_(i, j);
+
+        BCL::GlobalPtr<T> vals;
+        BCL::GlobalPtr<index_type> col_ind;
+        BCL::GlobalPtr<index_type> row_ptr;
+        if (BCL::rank() == proc) {
+          size_t tile_m = tile_shape(i, j)[0];
+          vals = BCL::alloc<T>(1);
+          col_ind = BCL::alloc<index_type>(1);
+          row_ptr = BCL::alloc<index_type>(tile_m+1);
+
+          if (vals == nullptr || col_ind == nullptr || row_ptr == nullptr) {
+            throw std::runtime_error("SMatrix: ran out of memory!");
+          }
+          std::fill(row_ptr.local(), row_ptr.local() + tile_m+1, 0);
+        }
+        add_tile_(proc, 0, vals, col_ind, row_ptr);
+      }
+    }
+  }
+
+  // MatrixMarket files are read in parallel, each rank parsing
+  // part of the file and sending nonzeros to their tiles' owners.
+  // Tiled files (written by save()) keep their own blocking, and
+  // each owner reads its tiles directly.  Binary files are read
+  // whole on every rank.
   void init(const std::string& fname, Block&& blocking, FileFormat format = FileFormat::MatrixMarket) {
-    CSRMatrix<T, index_type> mat(fname, format);
+    if (format == FileFormat::Tiled) {
+      init_tiled_(fname);
+    } else if (format == FileFormat::Binary) {
+      init_replicated_(fname, std::move(blocking), format);
+    } else {
+      init_partitioned_(fname, std::move(blocking),
+                        format == FileFormat::MatrixMarket);
+    }
+  }
 
-    m_ = mat.m_;
-    n_ = mat.n_;
-    nnz_ = mat.nnz_;
+  void init_partitioned_(const std::string& fname, Block&& blocking, bool one_indexed) {
+    MatrixMarketInfo info = read_MatrixMarket_header(fname);
+    init_shape_(info.m, info.n, info.nnz, blocking);
 
-    blocking.seed(mat.m_, mat.n_, BCL::nprocs(this->team()));
+    using entry_type = MatrixMarketEntry<T>;
+    std::vector<std::vector<entry_type>> entries(grid_shape()[0]*grid_shape()[1]);
 
-    pm_ = blocking.pgrid_shape()[0];
-    pn_ = blocking.pgrid_shape()[1];
+    read_MatrixMarket_distributed<T>(fname, info, one_indexed,
+      [&](size_t i, size_t j) {
+        if (i >= m_ || j >= n_) {
+          throw std::runtime_error("SPMatrix: " + fname + " has an entry out of bounds.");
+        }
+        return tile_owner_(i / tile_size_m_, j / tile_size_n_);
+      },
+      [&](const entry_type& entry) {
+        size_t tile = (entry.i / tile_size_m_)*grid_shape()[1] + entry.j / tile_size_n_;
+        entries[tile].push_back(entry);
+      });
 
-    tile_size_m_ = blocking.tile_shape()[0];
-    tile_size_n_ = blocking.tile_shape()[1];
+    for (size_t i = 0; i < grid_shape()[0]; i++) {
+      for (size_t j = 0; j < grid_shape()[1]; j++) {
+        size_t proc = tile_owner_(i, j);
 
-    if (pm_*pn_ > BCL::nprocs()) {
-      throw std::runtime_error("DMatrix: tried to create a DMatrix with a too large p-grid.");
+        size_t nnz;
+        BCL::GlobalPtr<T> vals;
+        BCL::GlobalPtr<index_type> col_ind;
+        BCL::GlobalPtr<index_type> row_ptr;
+        if (BCL::rank() == proc) {
+          auto& tile = entries[j + i*grid_shape()[1]];
+          std::sort(tile.begin(), tile.end(),
+                    [](const entry_type& a, const entry_type& b) {
+                      return std::tie(a.i, a.j) < std::tie(b.i, b.j);
+                    });
+
+          size_t m = tile_shape(i, j)[0];
+          nnz = tile.size();
+          vals = BCL::alloc<T>(std::max<size_t>(1, nnz));
+          col_ind = BCL::alloc<index_type>(std::max<size_t>(1, nnz));
+          row_ptr = BCL::alloc<index_type>(m+1);
+
+          if (vals == nullptr || col_ind == nullptr || row_ptr == nullptr) {
+            throw std::runtime_error("SMatrix: ran out of memory!");
+          }
+
+          size_t row = 0;
+          row_ptr.local()[0] = 0;
+          for (size_t k = 0; k < nnz; k++) {
+            size_t tile_row = tile[k].i - i*tile_size_m_;
+            for ( ; row < tile_row; row++) {
+              row_ptr.local()[row+1] = k;
+            }
+            vals.local()[k] = tile[k].value;
+            col_ind.local()[k] = tile[k].j - j*tile_size_n_;
+          }
+          for ( ; row < m; row++) {
+            row_ptr.local()[row+1] = nnz;
+          }
+
+          std::vector<entry_type>().swap(tile);
+        }
+        add_tile_(proc, nnz, vals, col_ind, row_ptr);
+      }
     }
 
-    grid_dim_m_ = (m_ + tile_size_m_ - 1) / tile_size_m_;
-    grid_dim_n_ = (n_ + tile_size_n_ - 1) / tile_size_n_;
+    nnz_ = std::accumulate(nnzs_.begin(), nnzs_.end(), size_type(0));
+  }
+
+  void init_replicated_(const std::string& fname, Block&& blocking, FileFormat format) {
+    CSRMatrix<T, index_type> mat(fname, format);
+    init_shape_(mat.m_, mat.n_, mat.nnz_, blocking);
 
     for (size_t i = 0; i < grid_shape()[0]; i++) {
       for (size_t j = 0; j < grid_shape()[1]; j++) {
-        size_t lpi = i % pm_;
-        size_t lpj = j % pn_;
-        size_t proc = lpj + lpi*pn_;
+        size_t proc = tile_owner_(i, j);
 
         size_t nnz;
         BCL::GlobalPtr<T> vals;
@@ -147,19 +254,148 @@ public:
           std::memcpy(col_ind.local(), slc.col_ind_.data(), sizeof(index_type)*slc.col_ind_.size());
           std::memcpy(row_ptr.local(), slc.row_ptr_.data(), sizeof(index_type)*slc.row_ptr_.size());
         }
-        nnz = BCL::broadcast(nnz, proc);
-        vals = BCL::broadcast(vals, proc);
-        col_ind = BCL::broadcast(col_ind, proc);
-        row_ptr = BCL::broadcast(row_ptr, proc);
-
-        nnzs_.push_back(nnz);
-        vals_.push_back(vals);
-        col_ind_.push_back(col_ind);
-        row_ptr_.push_back(row_ptr);
+        add_tile_(proc, nnz, vals, col_ind, row_ptr);
       }
     }
   }
 
+  void init_tiled_(const std::string& fname) {
+    TileFileHeader header;
+    std::vector<TileFileEntry> tiles;
+    int fd = open_tile_file(fname, header, tiles);
+
+    if (!header.sparse || header.value_size != sizeof(T) ||
+        header.index_size != sizeof(index_type)) {
+      close(fd);
+      throw std::runtime_error("SPMatrix: " + fname + " does not hold a matrix of this type.");
+    }
+
+    // Restarting on fewer ranks than wrote the file
+    // keeps the tiles, but not the processor grid.
+    size_t pm = header.pm;
+    size_t pn = header.pn;
+    if (pm*pn > BCL::nprocs(this->team())) {
+      std::vector<size_t> pgrid = factor(BCL::nprocs(this->team()));
+      pm = pgrid[0];
+      pn = pgrid[1];
+    }
+    BCL::BlockCustom blocking({header.tile_m, header.tile_n}, {pm, pn});
+    init_shape_(header.m, header.n, header.nnz, blocking);
+
+    for (size_t i = 0; i < grid_shape()[0]; i++) {
+      for (size_t j = 0; j < grid_shape()[1]; j++) {
+        size_t proc = tile_owner_(i, j);
+        const TileFileEntry& entry = tiles[j + i*grid_shape()[1]];
+
+        size_t nnz = entry.nnz;
+        BCL::GlobalPtr<T> vals;
+        BCL::GlobalPtr<index_type> col_ind;
+        BCL::GlobalPtr<index_type> row_ptr;
+        if (BCL::rank() == proc) {
+          size_t m = tile_shape(i, j)[0];
+          vals = BCL::alloc<T>(std::max<size_t>(1, nnz));
+          col_ind = BCL::alloc<index_type>(std::max<size_t>(1, nnz));
+          row_ptr = BCL::alloc<index_type>(m+1);
+
+          if (vals == nullptr || col_ind == nullptr || row_ptr == nullptr) {
+            throw std::runtime_error("SMatrix: ran out of memory!");
+          }
+
+          size_t offset = entry.offset;
+          tile_file_pread_(fd, vals.local(), sizeof(T)*nnz, offset);
+          offset += tile_file_round_up_(sizeof(T)*nnz, 8);
+          tile_file_pread_(fd, col_ind.local(), sizeof(index_type)*nnz, offset);
+          offset += tile_file_round_up_(sizeof(index_type)*nnz, 8);
+          tile_file_pread_(fd, row_ptr.local(), sizeof(index_type)*(m+1), offset);
+        }
+        add_tile_(proc, nnz, vals, col_ind, row_ptr);
+      }
+    }
+    close(fd);
+
+    nnz_ = std::accumulate(nnzs_.begin(), nnzs_.end(), size_type(0));
+  }
+
+  // Collective.  Checkpoint the matrix to fname, each rank writing
+  // its own tiles.  Reload with FileFormat::Tiled.
+  void save(const std::string& fname) const {
+    TileFileHeader header = make_tile_file_header_(true, sizeof(T), sizeof(index_type),
+                                                   m_, n_, nnz_,
+                                                   tile_size_m_, tile_size_n_,
+                                                   grid_dim_m_, grid_dim_n_,
+                                                   pm_, pn_);
+
+    std::vector<size_t> bytes(nnzs_.size());
+    for (size_t i = 0; i < grid_shape()[0]; i++) {
+      for (size_t j = 0; j < grid_shape()[1]; j++) {
+        size_t nnz = tile_nnz(i, j);
+        bytes[j + i*grid_shape()[1]] = tile_file_round_up_(sizeof(T)*nnz, 8) +
+                                       tile_file_round_up_(sizeof(index_type)*nnz, 8) +
+                                       sizeof(index_type)*(tile_shape(i, j)[0]+1);
+      }
+    }
+    std::vector<TileFileEntry> tiles = tile_file_layout_(bytes, nnzs_);
+    int fd = create_tile_file(fname, header, tiles);
+
+    for (size_t i = 0; i < grid_shape()[0]; i++) {
+      for (size_t j = 0; j < grid_shape()[1]; j++) {
+        size_t idx = j + i*grid_shape()[1];
+        if (vals_[idx].rank == BCL::rank()) {
+          size_t nnz = tile_nnz(i, j);
+          size_t offset = tiles[idx].offset;
+          tile_file_pwrite_(fd, vals_[idx].local(), sizeof(T)*nnz, offset);
+          offset += tile_file_round_up_(sizeof(T)*nnz, 8);
+          tile_file_pwrite_(fd, col_ind_[idx].local(), sizeof(index_type)*nnz, offset);
+          offset += tile_file_round_up_(sizeof(index_type)*nnz, 8);
+          tile_file_pwrite_(fd, row_ptr_[idx].local(), sizeof(index_type)*(tile_shape(i, j)[0]+1), offset);
+        }
+      }
+    }
+    close(fd);
+    BCL::barrier();
+  }
+
+  void add_tile_(size_t proc, size_t nnz, BCL::GlobalPtr<T> vals,
+                 BCL::GlobalPtr<index_type> col_ind,
+                 BCL::GlobalPtr<index_type> row_ptr) {
+    nnz = BCL::broadcast(nnz, proc);
+    vals = BCL::broadcast(vals, proc);
+    col_ind = BCL::broadcast(col_ind, proc);
+    row_ptr = BCL::broadcast(row_ptr, proc);
+
+    nnzs_.push_back(nnz);
+    vals_.push_back(vals);
+    col_ind_.push_back(col_ind);
+    row_ptr_.push_back(row_ptr);
+  }
+
+  void init_shape_(size_t m, size_t n, size_t nnz, Block& blocking) {
+    m_ = m;
+    n_ = n;
+    nnz_ = nnz;
+
+    blocking.seed(m_, n_, BCL::nprocs(this->team()));
+
+    pm_ = blocking.pgrid_shape()[0];
+    pn_ = blocking.pgrid_shape()[1];
+
+    tile_size_m_ = blocking.tile_shape()[0];
+    tile_size_n_ = blocking.tile_shape()[1];
+
+    if (pm_*pn_ > BCL::nprocs()) {
+      throw std::runtime_error("DMatrix: tried to create a DMatrix with a too large p-grid.");
+    }
+
+    grid_dim_m_ = (m_ + tile_size_m_ - 1) / tile_size_m_;
+    grid_dim_n_ = (n_ + tile_size_n_ - 1) / tile_size_n_;
+  }
+
+  size_t tile_owner_(size_t i, size_t j) const noexcept {
+    size_t lpi = i % pm_;
+    size_t lpj = j % pn_;
+    return lpj + lpi*pn_;
+  }
+
   const BCL::Team& team() const {
     return *team_ptr_;
   }
@@ -184,6 +420,8 @@ public:
     std::copy(mat.col_ind_.begin(), mat.col_ind_.end(), col_ind.local());
     std::copy(mat.row_ptr_.begin(), mat.row_ptr_.end(), row_ptr.local());
 
+    BCL::tile_cache().invalidate(cache_id_, i, j);
+
     std::swap(vals, vals_[j + i*grid_shape()[1]]);
     std::swap(col_ind, col_ind_[j + i*grid_shape()[1]]);
     std::swap(row_ptr, row_ptr_[j + i*grid_shape()[1]]);
@@ -198,6 +436,7 @@ public:
   }
 
   void rebroadcast_tiles(const std::vector<size_t>& locales = {}) {
+    invalidate_cache();
     if (locales.empty()) {
       for (size_t i = 0; i < vals_.size(); i++) {
         vals_[i] = BCL::broadcast(vals_[i], vals_[i].rank);
@@ -382,30 +621,59 @@ public:
   }
 
   template <typename Allocator = fetch_allocator>
-  future<CSRMatrix<T, index_type, Allocator>> arget_tile(size_t i, size_t j) const {
+  cached_future<future<CSRMatrix<T, index_type, Allocator>>>
+  arget_tile(size_t i, size_t j) const {
     using allocator_traits = std::allocator_traits<Allocator>;
     using IAllocator = typename allocator_traits:: template rebind_alloc<index_type>;
+    using matrix_type = CSRMatrix<T, index_type, Allocator>;
     size_t m, n, nnz;
     m = tile_shape(i, j)[0];
     n = tile_shape(i, j)[1];
 
     nnz = tile_nnz(i, j);
 
+    auto& cache = BCL::tile_cache();
+    bool cached = cache.enabled() && !vals_[j + i*grid_shape()[1]].is_local();
+    BCL::TileCache::Key key{cache_id_, i, j};
+    if (cached) {
+      if (auto* entry = cache.find(key)) {
+        std::vector<BCL::request> ready;
+        return future<matrix_type>(m, n, nnz,
+                 future<std::vector<T, Allocator>>(tile_cache_vector_<T, Allocator>((*entry)[0]), ready),
+                 future<std::vector<index_type, IAllocator>>(tile_cache_vector_<index_type, IAllocator>((*entry)[1]), ready),
+                 future<std::vector<index_type, IAllocator>>(tile_cache_vector_<index_type, IAllocator>((*entry)[2]), ready));
+      }
+    }
+
     auto vals = BCL::arget<T, Allocator>(vals_[j + i*grid_shape()[1]], nnz);
     auto row_ptr = BCL::arget<index_type, IAllocator>(row_ptr_[j + i*grid_shape()[1]], m+1);
     auto col_ind = BCL::arget<index_type, IAllocator>(col_ind_[j + i*grid_shape()[1]], nnz);
 
-    return future<CSRMatrix<T, index_type, Allocator>>(m, n, nnz,
-                                            std::move(vals),
-                                            std::move(row_ptr),
-                                            std::move(col_ind));
+    future<matrix_type> tile(m, n, nnz,
+                             std::move(vals),
+                             std::move(row_ptr),
+                             std::move(col_ind));
+    if (!cached) {
+      return tile;
+    }
+    size_t epoch = cache.epoch(cache_id_);
+    return {std::move(tile), [key, epoch](const matrix_type& mat) {
+      BCL::tile_cache().insert(key, epoch, {tile_cache_bytes_(mat.vals_),
+                                            tile_cache_bytes_(mat.row_ptr_),
+                                            tile_cache_bytes_(mat.col_ind_)});
+    }};
+  }
+
+  // Drop this matrix's tiles from the calling rank's tile cache.
+  void invalidate_cache() const {
+    BCL::tile_cache().invalidate(cache_id_);
   }
 
   // OPTIMIZE this later.
   template <typename Allocator = std::allocator<T>>
   auto get() const {
     using matrix_type = CSRMatrix<T, index_type, Allocator>;
-    using future_type = BCL::future<matrix_type>;
+    using future_type = BCL::cached_future<BCL::future<matrix_type>>;
 
     std::vector<std::vector<future_type>> local_tiles(grid_shape()[0]);
 
@@ -5,8 +5,12 @@
 #include <bcl/containers/DMatrix.hpp>
 
 #include <bcl/containers/algorithms/cblas_wrapper.hpp>
+#include <bcl/core/util/ThreadPool.hpp>
 
 #include <cassert>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 namespace BCL {
 
@@ -229,5 +233,203 @@ void ca_gemm(const std::vector<BCL::DMatrix<T>>& as, const std::vector<BCL::DMat
   BCL::print("%lf accumulating.\n", duration);
 }
 
+
+// Collective.  c += a*b with the 2.5D algorithm.  The ranks are split
+// into `layers` teams (BCL::split_world), at most one per k tile;
+// each layer takes one slice of the k dimension, holds its own copy
+// of the columns of a and rows of b in that slice, and computes
+// their contribution to every tile of c.  The layers' results are
+// then summed into c.  More layers cost more memory for c but less
+// tile traffic per rank.  With one layer this is SUMMA on a, b and
+// c directly.
+//
+// Each rank keeps `depth` tile pairs in flight ahead of the one it
+// is multiplying, and runs the multiplies on n_threads worker
+// threads (inline if 0) while it goes on fetching.
+template <typename T>
+void gemm_25d(const BCL::DMatrix<T>& a, const BCL::DMatrix<T>& b, BCL::DMatrix<T>& c,
+              size_t layers = 1, size_t depth = 2, size_t n_threads = 1) {
+  assert(a.shape()[1] == b.shape()[0]);
+  // Inner dimensions of the tiles we're multiplying must match.
+  assert(a.grid_shape()[1] == b.grid_shape()[0]);
+  assert(a.tile_shape()[1] == b.tile_shape()[0]);
+
+  if (!(a.shape()[0] == c.shape()[0] && a.shape()[1] == b.shape()[0] && b.shape()[1] == c.shape()[1])) {
+    throw std::runtime_error("gemm_25d: mismatched matrix dimensions.");
+  }
+  if (!(a.tile_shape()[0] == c.tile_shape()[0] && b.tile_shape()[1] == c.tile_shape()[1])) {
+    throw std::runtime_error("gemm_25d: c's tiles must match a's rows and b's columns.");
+  }
+
+  size_t k_steps = a.grid_shape()[1];
+  auto teams = BCL::split_world(std::max<size_t>(1, std::min(layers, k_steps)));
+  size_t my_layer = 0;
+  for (size_t i = 0; i < teams.size(); i++) {
+    if (teams[i].in_team()) {
+      my_layer = i;
+    }
+  }
+
+  // Layer l multiplies k tiles [layer_k(l), layer_k(l+1)).
+  auto layer_k = [&](size_t l) {
+    return (k_steps*l) / teams.size();
+  };
+  size_t k_begin = layer_k(my_layer);
+  size_t k_end = layer_k(my_layer+1);
+
+  // Per-layer replicas of a's and b's slices, whose tile k is tile
+  // layer_k(l) + k of a and b, and an accumulator for c.
+  std::vector<BCL::DMatrix<T>> as, bs, cs;
+  if (teams.size() > 1) {
+    size_t tile_k = a.tile_shape()[1];
+    for (size_t l = 0; l < teams.size(); l++) {
+      const auto& team = teams[l];
+      size_t slice = std::min(layer_k(l+1)*tile_k, a.shape()[1]) - layer_k(l)*tile_k;
+      std::vector<size_t> pgrid = BCL::factor(team.nprocs());
+      as.emplace_back(a.shape()[0], slice,
+                      BCL::BlockCustom({a.tile_shape()[0], tile_k},
+                                       {pgrid[0], pgrid[1]}), team);
+      bs.emplace_back(slice, b.shape()[1],
+                      BCL::BlockCustom({tile_k, b.tile_shape()[1]},
+                                       {pgrid[0], pgrid[1]}), team);
+      cs.emplace_back(c.shape()[0], c.shape()[1],
+                      BCL::BlockCustom({c.tile_shape()[0], c.tile_shape()[1]},
+                                       {pgrid[0], pgrid[1]}), team);
+    }
+
+    // Copy tile (i + i_offset, j + j_offset) of src to each
+    // local tile (i, j) of dst.
+    std::vector<BCL::request> requests;
+    auto replicate = [&](const BCL::DMatrix<T>& src, BCL::DMatrix<T>& dst,
+                         size_t i_offset, size_t j_offset) {
+      for (size_t i = 0; i < dst.grid_shape()[0]; i++) {
+        for (size_t j = 0; j < dst.grid_shape()[1]; j++) {
+          if (dst.tile_ptr(i, j).is_local()) {
+            requests.push_back(BCL::arget(src.tile_ptr(i + i_offset, j + j_offset),
+                                          dst.tile_ptr(i, j).local(), src.tile_size()));
+          }
+        }
+      }
+    };
+    replicate(a, as[my_layer], 0, k_begin);
+    replicate(b, bs[my_layer], k_begin, 0);
+    for (auto& request : requests) {
+      request.wait();
+    }
+    for (auto& ptr : cs[my_layer].ptrs_) {
+      if (ptr.is_local()) {
+        std::fill(ptr.local(), ptr.local() + c.tile_size(), T(0));
+      }
+    }
+    BCL::barrier();
+  }
+
+  const BCL::DMatrix<T>& my_a = (teams.size() > 1) ? as[my_layer] : a;
+  const BCL::DMatrix<T>& my_b = (teams.size() > 1) ? bs[my_layer] : b;
+  BCL::DMatrix<T>& my_c = (teams.size() > 1) ? cs[my_layer] : c;
+  // Tile k of a and b is tile k - my_k_offset of my_a and my_b.
+  size_t my_k_offset = (teams.size() > 1) ? k_begin : 0;
+
+  struct Task {
+    size_t tile;
+    size_t i, j, k;
+  };
+
+  // Every (c tile, k) multiply this rank does, in order.
+  std::vector<Task> tasks;
+  size_t n_tiles = 0;
+  for (size_t i = 0; i < c.grid_shape()[0]; i++) {
+    for (size_t j = 0; j < c.grid_shape()[1]; j++) {
+      if (my_c.tile_ptr(i, j).is_local() && k_begin < k_end) {
+        for (size_t k_ = 0; k_ < k_end - k_begin; k_++) {
+          size_t k = k_begin + (k_ + j) % (k_end - k_begin);
+          tasks.push_back({n_tiles, i, j, k});
+        }
+        n_tiles++;
+      }
+    }
+  }
+
+  // Multiplies into the same c tile must not overlap.
+  std::vector<std::mutex> tile_mutexes(n_tiles);
+  BCL::ThreadPool pool(n_threads, std::max<size_t>(1, depth));
+
+  using tile_type = std::vector<T>;
+  using future_type = BCL::cached_future<BCL::future<tile_type>>;
+  std::deque<std::pair<future_type, future_type>> in_flight;
+  size_t next = 0;
+
+  for (size_t t = 0; t < tasks.size(); t++) {
+    while (next < tasks.size() && next <= t + depth) {
+      const Task& task = tasks[next++];
+      size_t my_k = task.k - my_k_offset;
+      in_flight.emplace_back(std::get<0>(my_a.template arget_tile<std::allocator<T>>(task.i, my_k)),
+                             std::get<0>(my_b.template arget_tile<std::allocator<T>>(my_k, task.j)));
+    }
+
+    auto tile_a = std::make_shared<tile_type>(in_flight.front().first.get());
+    auto tile_b = std::make_shared<tile_type>(in_flight.front().second.get());
+    in_flight.pop_front();
+
+    const Task task = tasks[t];
+    T* local_c = my_c.tile_ptr(task.i, task.j).local();
+    pool.submit([&, task, tile_a, tile_b, local_c] {
+      size_t M, N, K;
+      size_t lda = a.tile_shape()[1];
+      size_t ldb = b.tile_shape()[1];
+      size_t ldc = c.tile_shape()[1];
+      M = c.tile_shape(task.i, task.j)[0];
+      N = c.tile_shape(task.i, task.j)[1];
+      K = a.tile_shape(task.i, task.k)[1];
+
+      std::lock_guard<std::mutex> lock(tile_mutexes[task.tile]);
+      cblas_gemm_wrapper_(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                          M, N, K,
+                          1.0, tile_a->data(), lda,
+                          tile_b->data(), ldb, 1.0,
+                          local_c, ldc);
+    });
+  }
+  pool.wait();
+
+  if (teams.size() > 1) {
+    BCL::barrier();
+
+    std::vector<T> partials(teams.size()*c.tile_size());
+    for (size_t i = 0; i < c.grid_shape()[0]; i++) {
+      for (size_t j = 0; j < c.grid_shape()[1]; j++) {
+        if (c.tile_ptr(i, j).is_local()) {
+          std::vector<BCL::request> requests;
+          for (size_t l = 0; l < teams.size(); l++) {
+            requests.push_back(BCL::arget(cs[l].tile_ptr(i, j),
+                                          partials.data() + l*c.tile_size(), c.tile_size()));
+          }
+          for (auto& request : requests) {
+            request.wait();
+          }
+          T* local_c = c.tile_ptr(i, j).local();
+          for (size_t l = 0; l < teams.size(); l++) {
+            for (size_t x = 0; x < c.tile_size(); x++) {
+              local_c[x] += partials[l*c.tile_size() + x];
+            }
+          }
+        }
+      }
+    }
+
+    // Others may still be reading our partials.
+    BCL::barrier();
+    for (auto* replicas : {&as, &bs, &cs}) {
+      (*replicas)[my_layer].invalidate_cache();
+      for (auto& ptr : (*replicas)[my_layer].ptrs_) {
+        if (ptr.is_local()) {
+          BCL::dealloc(ptr);
+        }
+      }
+    }
+  }
+  c.invalidate_cache();
+}
+
 }
 }
@@ -90,6 +90,7 @@ void gemm_notrans_impl_(const BCL::DExpr<E>& a, const BCL::DExpr<V>& b, BCL::DMa
       }
     }
   }
+  c.invalidate_cache();
 }
 
 template <typename T>
@@ -158,6 +159,7 @@ void slicing_gemm(const BCL::DMatrix<T>& a, const BCL::DMatrix<T>& b, BCL::DMatr
       }
     }
   }
+  c.invalidate_cache();
 }
 
 template <typename T>
@@ -297,6 +299,7 @@ void summa(const BCL::DMatrix<T>& a, const BCL::DMatrix<T>& b, BCL::DMatrix<T>&
       }
     }
   }
+  c.invalidate_cache();
 }
 
 template <typename T>
@@ -407,6 +410,7 @@ void async_summa(const BCL::DMatrix<T>& a, const BCL::DMatrix<T>& b, BCL::DMatri
       }
     }
   }
+  c.invalidate_cache();
 }
 
 }
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/sequential/CSRMatrix.hpp>
+#include <bcl/containers/sequential/SparseAccumulator.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+namespace BCL {
+
+// There is no eager choice.  EagerSumAccumulator adds each partial
+// to a running sum with mkl_sparse_s_add, so it only takes float
+// values with MKL_INT indices, and it re-merges the whole running
+// sum once per partial.  Here every partial is already in hand when
+// the accumulator is picked, so one k-way merge (heap or hash) does
+// the same job without the repeated passes.
+enum class SpGEMMAccumulator {
+  spa,
+  heap,
+  hash
+};
+
+// Choose how to sum the k partial products of one C tile.
+// flops is the total nnz of the partials (the work of the merge),
+// max_nnz the largest one; flops / max_nnz bounds how much the
+// merge compresses.  Dense output rows favor the SPA, a few sorted
+// partials with little overlap merge cheaply with the heap, and
+// everything else goes to the hash accumulator.
+inline SpGEMMAccumulator choose_spgemm_accumulator_(size_t m, size_t n,
+                                                    size_t n_partials,
+                                                    size_t flops,
+                                                    size_t max_nnz) {
+  if (flops*16 >= m*n) {
+    return SpGEMMAccumulator::spa;
+  } else if (n_partials <= 2 || (n_partials <= 8 && flops < 2*max_nnz)) {
+    return SpGEMMAccumulator::heap;
+  } else {
+    return SpGEMMAccumulator::hash;
+  }
+}
+
+template <typename Accumulator, typename MatrixType>
+CSRMatrix<typename MatrixType::value_type, typename MatrixType::index_type>
+spgemm_accumulate_impl_(std::vector<MatrixType>& partials, size_t m, size_t n) {
+  Accumulator acc;
+  for (auto& partial : partials) {
+    acc.accumulate(std::move(partial));
+  }
+  partials.clear();
+  return acc.get_matrix(m, n);
+}
+
+template <typename T, typename index_type, typename Allocator>
+CSRMatrix<T, index_type>
+spgemm_accumulate_(std::vector<CSRMatrix<T, index_type, Allocator>>& partials,
+                   size_t m, size_t n) {
+  size_t flops = 0;
+  size_t max_nnz = 0;
+  for (const auto& partial : partials) {
+    flops += partial.nnz_;
+    max_nnz = std::max<size_t>(max_nnz, partial.nnz_);
+  }
+
+  if (partials.empty()) {
+    return CSRMatrix<T, index_type>(m, n, 0,
+                                    std::vector<T>(),
+                                    std::vector<index_type>(m+1, 0),
+                                    std::vector<index_type>());
+  }
+
+  switch (choose_spgemm_accumulator_(m, n, partials.size(), flops, max_nnz)) {
+    case SpGEMMAccumulator::spa:
+      return spgemm_accumulate_impl_<SparseSPAAccumulator<T, index_type, Allocator>>(partials, m, n);
+    case SpGEMMAccumulator::heap:
+      return spgemm_accumulate_impl_<SparseHeapAccumulator<T, index_type, Allocator>>(partials, m, n);
+    default:
+      return spgemm_accumulate_impl_<SparseHashAccumulator<T, index_type, Allocator>>(partials, m, n);
+  }
+}
+
+// Collective.  C = A*B, SUMMA style: each rank computes the tiles
+// of C it owns, fetching the next A and B tiles while it multiplies
+// the current ones.  C must have A's row and B's column tiling,
+// e.g. BCL::SPMatrix<T> c(m, n, a.dry_product_block(b)).
+template <typename T, typename index_type>
+void spgemm(const SPMatrix<T, index_type>& a, const SPMatrix<T, index_type>& b,
+            SPMatrix<T, index_type>& c) {
+  if (!(a.shape()[0] == c.shape()[0] && a.shape()[1] == b.shape()[0] &&
+        b.shape()[1] == c.shape()[1])) {
+    throw std::runtime_error("BCL::spgemm: mismatched matrix dimensions.");
+  }
+  // Inner dimensions of the tiles we're multiplying must match.
+  if (a.grid_shape()[1] != b.grid_shape()[0] ||
+      a.tile_shape()[1] != b.tile_shape()[0] ||
+      a.tile_shape()[0] != c.tile_shape()[0] ||
+      b.tile_shape()[1] != c.tile_shape()[1]) {
+    throw std::runtime_error("BCL::spgemm: mismatched tile dimensions.");
+  }
+
+  using fetch_allocator = typename SPMatrix<T, index_type>::fetch_allocator;
+  using partial_type = CSRMatrix<T, index_type, fetch_allocator>;
+
+  size_t k_steps = a.grid_shape()[1];
+
+  for (size_t i = 0; i < c.grid_shape()[0]; i++) {
+    for (size_t j = 0; j < c.grid_shape()[1]; j++) {
+      if (c.tile_locale(i, j) == BCL::rank()) {
+        // Start each tile at a different k to spread the load.
+        size_t k_offset = j;
+        auto buf_a = a.arget_tile(i, k_offset % k_steps);
+        auto buf_b = b.arget_tile(k_offset % k_steps, j);
+
+        std::vector<partial_type> partials;
+        for (size_t k_ = 0; k_ < k_steps; k_++) {
+          auto my_a = buf_a.get();
+          auto my_b = buf_b.get();
+
+          if (k_+1 < k_steps) {
+            size_t k = (k_ + 1 + k_offset) % k_steps;
+            buf_a = a.arget_tile(i, k);
+            buf_b = b.arget_tile(k, j);
+          }
+
+          if (my_a.nnz_ > 0 && my_b.nnz_ > 0) {
+            auto partial = my_a.dot(my_b);
+            if (partial.nnz_ > 0) {
+              partials.emplace_back(std::move(partial));
+            }
+          }
+        }
+
+        auto result = spgemm_accumulate_(partials, c.tile_shape(i, j)[0],
+                                         c.tile_shape(i, j)[1]);
+        c.assign_tile(i, j, result);
+      }
+    }
+  }
+  c.rebroadcast_tiles();
+}
+
+}
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/DArray.hpp>
+#include <bcl/containers/DMatrix.hpp>
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+// Sparse matrix times dense vector (spmv) and times tall-skinny
+// dense matrix (spmm) for SPMatrix.
+//
+// An SpMVPlan records, once, which rows of x each rank's tiles
+// touch.  Every multiply then fetches just those rows as a few
+// contiguous runs per owner, multiplies its local tiles into a
+// partial result per tile row, and lets the owner of each row of y
+// pull and sum the partials.  Reuse one plan across iterations.
+//
+// Within a tile, nonzeros are visited in column panels whose slice
+// of the halo fits in panel_bytes, so the x rows a panel reads stay
+// in cache while every row of the tile uses them.  This needs the
+// column indices of each row sorted (as the MatrixMarket loader and
+// spgemm leave them); a tile with unsorted rows is one panel.
+
+namespace BCL {
+
+// Rows of x closer together than this are fetched as one run.
+constexpr size_t spmv_halo_gap = 8;
+
+// Default bytes of x per column panel, about an L2 cache.
+constexpr size_t spmv_panel_bytes = 256*1024;
+
+template <typename T, typename index_type>
+class SpMVPlan {
+public:
+  struct Pull {
+    BCL::GlobalPtr<T> src;
+    size_t y_block;
+    size_t offset;
+    size_t size;
+  };
+
+  SpMVPlan(const SpMVPlan&) = delete;
+  SpMVPlan& operator=(const SpMVPlan&) = delete;
+
+  // Collective.  Plan for y = a*x.
+  SpMVPlan(const SPMatrix<T, index_type>& a, const DArray<T>& x, DArray<T>& y,
+           size_t panel_bytes = spmv_panel_bytes) {
+    if (a.shape()[1] != x.size() || a.shape()[0] != y.size()) {
+      throw std::runtime_error("BCL::SpMVPlan: mismatched dimensions.");
+    }
+    std::vector<size_t> y_blocks;
+    if (BCL::rank()*y.local_size < y.size()) {
+      y_blocks.push_back(BCL::rank());
+    }
+    init_(a, 1, x.local_size, y.local_size, y_blocks, panel_bytes);
+  }
+
+  // Collective.  Plan for y = a*x with x and y DMatrix
+  // with a single column of tiles.
+  SpMVPlan(const SPMatrix<T, index_type>& a, const DMatrix<T>& x, DMatrix<T>& y,
+           size_t panel_bytes = spmv_panel_bytes) {
+    if (a.shape()[1] != x.shape()[0] || a.shape()[0] != y.shape()[0] ||
+        x.shape()[1] != y.shape()[1]) {
+      throw std::runtime_error("BCL::SpMVPlan: mismatched dimensions.");
+    }
+    if (x.grid_shape()[1] != 1 || y.grid_shape()[1] != 1 ||
+        x.tile_shape()[1] != x.shape()[1] || y.tile_shape()[1] != y.shape()[1]) {
+      throw std::runtime_error("BCL::SpMVPlan: x and y must have one column of tiles.");
+    }
+    std::vector<size_t> y_blocks;
+    for (size_t i = 0; i < y.grid_shape()[0]; i++) {
+      if (y.tile_locale(i, 0) == BCL::rank()) {
+        y_blocks.push_back(i);
+      }
+    }
+    init_(a, x.shape()[1], x.tile_shape()[0], y.tile_shape()[0], y_blocks,
+          panel_bytes);
+  }
+
+  ~SpMVPlan() {
+    if (!BCL::bcl_finalized) {
+      if (BCL::rank() < partials_.size() && partials_[BCL::rank()] != nullptr) {
+        BCL::dealloc(partials_[BCL::rank()]);
+      }
+    }
+  }
+
+  // Columns per row of x and y.
+  size_t width_;
+  size_t m_, n_;
+  // x and y are split into blocks of this many rows, each
+  // stored contiguously on one rank.
+  size_t x_block_;
+  size_t y_block_;
+
+  // Runs [begin, end) of x rows to fetch, and where each lands
+  // in the halo.  A run never crosses an x block.
+  std::vector<std::pair<size_t, size_t>> runs_;
+  std::vector<size_t> run_offset_;
+  size_t halo_rows_ = 0;
+
+  // Local tiles, their column indices into the halo, and the
+  // slot of their tile row in this rank's partial buffer.
+  std::vector<std::array<size_t, 2>> tiles_;
+  std::vector<std::vector<index_type>> halo_col_ind_;
+  std::vector<size_t> tile_slot_;
+  size_t tile_m_;
+
+  // For local tile t split into n_panels_[t] > 1 column panels,
+  // panel_ptr_[t][p*m + i] is the first nonzero of row i in panel
+  // p, for p in [0, n_panels_[t]], with m the tile's rows.
+  std::vector<size_t> n_panels_;
+  std::vector<std::vector<index_type>> panel_ptr_;
+  size_t n_slots_ = 0;
+
+  std::vector<BCL::GlobalPtr<T>> partials_;
+  std::vector<Pull> pulls_;
+
+private:
+  void init_(const SPMatrix<T, index_type>& a, size_t width,
+             size_t x_block, size_t y_block, const std::vector<size_t>& y_blocks,
+             size_t panel_bytes) {
+    width_ = width;
+    m_ = a.shape()[0];
+    n_ = a.shape()[1];
+    x_block_ = x_block;
+    y_block_ = y_block;
+    tile_m_ = a.tile_shape()[0];
+
+    // Tile rows with a tile on each rank, in order.
+    std::vector<std::vector<size_t>> row_blocks(BCL::nprocs());
+    for (size_t i = 0; i < a.grid_shape()[0]; i++) {
+      for (size_t j = 0; j < a.grid_shape()[1]; j++) {
+        auto& blocks = row_blocks[a.tile_locale(i, j)];
+        if (blocks.empty() || blocks.back() != i) {
+          blocks.push_back(i);
+        }
+        if (a.tile_locale(i, j) == BCL::rank()) {
+          tiles_.push_back({i, j});
+          tile_slot_.push_back(blocks.size() - 1);
+        }
+      }
+    }
+    n_slots_ = row_blocks[BCL::rank()].size();
+
+    // Every x row a local nonzero touches, then runs of them.
+    std::vector<size_t> cols;
+    for (const auto& tile : tiles_) {
+      size_t idx = tile[1] + tile[0]*a.grid_shape()[1];
+      const index_type* col_ind = a.col_ind_[idx].local();
+      size_t col_offset = tile[1]*a.tile_shape()[1];
+      for (size_t k = 0; k < a.tile_nnz(tile[0], tile[1]); k++) {
+        cols.push_back(col_offset + col_ind[k]);
+      }
+    }
+    std::sort(cols.begin(), cols.end());
+    cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+
+    for (size_t col : cols) {
+      if (runs_.empty() || col - runs_.back().second > spmv_halo_gap ||
+          col / x_block_ != runs_.back().first / x_block_) {
+        runs_.push_back({col, col+1});
+      } else {
+        runs_.back().second = col+1;
+      }
+    }
+    for (const auto& run : runs_) {
+      run_offset_.push_back(halo_rows_);
+      halo_rows_ += run.second - run.first;
+    }
+
+    for (const auto& tile : tiles_) {
+      size_t idx = tile[1] + tile[0]*a.grid_shape()[1];
+      const index_type* col_ind = a.col_ind_[idx].local();
+      size_t col_offset = tile[1]*a.tile_shape()[1];
+      size_t nnz = a.tile_nnz(tile[0], tile[1]);
+      std::vector<index_type> halo_col_ind(nnz);
+      for (size_t k = 0; k < nnz; k++) {
+        size_t col = col_offset + col_ind[k];
+        auto run = std::upper_bound(runs_.begin(), runs_.end(), col,
+                                    [](size_t col, const std::pair<size_t, size_t>& run) {
+                                      return col < run.first;
+                                    }) - 1;
+        halo_col_ind[k] = run_offset_[run - runs_.begin()] + (col - run->first);
+      }
+      halo_col_ind_.push_back(std::move(halo_col_ind));
+      init_panels_(a.tile_shape(tile[0], tile[1])[0], a.row_ptr_[idx].local(),
+                   halo_col_ind_.back(),
+                   std::max<size_t>(1, panel_bytes / (sizeof(T)*width_)));
+    }
+
+    partials_.resize(BCL::nprocs(), nullptr);
+    for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+      if (BCL::rank() == rank) {
+        partials_[rank] = BCL::alloc<T>(std::max<size_t>(1, n_slots_*tile_m_*width_));
+      }
+      partials_[rank] = BCL::broadcast(partials_[rank], rank);
+      if (partials_[rank] == nullptr) {
+        throw std::runtime_error("BCL::SpMVPlan: ran out of memory.");
+      }
+    }
+
+    // Each local y row is the sum of one partial row from
+    // every rank holding a tile in that tile row.
+    for (size_t b : y_blocks) {
+      size_t begin = b*y_block_;
+      size_t end = std::min(m_, begin + y_block_);
+      while (begin < end) {
+        size_t i = begin / tile_m_;
+        size_t run_end = std::min(end, (i+1)*tile_m_);
+        for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+          const auto& blocks = row_blocks[rank];
+          auto slot = std::lower_bound(blocks.begin(), blocks.end(), i);
+          if (slot != blocks.end() && *slot == i) {
+            size_t remote = ((slot - blocks.begin())*tile_m_ + (begin - i*tile_m_))*width_;
+            pulls_.push_back({partials_[rank] + remote, b,
+                              (begin - b*y_block_)*width_,
+                              (run_end - begin)*width_});
+          }
+        }
+        begin = run_end;
+      }
+    }
+  }
+
+  void init_panels_(size_t m, const index_type* row_ptr,
+                    const std::vector<index_type>& halo_col_ind, size_t panel_rows) {
+    size_t nnz = halo_col_ind.size();
+    bool sorted = true;
+    for (size_t i = 0; i < m && sorted; i++) {
+      sorted = std::is_sorted(halo_col_ind.begin() + row_ptr[i],
+                              halo_col_ind.begin() + row_ptr[i+1]);
+    }
+    size_t n_panels = 1;
+    index_type lo = 0;
+    if (sorted && nnz > 0) {
+      auto minmax = std::minmax_element(halo_col_ind.begin(), halo_col_ind.end());
+      lo = *minmax.first;
+      n_panels = (*minmax.second - lo) / panel_rows + 1;
+    }
+    n_panels_.push_back(n_panels);
+    panel_ptr_.emplace_back();
+    if (n_panels == 1) {
+      return;
+    }
+
+    auto& panel_ptr = panel_ptr_.back();
+    panel_ptr.resize((n_panels + 1)*m);
+    for (size_t i = 0; i < m; i++) {
+      auto row_begin = halo_col_ind.begin() + row_ptr[i];
+      auto row_end = halo_col_ind.begin() + row_ptr[i+1];
+      for (size_t p = 0; p < n_panels; p++) {
+        panel_ptr[p*m + i] = std::lower_bound(row_begin, row_end,
+                                              index_type(lo + p*panel_rows)) -
+                             halo_col_ind.begin();
+      }
+      panel_ptr[n_panels*m + i] = row_ptr[i+1];
+    }
+  }
+};
+
+// y[i*width:(i+1)*width] += sum over row i of vals[k]*x[col_ind[k]*width:...]
+// for k in [begin[i], end[i]).
+template <typename T, typename index_type>
+void spmv_tile_kernel_(size_t m, const index_type* begin, const index_type* end,
+                       const index_type* col_ind, const T* vals,
+                       const T* x, T* y, size_t width) {
+  if (width == 1) {
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (size_t i = 0; i < m; i++) {
+      T sum = 0;
+      #pragma omp simd reduction(+:sum)
+      for (index_type k = begin[i]; k < end[i]; k++) {
+        sum += vals[k]*x[col_ind[k]];
+      }
+      y[i] += sum;
+    }
+  } else {
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < m; i++) {
+      T* y_row = y + i*width;
+      for (index_type k = begin[i]; k < end[i]; k++) {
+        const T* x_row = x + col_ind[k]*width;
+        T value = vals[k];
+        #pragma omp simd
+        for (size_t l = 0; l < width; l++) {
+          y_row[l] += value*x_row[l];
+        }
+      }
+    }
+  }
+}
+
+// x_block_ptr(b) and y_block_ptr(b) give the start of row
+// block b of x and y.
+template <typename T, typename index_type, typename XBlockPtr, typename YBlockPtr>
+void spmv_impl_(const SPMatrix<T, index_type>& a, SpMVPlan<T, index_type>& plan,
+                XBlockPtr&& x_block_ptr, YBlockPtr&& y_block_ptr) {
+  size_t width = plan.width_;
+
+  // x must be complete, and last call's partials consumed.
+  BCL::barrier();
+
+  std::vector<T> halo(std::max<size_t>(1, plan.halo_rows_*width));
+  std::vector<BCL::request> requests;
+  for (size_t r = 0; r < plan.runs_.size(); r++) {
+    size_t begin = plan.runs_[r].first;
+    size_t b = begin / plan.x_block_;
+    BCL::GlobalPtr<T> src = x_block_ptr(b) + (begin - b*plan.x_block_)*width;
+    requests.push_back(BCL::arget(src, halo.data() + plan.run_offset_[r]*width,
+                                  (plan.runs_[r].second - begin)*width));
+  }
+  for (auto& request : requests) {
+    request.wait();
+  }
+
+  T* partial = plan.partials_[BCL::rank()].local();
+  std::fill(partial, partial + plan.n_slots_*plan.tile_m_*width, T(0));
+  for (size_t t = 0; t < plan.tiles_.size(); t++) {
+    size_t i = plan.tiles_[t][0];
+    size_t j = plan.tiles_[t][1];
+    size_t idx = j + i*a.grid_shape()[1];
+    size_t m = a.tile_shape(i, j)[0];
+    const index_type* row_ptr = a.row_ptr_[idx].local();
+    const index_type* panel_ptr = plan.panel_ptr_[t].data();
+    for (size_t p = 0; p < plan.n_panels_[t]; p++) {
+      const index_type* begin = (plan.n_panels_[t] == 1) ? row_ptr : panel_ptr + p*m;
+      const index_type* end = (plan.n_panels_[t] == 1) ? row_ptr + 1 : panel_ptr + (p+1)*m;
+      spmv_tile_kernel_(m, begin, end, plan.halo_col_ind_[t].data(), a.vals_[idx].local(),
+                        halo.data(), partial + plan.tile_slot_[t]*plan.tile_m_*width,
+                        width);
+    }
+  }
+
+  BCL::barrier();
+
+  size_t pull_size = 0;
+  for (const auto& pull : plan.pulls_) {
+    pull_size += pull.size;
+  }
+  std::vector<T> pulled(std::max<size_t>(1, pull_size));
+  requests.clear();
+  size_t offset = 0;
+  for (const auto& pull : plan.pulls_) {
+    requests.push_back(BCL::arget(pull.src, pulled.data() + offset, pull.size));
+    offset += pull.size;
+  }
+  for (auto& request : requests) {
+    request.wait();
+  }
+
+  offset = 0;
+  for (size_t p = 0; p < plan.pulls_.size(); p++) {
+    const auto& pull = plan.pulls_[p];
+    T* y = y_block_ptr(pull.y_block).local() + pull.offset;
+    if (p == 0 || pull.y_block != plan.pulls_[p-1].y_block ||
+        pull.offset != plan.pulls_[p-1].offset) {
+      std::fill(y, y + pull.size, T(0));
+    }
+    for (size_t l = 0; l < pull.size; l++) {
+      y[l] += pulled[offset + l];
+    }
+    offset += pull.size;
+  }
+}
+
+// Collective.  y = a*x.  On return, each rank's own part of y is
+// complete; barrier before reading other ranks' parts.
+template <typename T, typename index_type>
+void spmv(const SPMatrix<T, index_type>& a, const DArray<T>& x, DArray<T>& y,
+          SpMVPlan<T, index_type>& plan) {
+  if (plan.width_ != 1 || plan.m_ != a.shape()[0] || plan.n_ != a.shape()[1] ||
+      plan.x_block_ != x.local_size || plan.y_block_ != y.local_size) {
+    throw std::runtime_error("BCL::spmv: plan does not match the arguments.");
+  }
+  spmv_impl_(a, plan,
+             [&](size_t b) { return BCL::reinterpret_pointer_cast<T>(x.data[b].data); },
+             [&](size_t b) { return BCL::reinterpret_pointer_cast<T>(y.data[b].data); });
+}
+
+template <typename T, typename index_type>
+void spmv(const SPMatrix<T, index_type>& a, const DArray<T>& x, DArray<T>& y) {
+  SpMVPlan<T, index_type> plan(a, x, y);
+  spmv(a, x, y, plan);
+}
+
+// Collective.  y = a*x for tall-skinny x and y, each with a
+// single column of tiles.
+template <typename T, typename index_type>
+void spmm(const SPMatrix<T, index_type>& a, const DMatrix<T>& x, DMatrix<T>& y,
+          SpMVPlan<T, index_type>& plan) {
+  if (plan.width_ != x.shape()[1] || plan.m_ != a.shape()[0] || plan.n_ != a.shape()[1] ||
+      plan.x_block_ != x.tile_shape()[0] || plan.y_block_ != y.tile_shape()[0]) {
+    throw std::runtime_error("BCL::spmm: plan does not match the arguments.");
+  }
+  spmv_impl_(a, plan,
+             [&](size_t b) { return x.tile_ptr(b, 0); },
+             [&](size_t b) { return y.tile_ptr(b, 0); });
+}
+
+template <typename T, typename index_type>
+void spmm(const SPMatrix<T, index_type>& a, const DMatrix<T>& x, DMatrix<T>& y) {
+  SpMVPlan<T, index_type> plan(a, x, y);
+  spmm(a, x, y, plan);
+}
+
+}
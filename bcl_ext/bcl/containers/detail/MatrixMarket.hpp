@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/ManyToManyDistributor.hpp>
+
+// Parallel MatrixMarket reader.  Each rank parses its own byte
+// range of the file and sends every nonzero straight to the rank
+// that owns it, so no rank ever holds the whole matrix.
+
+namespace BCL {
+
+struct MatrixMarketInfo {
+  size_t m, n, nnz;
+  // Byte offset of the first nonzero line, and file size.
+  size_t data_offset;
+  size_t file_size;
+};
+
+template <typename T>
+struct MatrixMarketEntry {
+  size_t i;
+  size_t j;
+  T value;
+};
+
+// Collective.  Rank 0 reads the banner, comments and size line,
+// and broadcasts them.
+inline MatrixMarketInfo read_MatrixMarket_header(const std::string& fname) {
+  MatrixMarketInfo info;
+  int ok = 1;
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(fname.c_str(), "r");
+    ok = (f != NULL);
+    if (ok) {
+      std::vector<char> line(4096);
+      do {
+        ok = fgets(line.data(), line.size(), f) != NULL;
+      } while (ok && (line[0] == '%' || line[0] == '\n'));
+
+      ok = ok && sscanf(line.data(), "%lu %lu %lu", &info.m, &info.n, &info.nnz) == 3;
+      info.data_offset = ftell(f);
+      fseek(f, 0, SEEK_END);
+      info.file_size = ftell(f);
+      fclose(f);
+    }
+  }
+  ok = BCL::broadcast(ok, 0);
+  if (!ok) {
+    throw std::runtime_error("BCL::read_MatrixMarket_header cannot read " + fname);
+  }
+  return BCL::broadcast(info, 0);
+}
+
+// Hand-rolled tokenizer.  Both functions skip leading blanks and
+// advance p past the token, returning false if there is none.
+
+inline bool parse_mm_index_(const char*& p, const char* end, size_t& value) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  if (p == end || *p < '0' || *p > '9') {
+    return false;
+  }
+  value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value*10 + (*p - '0');
+    p++;
+  }
+  return true;
+}
+
+// Plain decimals with at most 19 significant digits and small
+// exponents are converted exactly from an integer mantissa.
+// Anything else (inf, nan, long mantissas) goes to strtod.
+inline bool parse_mm_value_(const char*& p, const char* end, double& value) {
+  static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14,
+                                 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+                                 1e22};
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  const char* start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int n_digits = 0;
+  int exponent = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    mantissa = mantissa*10 + (*p++ - '0');
+    n_digits++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      mantissa = mantissa*10 + (*p++ - '0');
+      n_digits++;
+      exponent--;
+    }
+  }
+  if (n_digits > 0 && p < end && (*p == 'e' || *p == 'E')) {
+    const char* exp_start = p++;
+    bool exp_negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      exp_negative = (*p == '-');
+      p++;
+    }
+    int exp = 0;
+    if (p == end || *p < '0' || *p > '9') {
+      p = exp_start;
+    } else {
+      while (p < end && *p >= '0' && *p <= '9') {
+        exp = std::min(exp*10 + (*p++ - '0'), 100000);
+      }
+      exponent += exp_negative ? -exp : exp;
+    }
+  }
+
+  bool delimited = (p == end || *p == ' ' || *p == '\t' || *p == '\r');
+  if (n_digits > 0 && n_digits <= 19 && delimited &&
+      mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+    value = double(mantissa);
+    value = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+    value = negative ? -value : value;
+    return true;
+  }
+
+  p = start;
+  while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+    p++;
+  }
+  if (p == start) {
+    return false;
+  }
+  std::string token(start, p);
+  char* token_end;
+  value = strtod(token.c_str(), &token_end);
+  return token_end != token.c_str();
+}
+
+// Collective.  Parse the nonzeros of fname, calling fn(entry) on
+// owner(i, j) for each.  Indices passed to owner and fn are zero
+// based.  A line belongs to the rank whose byte range holds its
+// first character; ranks read their range in chunks of chunk_size
+// bytes.  Lines without a value (pattern matrices) get value 1.
+template <typename T, typename OwnerFn, typename Fn>
+void read_MatrixMarket_distributed(const std::string& fname,
+                                   const MatrixMarketInfo& info,
+                                   bool one_indexed, OwnerFn&& owner, Fn&& fn,
+                                   size_t chunk_size = 16*1024*1024) {
+  using entry_type = MatrixMarketEntry<T>;
+
+  size_t queue_size = 4096*BCL::nprocs();
+  size_t message_size = 256;
+  BCL::ManyToManyDistributor<entry_type> distributor(queue_size, message_size);
+  distributor.set_handler([&](const entry_type& entry) {
+    fn(entry);
+  });
+
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("BCL::read_MatrixMarket_distributed cannot open " + fname);
+  }
+
+  size_t data_size = info.file_size - info.data_offset;
+  size_t begin = info.data_offset + (data_size*BCL::rank()) / BCL::nprocs();
+  size_t end = info.data_offset + (data_size*(BCL::rank()+1)) / BCL::nprocs();
+
+  // Back up one byte so that a line starting exactly at begin
+  // is kept; everything up to the first newline is skipped.
+  bool skip_partial = begin > info.data_offset;
+  size_t pos = skip_partial ? begin - 1 : begin;
+
+  std::vector<char> buf;
+  size_t carry = 0;
+  bool done = (begin >= end);
+  while (!done) {
+    buf.resize(carry + chunk_size);
+    ssize_t n_read = pread(fd, buf.data() + carry, chunk_size, pos);
+    if (n_read < 0) {
+      close(fd);
+      throw std::runtime_error("BCL::read_MatrixMarket_distributed failed reading " + fname);
+    }
+    size_t chunk_offset = pos - carry;
+    pos += n_read;
+    bool eof = (n_read == 0 || pos >= info.file_size);
+
+    const char* p = buf.data();
+    const char* lim = buf.data() + carry + n_read;
+    while (!done) {
+      const char* nl = (const char*) memchr(p, '\n', lim - p);
+      if (nl == nullptr && !eof) {
+        break;
+      }
+      const char* line_end = (nl == nullptr) ? lim : nl;
+
+      if (skip_partial) {
+        skip_partial = false;
+      } else if (chunk_offset + (p - buf.data()) >= end) {
+        done = true;
+        break;
+      } else if (p < line_end && *p != '%') {
+        const char* q = p;
+        size_t i, j;
+        double value = 1;
+        if (!parse_mm_index_(q, line_end, i) || !parse_mm_index_(q, line_end, j)) {
+          // Only blank lines may lack indices.
+          while (q < line_end && (*q == ' ' || *q == '\t' || *q == '\r')) {
+            q++;
+          }
+          if (q != line_end) {
+            close(fd);
+            throw std::runtime_error("BCL::read_MatrixMarket_distributed: bad line in " + fname);
+          }
+        } else {
+          parse_mm_value_(q, line_end, value);
+          if (one_indexed) {
+            i--;
+            j--;
+          }
+          distributor.insert(entry_type{i, j, T(value)}, owner(i, j));
+        }
+      }
+
+      if (nl == nullptr) {
+        done = true;
+      } else {
+        p = nl + 1;
+      }
+    }
+
+    carry = lim - p;
+    std::memmove(buf.data(), p, carry);
+  }
+  close(fd);
+
+  distributor.flush();
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <bcl/bcl.hpp>
+
+// Which ranks share a node.  Built collectively, either from the
+// ranks' host names or, given ranks_per_node, by blocks of
+// consecutive ranks:
+//
+//   BCL::NodeMap nodes;     // by host name
+//   BCL::NodeMap nodes(4);  // ranks 0-3, 4-7, ... per node
+//
+// Nodes are numbered in order of their lowest rank.
+
+namespace BCL {
+
+class NodeMap {
+public:
+  NodeMap(size_t ranks_per_node = 0) {
+    std::vector<uint64_t> keys(BCL::nprocs());
+    if (ranks_per_node > 0) {
+      for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+        keys[rank] = rank / ranks_per_node;
+      }
+    } else {
+      // Gather every rank's host name hash on rank 0, and
+      // read them all from there.
+      BCL::GlobalPtr<uint64_t> gathered = nullptr;
+      if (BCL::rank() == 0) {
+        gathered = BCL::alloc<uint64_t>(BCL::nprocs());
+        if (gathered == nullptr) {
+          throw std::runtime_error("BCL::NodeMap: not enough memory");
+        }
+      }
+      gathered = BCL::broadcast(gathered, 0);
+      uint64_t key = std::hash<std::string>{}(BCL::hostname().c_str());
+      BCL::rput(key, gathered + BCL::rank());
+      BCL::barrier();
+      BCL::rget(gathered, keys.data(), BCL::nprocs());
+      BCL::barrier();
+      if (BCL::rank() == 0) {
+        BCL::dealloc(gathered);
+      }
+    }
+
+    std::unordered_map<uint64_t, size_t> node_ids;
+    node_.resize(BCL::nprocs());
+    local_rank_.resize(BCL::nprocs());
+    for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+      auto iter = node_ids.find(keys[rank]);
+      if (iter == node_ids.end()) {
+        iter = node_ids.insert({keys[rank], ranks_.size()}).first;
+        ranks_.emplace_back();
+      }
+      node_[rank] = iter->second;
+      local_rank_[rank] = ranks_[iter->second].size();
+      ranks_[iter->second].push_back(rank);
+    }
+  }
+
+  size_t n_nodes() const noexcept {
+    return ranks_.size();
+  }
+
+  size_t node(size_t rank = BCL::rank()) const {
+    return node_[rank];
+  }
+
+  // Index of rank among the ranks on its node.
+  size_t local_rank(size_t rank = BCL::rank()) const {
+    return local_rank_[rank];
+  }
+
+  const std::vector<size_t>& ranks(size_t node) const {
+    return ranks_[node];
+  }
+
+  size_t n_local(size_t node) const {
+    return ranks_[node].size();
+  }
+
+private:
+  std::vector<size_t> node_;
+  std::vector<size_t> local_rank_;
+  std::vector<std::vector<size_t>> ranks_;
+};
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <bcl/bcl.hpp>
+
+// Per-slot sequence numbers for a ring of capacity slots on one
+// rank, shared by FastQueue, CircularQueue and ElasticQueue.  Slot
+// p % capacity is free for position p when seq == p, holds
+// position p's element when seq == p + 1, and a pop of p hands it
+// on to position p + capacity.
+//
+//   BCL::SequencedRing ring(seq, capacity);
+//   int pos;
+//   if (ring.claim(tail, tail_buf, n, 0, pos)) {
+//     ring.for_each_run(pos, n, ...);  // write the data
+//     ring.publish(pos, n, 1);         // flushes it, then the seqs
+//   }
+//
+// Sequence numbers are only read and written with atomics, and
+// publish() completes every outstanding operation on the ring's
+// rank before them, so a slot's data always lands before the
+// sequence number that hands it on.
+
+namespace BCL {
+
+class SequencedRing {
+public:
+  BCL::GlobalPtr<int> seq;
+  size_t capacity;
+
+  SequencedRing(BCL::GlobalPtr<int> seq, size_t capacity)
+    : seq(seq), capacity(capacity) {}
+
+  // Call fn(slot, offset, len) for each contiguous run of slots
+  // covering positions [pos, pos + n).  There are at most two.
+  template <typename Fn>
+  void for_each_run(size_t pos, size_t n, Fn &&fn) const {
+    size_t slot = pos % capacity;
+    size_t first_len = std::min(n, capacity - slot);
+    fn(slot, 0, first_len);
+    if (first_len < n) {
+      fn(0, first_len, n - first_len);
+    }
+  }
+
+  // Move counter from its current value p to p + n, once every
+  // slot in [p, p + n) has sequence number position + lag.
+  // Returns false if some slot lags behind at the current value
+  // of the counter, meaning the ring is full (pushes, lag 0) or
+  // empty (pops, lag 1), or once the counter has closed_bit set
+  // or is too close to it to take n more.
+  // The first attempt uses counter_buf.
+  bool claim(BCL::GlobalPtr<int> counter, int &counter_buf,
+             size_t n, int lag, int &pos, int closed_bit = 0) const {
+    if (n > capacity) {
+      return false;
+    }
+    std::vector<int> seqs(n);
+    pos = counter_buf;
+    while (!((pos | (pos + int(n))) & closed_bit)) {
+      for_each_run(pos, n, [&](size_t slot, size_t offset, size_t len) {
+        BCL::aread_sync(seq + slot, seqs.data() + offset, len);
+      });
+
+      bool behind = false;
+      bool ahead = false;
+      for (size_t i = 0; i < n; i++) {
+        int expected = pos + int(i) + lag;
+        behind |= seqs[i] < expected;
+        ahead |= seqs[i] > expected;
+      }
+
+      if (ahead) {
+        // Someone else claimed pos; counter_buf was stale.
+        BCL::aread_sync(counter, &pos, 1);
+      } else if (behind) {
+        counter_buf = pos;
+        return false;
+      } else {
+        int old_pos = BCL::compare_and_swap<int>(counter, pos, pos + n);
+        if (old_pos == pos) {
+          counter_buf = pos + n;
+          return true;
+        }
+        pos = old_pos;
+      }
+    }
+    return false;
+  }
+
+  // Complete the caller's puts to (and gets from) the ring's
+  // rank, then set the sequence numbers of positions
+  // [pos, pos + n) to position + lag.  Two flushes: one orders
+  // the data before the sequence numbers, one completes them.
+  void publish(size_t pos, size_t n, int lag) const {
+    std::vector<int> seqs(n);
+    std::iota(seqs.begin(), seqs.end(), int(pos) + lag);
+    BCL::flush(seq.rank);
+    for_each_run(pos, n, [&](size_t slot, size_t offset, size_t len) {
+      BCL::awrite_async(seqs.data() + offset, seq + slot, len);
+    });
+    BCL::flush(seq.rank);
+  }
+
+  // Sequence numbers of a ring holding positions [head, tail).
+  static void init(int *seq, size_t capacity, int head, int tail) {
+    for (int p = head; p < head + int(capacity); p++) {
+      seq[p % capacity] = (p < tail) ? p + 1 : p;
+    }
+  }
+};
+
+} // end BCL
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <unordered_map>
+
+// Per-rank LRU cache of remote matrix tiles, consulted by
+// DMatrix::arget_tile and SPMatrix::arget_tile.  It is off until
+// given a capacity:
+//
+//   BCL::tile_cache().set_capacity(256*1024*1024);
+//
+// Entries are keyed by matrix id and tile coordinates.  A
+// matrix drops its own entries when the calling rank writes it
+// through the container (arput_tile, assign_tile, in-place ops,
+// and the gemm routines for their output).
+//
+// Invalidation is local: it only touches the calling rank's
+// cache.  A write on one rank leaves other ranks' copies of the
+// tile stale, as does any write the cache cannot see (e.g.
+// through tile_ptr(i, j).local()).  After such writes, call
+// mat.invalidate_cache() collectively before fetching again.
+
+namespace BCL {
+
+class TileCache {
+public:
+  struct Key {
+    size_t id;
+    size_t i, j;
+
+    bool operator==(const Key& other) const noexcept {
+      return id == other.id && i == other.i && j == other.j;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const noexcept {
+      uint64_t h = key.id;
+      h = h*0x9e3779b97f4a7c15ULL ^ key.i;
+      h = h*0x9e3779b97f4a7c15ULL ^ key.j;
+      return h ^ (h >> 29);
+    }
+  };
+
+  // A tile is one or more arrays (e.g. vals, row_ptr, col_ind).
+  using Entry = std::vector<std::vector<char>>;
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t bytes_hit = 0;
+  };
+
+  static size_t new_id() {
+    static size_t next_id = 0;
+    return next_id++;
+  }
+
+  bool enabled() const noexcept {
+    return capacity_ > 0;
+  }
+
+  size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+  size_t size() const noexcept {
+    return bytes_;
+  }
+
+  void set_capacity(size_t bytes) {
+    capacity_ = bytes;
+    evict_(0);
+  }
+
+  // Returns nullptr on a miss.
+  const Entry* find(const Key& key) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      stats_.misses++;
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, iter->second);
+    stats_.hits++;
+    stats_.bytes_hit += iter->second->bytes;
+    return &iter->second->entry;
+  }
+
+  // Writes to a matrix bump its epoch; fetches issued under an
+  // older epoch are not inserted.
+  size_t epoch(size_t id) const {
+    auto iter = epochs_.find(id);
+    return (iter == epochs_.end()) ? 0 : iter->second;
+  }
+
+  void insert(const Key& key, size_t epoch, Entry&& entry) {
+    if (!enabled() || epoch != this->epoch(key.id)) {
+      return;
+    }
+    size_t bytes = 0;
+    for (const auto& part : entry) {
+      bytes += part.size();
+    }
+    if (bytes > capacity_) {
+      return;
+    }
+    erase_(key);
+    evict_(bytes);
+    lru_.push_front(Node{key, bytes, std::move(entry)});
+    index_[key] = lru_.begin();
+    bytes_ += bytes;
+  }
+
+  void invalidate(size_t id, size_t i, size_t j) {
+    epochs_[id]++;
+    erase_(Key{id, i, j});
+  }
+
+  void invalidate(size_t id) {
+    epochs_[id]++;
+    for (auto iter = lru_.begin(); iter != lru_.end();) {
+      if (iter->key.id == id) {
+        bytes_ -= iter->bytes;
+        index_.erase(iter->key);
+        iter = lru_.erase(iter);
+      } else {
+        iter++;
+      }
+    }
+  }
+
+  void clear() {
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  const Stats& stats() const noexcept {
+    return stats_;
+  }
+
+  void reset_stats() {
+    stats_ = Stats();
+  }
+
+private:
+  struct Node {
+    Key key;
+    size_t bytes;
+    Entry entry;
+  };
+
+  void erase_(const Key& key) {
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      bytes_ -= iter->second->bytes;
+      lru_.erase(iter->second);
+      index_.erase(iter);
+    }
+  }
+
+  // Make room for bytes more.
+  void evict_(size_t bytes) {
+    while (!lru_.empty() && bytes_ + bytes > capacity_) {
+      bytes_ -= lru_.back().bytes;
+      index_.erase(lru_.back().key);
+      lru_.pop_back();
+      stats_.evictions++;
+    }
+  }
+
+  size_t capacity_ = 0;
+  size_t bytes_ = 0;
+  std::list<Node> lru_;
+  std::unordered_map<Key, typename std::list<Node>::iterator, KeyHash> index_;
+  std::unordered_map<size_t, size_t> epochs_;
+  Stats stats_;
+};
+
+inline TileCache& tile_cache() {
+  static TileCache cache;
+  return cache;
+}
+
+// Future returned by arget_tile when the tile cache is on.  It
+// wraps the fetch's future and, the first time get() has the
+// tile, hands it to insert to be cached.
+template <typename Future>
+class cached_future {
+public:
+  using value_type = decltype(std::declval<Future&>().get());
+
+  cached_future(Future&& future) : future_(std::move(future)) {}
+
+  cached_future(Future&& future, std::function<void(const value_type&)>&& insert)
+    : future_(std::move(future)), insert_(std::move(insert)) {}
+
+  cached_future(cached_future&&) = default;
+  cached_future& operator=(cached_future&&) = default;
+  cached_future(const cached_future&) = delete;
+
+  value_type get() {
+    value_type value = future_.get();
+    if (insert_) {
+      insert_(value);
+      insert_ = nullptr;
+    }
+    return value;
+  }
+
+  void wait() {
+    future_.wait();
+  }
+
+private:
+  Future future_;
+  std::function<void(const value_type&)> insert_;
+};
+
+template <typename T, typename Allocator>
+std::vector<char> tile_cache_bytes_(const std::vector<T, Allocator>& vec) {
+  const char* data = reinterpret_cast<const char*>(vec.data());
+  return std::vector<char>(data, data + sizeof(T)*vec.size());
+}
+
+template <typename T, typename Allocator>
+std::vector<T, Allocator> tile_cache_vector_(const std::vector<char>& bytes) {
+  std::vector<T, Allocator> vec(bytes.size() / sizeof(T));
+  if (!vec.empty()) {
+    std::memcpy(vec.data(), bytes.data(), bytes.size());
+  }
+  return vec;
+}
+
+}
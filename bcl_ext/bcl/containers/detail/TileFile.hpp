@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <bcl/bcl.hpp>
+
+// Binary checkpoint format for tiled matrices (DMatrix, SPMatrix).
+//
+//   TileFileHeader
+//   TileFileEntry[grid_m*grid_n]    (row-major tile order)
+//   tile data, each tile starting on a tile_file_align boundary
+//
+// A dense tile holds tile_m*tile_n values.  A sparse tile holds
+// vals[nnz], col_ind[nnz] and row_ptr[rows+1], each section padded
+// to 8 bytes.  Every rank writes and reads its own tiles with
+// pwrite/pread, so checkpoint and restart run fully in parallel.
+
+namespace BCL {
+
+constexpr size_t tile_file_align = 4096;
+constexpr uint64_t tile_file_version = 1;
+
+struct TileFileHeader {
+  char magic[8];
+  uint64_t version;
+  uint64_t sparse;
+  uint64_t value_size;
+  uint64_t index_size;
+  uint64_t m, n, nnz;
+  uint64_t tile_m, tile_n;
+  uint64_t grid_m, grid_n;
+  uint64_t pm, pn;
+};
+
+struct TileFileEntry {
+  uint64_t offset;
+  uint64_t nnz;
+  uint64_t bytes;
+};
+
+inline size_t tile_file_round_up_(size_t n, size_t align) {
+  return ((n + align - 1) / align) * align;
+}
+
+inline TileFileHeader make_tile_file_header_(bool sparse, size_t value_size,
+                                             size_t index_size,
+                                             size_t m, size_t n, size_t nnz,
+                                             size_t tile_m, size_t tile_n,
+                                             size_t grid_m, size_t grid_n,
+                                             size_t pm, size_t pn) {
+  TileFileHeader header;
+  std::memcpy(header.magic, "BCLTILES", 8);
+  header.version = tile_file_version;
+  header.sparse = sparse;
+  header.value_size = value_size;
+  header.index_size = index_size;
+  header.m = m;
+  header.n = n;
+  header.nnz = nnz;
+  header.tile_m = tile_m;
+  header.tile_n = tile_n;
+  header.grid_m = grid_m;
+  header.grid_n = grid_n;
+  header.pm = pm;
+  header.pn = pn;
+  return header;
+}
+
+// Assign aligned file offsets to tiles of the given sizes.
+inline std::vector<TileFileEntry> tile_file_layout_(const std::vector<size_t>& bytes,
+                                                    const std::vector<size_t>& nnzs) {
+  std::vector<TileFileEntry> tiles(bytes.size());
+  size_t offset = tile_file_round_up_(sizeof(TileFileHeader) +
+                                      sizeof(TileFileEntry)*tiles.size(),
+                                      tile_file_align);
+  for (size_t i = 0; i < tiles.size(); i++) {
+    tiles[i].offset = offset;
+    tiles[i].nnz = nnzs[i];
+    tiles[i].bytes = bytes[i];
+    offset += tile_file_round_up_(bytes[i], tile_file_align);
+  }
+  return tiles;
+}
+
+inline void tile_file_pwrite_(int fd, const void* buf, size_t bytes, size_t offset) {
+  const char* ptr = reinterpret_cast<const char*>(buf);
+  while (bytes > 0) {
+    ssize_t n = pwrite(fd, ptr, bytes, offset);
+    if (n <= 0) {
+      throw std::runtime_error("BCL: tile file write failed");
+    }
+    ptr += n;
+    bytes -= n;
+    offset += n;
+  }
+}
+
+inline void tile_file_pread_(int fd, void* buf, size_t bytes, size_t offset) {
+  char* ptr = reinterpret_cast<char*>(buf);
+  while (bytes > 0) {
+    ssize_t n = pread(fd, ptr, bytes, offset);
+    if (n <= 0) {
+      throw std::runtime_error("BCL: tile file read failed");
+    }
+    ptr += n;
+    bytes -= n;
+    offset += n;
+  }
+}
+
+// Collective.  Rank 0 creates fname and writes the header and
+// tile table; then every rank opens it for writing its tiles.
+// Returns the file descriptor.
+inline int create_tile_file(const std::string& fname, const TileFileHeader& header,
+                            const std::vector<TileFileEntry>& tiles) {
+  int ok = 1;
+  if (BCL::rank() == 0) {
+    int fd = open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ok = (fd >= 0);
+    if (ok) {
+      tile_file_pwrite_(fd, &header, sizeof(header), 0);
+      tile_file_pwrite_(fd, tiles.data(), sizeof(TileFileEntry)*tiles.size(), sizeof(header));
+      close(fd);
+    }
+  }
+  ok = BCL::broadcast(ok, 0);
+  if (!ok) {
+    throw std::runtime_error("BCL::create_tile_file cannot create " + fname);
+  }
+
+  int fd = open(fname.c_str(), O_WRONLY);
+  if (fd < 0) {
+    throw std::runtime_error("BCL::create_tile_file cannot open " + fname);
+  }
+  return fd;
+}
+
+// Collective.  Rank 0 reads and checks the header and reads the
+// tile table into its segment, where every rank fetches it with
+// one get.  Returns a read-only descriptor.
+inline int open_tile_file(const std::string& fname, TileFileHeader& header,
+                          std::vector<TileFileEntry>& tiles) {
+  int ok = 1;
+  BCL::GlobalPtr<TileFileEntry> table = nullptr;
+  if (BCL::rank() == 0) {
+    int fd = open(fname.c_str(), O_RDONLY);
+    ok = (fd >= 0);
+    if (ok) {
+      ssize_t n = pread(fd, &header, sizeof(header), 0);
+      ok = (n == sizeof(header)) && std::memcmp(header.magic, "BCLTILES", 8) == 0 &&
+           header.version == tile_file_version;
+      if (ok) {
+        size_t n_tiles = header.grid_m*header.grid_n;
+        table = BCL::alloc<TileFileEntry>(std::max<size_t>(1, n_tiles));
+        if (table != nullptr) {
+          tile_file_pread_(fd, table.local(), sizeof(TileFileEntry)*n_tiles, sizeof(header));
+        }
+      }
+      close(fd);
+    }
+  }
+  ok = BCL::broadcast(ok, 0);
+  if (!ok) {
+    throw std::runtime_error("BCL::open_tile_file: " + fname + " is not a BCL tile file");
+  }
+  table = BCL::broadcast(table, 0);
+  if (table == nullptr) {
+    throw std::runtime_error("BCL::open_tile_file: not enough memory for the tile table");
+  }
+  header = BCL::broadcast(header, 0);
+  tiles.resize(header.grid_m*header.grid_n);
+  BCL::rget(table, tiles.data(), tiles.size());
+  BCL::barrier();
+  if (BCL::rank() == 0) {
+    BCL::dealloc(table);
+  }
+
+  int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("BCL::open_tile_file cannot open " + fname);
+  }
+  return fd;
+}
+
+}
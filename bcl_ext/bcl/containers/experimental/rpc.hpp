@@ -1,28 +1,66 @@
 #pragma once
 
-#include <bcl/containers/CircularQueue.hpp>
+#include <bcl/bcl.hpp>
+#include <bcl/core/util/Backoff.hpp>
 #include <type_traits>
-#include <array>
-#include <iostream>
-#include <functional>
-#include <cassert>
-#include <list>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <deque>
+#include <vector>
+#include <stdexcept>
+
+#include <unistd.h>
+
+// RPC engine.
+//
+// Every rank holds, for each source rank, a byte ring of incoming
+// requests and a byte ring of incoming replies.  Each ring has a
+// single writer, so a send is a put of the batch followed by a put
+// of the new tail, with no atomics.  Requests are appended to a
+// per-destination batch and shipped when the batch reaches
+// rpc_buffer_size bytes (buffered_rpc), immediately (rpc and
+// async_rpc), or on flush_rpc().  Sends never block: whatever does
+// not fit in the destination's ring stays batched and goes out on
+// a later progress_rpc().
+//
+// progress_rpc() sends pending requests, runs every request that
+// has arrived, sends their replies back in one batch per source,
+// and completes the futures whose replies have arrived.  Waiting on
+// a future and flushing call it, so no service thread is needed.
+// With progress_thread = true, init_rpc() starts one to serve
+// requests while the caller computes; this needs BCL::init(..., true).
+// Issuing RPCs is then thread safe: ids are taken atomically and
+// each mailbox's outgoing batches are guarded by a lock.
+//
+// RPC bodies may issue RPCs and wait on them.  The wait serves
+// incoming requests recursively on the same thread, so ranks that
+// call into each other do not deadlock, at the cost of one level
+// of stack per nested wait.
+//
+// Arguments and return values must be trivially copyable; their
+// size is limited only by max_rpc_size.  Functions must convert
+// to function pointers, e.g. lambdas without captures.
 
 namespace BCL {
 
-constexpr size_t max_rpc_size = 8;
-constexpr size_t max_rpc_return_val_size = 8;
-constexpr size_t rpc_queue_size = 8192;
+// Bytes in each request and reply ring.  A rank holds 2*nprocs rings.
+constexpr size_t rpc_ring_size = 16384;
+// Largest request or reply record, header included.
+constexpr size_t max_rpc_size = 4096;
+// Futures issued but not yet consumed by get().
+constexpr size_t rpc_max_outstanding = 1 << 16;
 
-constexpr size_t rpc_buffer_size = 200;
-constexpr size_t return_val_buffer_size = 2048;
+static_assert(2*max_rpc_size <= rpc_ring_size);
 
-static_assert(rpc_buffer_size < rpc_queue_size && return_val_buffer_size < rpc_queue_size);
-
-constexpr size_t rpc_kill_nonce = std::numeric_limits<size_t>::max();
-constexpr size_t rpc_flush_nonce = rpc_kill_nonce-1;
-
-void flush_rpc();
+// buffered_rpc() ships a destination's batch once it holds this
+// many bytes.
+inline size_t rpc_buffer_size = 4096;
 
 // Get a *position independent* function pointer
 template <typename T>
@@ -37,397 +75,546 @@ T* resolve_pi_fnptr_(std::uintptr_t fn) {
   return reinterpret_cast<T*>(fn + reinterpret_cast<std::uintptr_t>(init));
 }
 
-template <typename Fn, typename... Args>
-struct complete_rpc;
-
-template <typename Fn, typename... Args>
-complete_rpc(Fn&& fn, Args&&... args) -> complete_rpc<Fn, Args...>;
-
-struct rpc_t {
-  std::size_t rpc_id_;
-  bool buffered_;
-  std::size_t source_rank_;
-  std::uintptr_t fn_;
-  std::uintptr_t invoker_;
-  std::array<char, max_rpc_size> data_;
-
-  rpc_t() = default;
-  rpc_t(const rpc_t&) = default;
-  rpc_t& operator=(const rpc_t&) = default;
+// A request or reply in a ring.  Requests carry the packed
+// arguments and replies the return value, if any.
+struct rpc_header_t {
+  uint32_t size;     // of the whole record, a multiple of 8
+  uint32_t payload;  // bytes after the header
+  uint64_t rpc_id;
+  std::uintptr_t fn;
+  std::uintptr_t invoker;
+};
 
-  rpc_t(rpc_t&&) = default;
-  rpc_t& operator=(rpc_t&&) = default;
+constexpr size_t rpc_record_size_(size_t payload) {
+  return (sizeof(rpc_header_t) + payload + 7) & ~size_t(7);
+}
 
-  rpc_t(std::size_t rpc_id, bool buffered = false, std::size_t source_rank = BCL::rank()) : rpc_id_(rpc_id), buffered_(buffered), source_rank_(source_rank) {}
+// Arguments and return values travel as raw bytes.
+template <typename T>
+constexpr bool rpc_copyable_ = std::is_trivially_copy_constructible<T>::value &&
+                               std::is_trivially_destructible<T>::value;
 
-  template <typename Fn, typename... Args>
-  void load(Fn&& fn, Args&&... args) {
-    using tuple_t = std::tuple<std::remove_reference_t<Args>...>;
-    static_assert(sizeof(tuple_t) <= max_rpc_size, "Max RPC size too small." );
+class rpc_mailbox_ {
+public:
+  void init(size_t ring_size) {
+    ring_size_ = ring_size;
+    size_t nprocs = BCL::nprocs();
+
+    BCL::GlobalPtr<char> ring = BCL::alloc<char>(nprocs*ring_size);
+    BCL::GlobalPtr<uint64_t> tails = BCL::alloc<uint64_t>(nprocs);
+    BCL::GlobalPtr<uint64_t> heads = BCL::alloc<uint64_t>(nprocs);
+    if (ring == nullptr || tails == nullptr || heads == nullptr) {
+      throw std::runtime_error("BCL::init_rpc: not enough memory for RPC rings.");
+    }
+    std::fill(tails.local(), tails.local() + nprocs, 0);
+    std::fill(heads.local(), heads.local() + nprocs, 0);
+
+    rings_.resize(nprocs);
+    tails_.resize(nprocs);
+    heads_.resize(nprocs);
+    rings_[BCL::rank()] = ring;
+    tails_[BCL::rank()] = tails;
+    heads_[BCL::rank()] = heads;
+    for (size_t rank = 0; rank < nprocs; rank++) {
+      rings_[rank] = BCL::broadcast(rings_[rank], rank);
+      tails_[rank] = BCL::broadcast(tails_[rank], rank);
+      heads_[rank] = BCL::broadcast(heads_[rank], rank);
+    }
 
-    this->fn_ = get_pi_fnptr_(reinterpret_cast<char*>(+fn));
+    sent_.assign(nprocs, 0);
+    head_buf_.assign(nprocs, 0);
+    outbox_.assign(nprocs, std::vector<char>());
+    outbox_begin_.assign(nprocs, 0);
+    tail_buf_.assign(nprocs, 0);
+  }
 
-    invoker_ = get_pi_fnptr_(
-             reinterpret_cast<char*>(&decltype(
-                  complete_rpc(std::forward<Fn>(fn), std::forward<Args>(args)...))::invoke));
+  void finalize() {
+    BCL::dealloc(rings_[BCL::rank()]);
+    BCL::dealloc(tails_[BCL::rank()]);
+    BCL::dealloc(heads_[BCL::rank()]);
+    rings_.clear();
+    tails_.clear();
+    heads_.clear();
+  }
 
-    tuple_t& tuple = *reinterpret_cast<tuple_t*>(data_.data());
-    new(&tuple) tuple_t();
+  // Append a record with the given payload to dest's batch.
+  void append(size_t dest, uint64_t rpc_id, const void* payload, size_t size,
+              std::uintptr_t fn = 0, std::uintptr_t invoker = 0) {
+    rpc_header_t header{uint32_t(rpc_record_size_(size)), uint32_t(size),
+                        rpc_id, fn, invoker};
+    std::lock_guard<std::mutex> lock(outbox_mutex_);
+    auto& box = outbox_[dest];
+    size_t offset = box.size();
+    box.resize(offset + header.size);
+    std::memcpy(box.data() + offset, &header, sizeof(header));
+    if (size > 0) {
+      std::memcpy(box.data() + offset + sizeof(header), payload, size);
+    }
+  }
 
-    tuple = std::tie(args...);
+  // Bytes waiting to be sent to dest.
+  size_t buffered(size_t dest) {
+    std::lock_guard<std::mutex> lock(outbox_mutex_);
+    return outbox_[dest].size() - outbox_begin_[dest];
   }
-};
 
-struct return_value_t {
-  std::size_t rpc_id_;
-  std::array<char, max_rpc_return_val_size> data_;
+  // Ship as many whole records of dest's batch as dest's ring
+  // has room for.  Returns true once nothing is left.
+  bool send(size_t dest) {
+    std::lock_guard<std::mutex> lock(outbox_mutex_);
+    return send_(dest);
+  }
 
-  return_value_t() = default;
-  return_value_t(const return_value_t&) = default;
-  return_value_t& operator=(const return_value_t&) = default;
+  bool send_all() {
+    std::lock_guard<std::mutex> lock(outbox_mutex_);
+    bool sent = true;
+    for (size_t dest = 0; dest < outbox_.size(); dest++) {
+      sent &= send_(dest);
+    }
+    return sent;
+  }
 
-  return_value_t(return_value_t&&) = default;
-  return_value_t& operator=(return_value_t&&) = default;
+  // Call fn(source, header, payload) on each record that has
+  // arrived.  A source's ring space is released before its batch
+  // runs, so fn may send, and may call receive() again.  Only one
+  // thread may receive at a time.
+  template <typename Fn>
+  size_t receive(Fn&& fn) {
+    size_t nprocs = tail_buf_.size();
+    BCL::rget(tails_[BCL::rank()], tail_buf_.data(), nprocs);
+    sync_local_();
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Each nesting level copies its batches to its own buffer.
+    if (depth_ == batches_.size()) {
+      batches_.emplace_back();
+    }
+    std::vector<char>& batch = batches_[depth_++];
 
-  return_value_t(std::size_t rpc_id) : rpc_id_(rpc_id) {}
+    uint64_t* heads = heads_[BCL::rank()].local();
+    const char* rings = rings_[BCL::rank()].local();
+    size_t n_records = 0;
 
-  template <typename T>
-  void load(const T& value) {
-    static_assert(sizeof(T) <= max_rpc_return_val_size, "Max return val size too small");
-    *reinterpret_cast<T*>(data_.data()) = value;
+    for (size_t src = 0; src < nprocs; src++) {
+      uint64_t head = heads[src];
+      size_t len = tail_buf_[src] - head;
+      if (len == 0) {
+        continue;
+      }
+      batch.resize(len);
+      const char* ring = rings + src*ring_size_;
+      size_t slot = head % ring_size_;
+      size_t first_len = std::min(len, ring_size_ - slot);
+      std::memcpy(batch.data(), ring + slot, first_len);
+      std::memcpy(batch.data() + first_len, ring, len - first_len);
+      std::atomic_thread_fence(std::memory_order_release);
+      heads[src] = tail_buf_[src];
+
+      for (size_t offset = 0; offset < len; n_records++) {
+        rpc_header_t header;
+        std::memcpy(&header, batch.data() + offset, sizeof(header));
+        fn(src, header, batch.data() + offset + sizeof(header));
+        offset += header.size;
+      }
+    }
+    depth_--;
+    return n_records;
   }
-};
-
 
-template <typename Fn, typename... Args>
-struct complete_rpc {
+private:
+  // send() with outbox_mutex_ held.
+  bool send_(size_t dest) {
+    auto& box = outbox_[dest];
+    size_t& begin = outbox_begin_[dest];
+    if (begin == box.size()) {
+      return true;
+    }
+    if (sent_[dest] + box.size() - begin - head_buf_[dest] > ring_size_) {
+      head_buf_[dest] = BCL::rget(heads_[dest] + BCL::rank());
+    }
+    size_t room = ring_size_ - (sent_[dest] - head_buf_[dest]);
+    size_t end = begin;
+    while (end < box.size()) {
+      rpc_header_t header;
+      std::memcpy(&header, box.data() + end, sizeof(header));
+      if (end + header.size - begin > room) {
+        break;
+      }
+      end += header.size;
+    }
+    if (end == begin) {
+      return false;
+    }
 
-  using return_value = decltype(std::declval<Fn>()(std::declval<Args>()...));
+    size_t len = end - begin;
+    BCL::GlobalPtr<char> ring = rings_[dest] + BCL::rank()*ring_size_;
+    size_t slot = sent_[dest] % ring_size_;
+    size_t first_len = std::min(len, ring_size_ - slot);
+    BCL::rput(box.data() + begin, ring + slot, first_len);
+    if (first_len < len) {
+      BCL::rput(box.data() + begin + first_len, ring, len - first_len);
+    }
+    // The tail must not land before the records it covers.
+    BCL::flush();
+    sent_[dest] += len;
+    BCL::rput(sent_[dest], tails_[dest] + BCL::rank());
+
+    begin = end;
+    if (begin == box.size()) {
+      box.clear();
+      begin = 0;
+    } else if (2*begin > box.size()) {
+      box.erase(box.begin(), box.begin() + begin);
+      begin = 0;
+    }
+    return begin == box.size();
+  }
 
-  static constexpr bool has_void_return_value = std::is_void<return_value>::value;
+  // The rings and heads are written by puts and read by loads.
+  // Under MPI's separate memory model the two copies of the
+  // window must be synced in between; this also publishes our
+  // last stores to the heads.
+  static void sync_local_() {
+#if !defined(SHMEM) && !defined(GASNET_EX) && !defined(UPCXX)
+    MPI_Win_sync(BCL::win);
+#endif
+  }
 
-  complete_rpc(Fn&& fn, Args&&... args) {}
+  size_t ring_size_ = 0;
+  // Per rank: its rings (one per source), and their tails
+  // (written by the sources) and heads (written by the owner).
+  std::vector<BCL::GlobalPtr<char>> rings_;
+  std::vector<BCL::GlobalPtr<uint64_t>> tails_;
+  std::vector<BCL::GlobalPtr<uint64_t>> heads_;
+
+  // Sending side, per destination: bytes sent, last seen head,
+  // and the batch being filled, of which the first
+  // outbox_begin_ bytes have been sent.
+  std::vector<uint64_t> sent_;
+  std::vector<uint64_t> head_buf_;
+  std::vector<std::vector<char>> outbox_;
+  std::vector<size_t> outbox_begin_;
+  // Guards the sending side, which any thread may use.
+  std::mutex outbox_mutex_;
+
+  // Receiving side.  A deque, since nested receive() calls
+  // must not move their callers' buffers.
+  std::vector<uint64_t> tail_buf_;
+  std::deque<std::vector<char>> batches_;
+  size_t depth_ = 0;
+};
 
-  template <std::size_t... I>
-  static auto invoke_impl_(rpc_t& rpc_vals, std::index_sequence<I...>) {
-    using fn_t = decltype(+std::declval<std::remove_reference_t<Fn>>());
-    fn_t fn = reinterpret_cast<fn_t>(resolve_pi_fnptr_(rpc_vals.fn_));
-    using tuple_t = std::tuple<std::remove_reference_t<Args>...>;
-    tuple_t& args_ptr = *reinterpret_cast<tuple_t*>(rpc_vals.data_.data());
+// Completion slot of an RPC, indexed by id % rpc_max_outstanding.
+// The issuer moves it from idle to pending; the reply moves it to
+// ready and get() back to idle.  A future dropped before its reply
+// marks the slot abandoned, and the reply frees it.
+struct rpc_slot_ {
+  constexpr static int idle = 0;
+  constexpr static int pending = 1;
+  constexpr static int ready = 2;
+  constexpr static int abandoned = 3;
+
+  std::atomic<int> state{idle};
+  std::vector<char> value;
+};
 
-    if constexpr(has_void_return_value) {
-      std::invoke(std::forward<fn_t>(fn),
-                  std::forward<Args>(std::get<I>(args_ptr))...);
-    } else {
-      return std::invoke(std::forward<fn_t>(fn),
-                         std::forward<Args>(std::get<I>(args_ptr))...);
-    }
-  }
+inline rpc_mailbox_ rpc_requests_;
+inline rpc_mailbox_ rpc_replies_;
+inline std::unique_ptr<rpc_slot_[]> rpc_slots_;
+inline std::atomic<uint64_t> rpc_nonce_{0};
+inline std::atomic<size_t> rpc_outstanding_{0};
+// On rank 0, the number of ranks done with quiesce_rpc(), summed
+// over calls; rpc_quiesce_calls_ counts the calls.
+inline BCL::GlobalPtr<int> rpc_done_;
+inline int rpc_quiesce_calls_ = 0;
+
+// Set while a thread is inside serve_rpc_(), so that only one
+// thread serves at a time.  rpc_serve_depth_ lets that thread
+// reenter it from RPC bodies.
+inline std::atomic<bool> rpc_progress_busy_{false};
+inline thread_local size_t rpc_serve_depth_ = 0;
+inline std::atomic<bool> rpc_stop_{false};
+inline std::thread rpc_thread_;
+
+using rpc_invoker_type = void (*)(size_t, const rpc_header_t&, const char*);
 
-  static return_value_t invoke(rpc_t& rpc_vals) {
-    return_value_t rv;
-    if constexpr(has_void_return_value) {
-      invoke_impl_(rpc_vals, std::index_sequence_for<Args...>{});
+template <typename Fn, typename... Args>
+struct rpc_invoker_ {
+  using fn_t = decltype(+std::declval<std::remove_reference_t<Fn>>());
+  using tuple_t = std::tuple<std::decay_t<Args>...>;
+  using return_value = std::invoke_result_t<Fn, Args...>;
+
+  static_assert((rpc_copyable_<std::decay_t<Args>> && ...),
+                "BCL::rpc: arguments must be trivially copyable.");
+  static_assert(rpc_record_size_(sizeof(tuple_t)) <= max_rpc_size,
+                "BCL::rpc: arguments larger than max_rpc_size.");
+
+  // Run the request and append its reply for the source.
+  static void invoke(size_t source, const rpc_header_t& header,
+                     const char* payload) {
+    fn_t fn = reinterpret_cast<fn_t>(resolve_pi_fnptr_(header.fn));
+    alignas(tuple_t) char buf[sizeof(tuple_t)];
+    std::memcpy(buf, payload, sizeof(tuple_t));
+    tuple_t& args = *reinterpret_cast<tuple_t*>(buf);
+
+    if constexpr(std::is_void<return_value>::value) {
+      std::apply(fn, args);
+      rpc_replies_.append(source, header.rpc_id, nullptr, 0);
     } else {
-      rv.load(invoke_impl_(rpc_vals, std::index_sequence_for<Args...>{}));
+      static_assert(rpc_copyable_<return_value>,
+                    "BCL::rpc: return value must be trivially copyable.");
+      static_assert(rpc_record_size_(sizeof(return_value)) <= max_rpc_size,
+                    "BCL::rpc: return value larger than max_rpc_size.");
+      return_value rv = std::apply(fn, args);
+      rpc_replies_.append(source, header.rpc_id, &rv, sizeof(rv));
     }
-    return rv;
   }
 };
 
-// TODO: Add buffering.
-//       Buffering will require careful thought about progress guarantees.
-
-std::vector<BCL::CircularQueue<rpc_t>> rpc_requests_queue_;
-std::vector<std::vector<rpc_t>> rpc_requests_buffer_;
-
-std::vector<BCL::CircularQueue<return_value_t>> rpc_results_queue_;
-std::vector<std::vector<return_value_t>> rpc_results_buffer_;
-
-std::unordered_map<size_t, return_value_t> rpc_results_;
-std::mutex rpc_mutex_;
-
-std::thread rpc_thread_;
-
-size_t rpc_nonce_;
-
-void service_rpc();
-
-void init_rpc() {
-  rpc_nonce_ = 0;
-
-  for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
-    rpc_requests_queue_.emplace_back(rank, rpc_queue_size);
-    rpc_results_queue_.emplace_back(rank, rpc_queue_size);
+inline void complete_rpc_(const rpc_header_t& header, const char* payload) {
+  rpc_slot_& slot = rpc_slots_[header.rpc_id % rpc_max_outstanding];
+  slot.value.assign(payload, payload + header.payload);
+  int expected = rpc_slot_::pending;
+  if (!slot.state.compare_exchange_strong(expected, rpc_slot_::ready,
+                                          std::memory_order_acq_rel)) {
+    slot.state.store(rpc_slot_::idle, std::memory_order_release);
   }
-
-  rpc_requests_buffer_.resize(BCL::nprocs());
-  rpc_results_buffer_.resize(BCL::nprocs());
-
-  rpc_thread_ = std::thread(service_rpc);
-
-  BCL::barrier();
+  rpc_outstanding_--;
 }
 
-using invoker_type = return_value_t (*)(BCL::rpc_t &);
-
-return_value_t run_rpc(rpc_t shtuff);
-
-void send_rpc() {
-  auto fn = [](int a, int b) -> void {
-               std::cout << "Rank " << BCL::rank() << " sees " << a + b << std::endl;
-            };
-  int a = 12;
-  int b = 12;
-
-  rpc_t shtuff(0);
-
-  shtuff.load(fn, a, b);
-
-  return_value_t rv = run_rpc(shtuff);
+// Run the requests that have arrived, send their replies, and
+// complete the RPCs whose replies have arrived.  Returns the
+// number of requests and replies handled.
+inline size_t serve_rpc_() {
+  if (rpc_serve_depth_ == 0 &&
+      rpc_progress_busy_.exchange(true, std::memory_order_acquire)) {
+    return 0;
+  }
+  rpc_serve_depth_++;
+  size_t n = rpc_requests_.receive([](size_t source, const rpc_header_t& header,
+                                      const char* payload) {
+    auto invoker = reinterpret_cast<rpc_invoker_type>(resolve_pi_fnptr_(header.invoker));
+    invoker(source, header, payload);
+  });
+  // Replies that do not fit go out on a later call.
+  rpc_replies_.send_all();
+  n += rpc_replies_.receive([](size_t, const rpc_header_t& header,
+                               const char* payload) {
+    complete_rpc_(header, payload);
+  });
+  if (--rpc_serve_depth_ == 0) {
+    rpc_progress_busy_.store(false, std::memory_order_release);
+  }
+  return n;
 }
 
-return_value_t run_rpc(rpc_t shtuff) {
-  invoker_type invoker = reinterpret_cast<invoker_type>
-                                           (resolve_pi_fnptr_(shtuff.invoker_));
-  return_value_t rv = invoker(shtuff);
-  rv.rpc_id_ = shtuff.rpc_id_;
-  return rv;
+// Call from the thread that issues RPCs.
+inline size_t progress_rpc() {
+  rpc_requests_.send_all();
+  return serve_rpc_();
 }
 
+template <typename T>
+struct rpc_future {
+public:
+  rpc_future(uint64_t rpc_id) : rpc_id_(rpc_id) {}
 
-template <typename Fn, typename... Args>
-auto rpc(size_t rank, Fn&& fn, Args&&... args) {
-  rpc_t rpc_(rpc_nonce_);
-
-  rpc_.load(std::forward<Fn>(fn), std::forward<Args>(args)...);
+  rpc_future(const rpc_future&) = delete;
+  rpc_future& operator=(const rpc_future&) = delete;
 
-  Backoff backoff;
-  while (!rpc_requests_queue_[rank].push_atomic_impl_(rpc_, true)) {
-    backoff.backoff();
+  rpc_future(rpc_future&& other) : rpc_id_(other.rpc_id_), valid_(other.valid_) {
+    other.valid_ = false;
   }
 
-  backoff.reset();
+  rpc_future& operator=(rpc_future&& other) {
+    release_();
+    rpc_id_ = other.rpc_id_;
+    valid_ = other.valid_;
+    other.valid_ = false;
+    return *this;
+  }
 
-  bool success = false;
+  ~rpc_future() {
+    release_();
+  }
 
-  do {
-    rpc_mutex_.lock();
-    success = rpc_results_.find(rpc_nonce_) != rpc_results_.end();
-    if (!success) {
-      rpc_mutex_.unlock();
+  bool is_ready() {
+    if (!ready_()) {
+      progress_rpc();
     }
-    backoff.backoff();
-  } while (!success);
-
-  return_value_t rv_serialized_ = rpc_results_[rpc_nonce_];
-  rpc_results_.erase(rpc_nonce_);
-  rpc_mutex_.unlock();
-  using return_value = decltype(std::declval<Fn>()(std::declval<Args>()...));
-
-  rpc_nonce_++;
-
-  if constexpr(!std::is_void<return_value>::value) {
-    return *reinterpret_cast<return_value*>(rv_serialized_.data_.data());
+    return ready_();
   }
-}
-
-template <typename T>
-struct rpc_future {
-public:
-
-  rpc_future(size_t rpc_id) : rpc_id_(rpc_id) {}
 
   T get() {
     Backoff backoff;
-
-    bool success = false;
-    do {
-      rpc_mutex_.lock();
-      success = rpc_results_.find(rpc_id_) != rpc_results_.end();
-      if (!success) {
-        rpc_mutex_.unlock();
-      }
+    while (!is_ready()) {
       backoff.backoff();
-    } while (!success);
-
-    return_value_t rv_serialized_ = rpc_results_[rpc_id_];
-    rpc_results_.erase(rpc_id_);
-    rpc_mutex_.unlock();
+    }
+    rpc_slot_& slot = slot_();
+    valid_ = false;
 
     if constexpr(!std::is_void<T>::value) {
-      return *reinterpret_cast<T*>(rv_serialized_.data_.data());
+      alignas(T) char buf[sizeof(T)];
+      std::memcpy(buf, slot.value.data(), sizeof(T));
+      slot.state.store(rpc_slot_::idle, std::memory_order_release);
+      return *reinterpret_cast<T*>(buf);
+    } else {
+      slot.state.store(rpc_slot_::idle, std::memory_order_release);
     }
   }
 
   template <class Rep, class Period>
   std::future_status wait_for(const std::chrono::duration<Rep,Period>& timeout_duration) {
-    std::lock_guard<std::mutex> guard(rpc_mutex_);
-    if (rpc_results_.find(rpc_id_) != rpc_results_.end()) {
-      return std::future_status::ready;
-    } else {
-      return std::future_status::timeout;
-    }
+    auto end = std::chrono::steady_clock::now() + timeout_duration;
+    do {
+      if (is_ready()) {
+        return std::future_status::ready;
+      }
+    } while (std::chrono::steady_clock::now() < end);
+    return std::future_status::timeout;
   }
 
 private:
-  size_t rpc_id_;
-};
+  rpc_slot_& slot_() const {
+    return rpc_slots_[rpc_id_ % rpc_max_outstanding];
+  }
 
-template <typename Fn, typename... Args>
-auto async_rpc(size_t rank, Fn&& fn, Args&&... args) {
-  static_assert(std::is_invocable<Fn, Args...>::value, "Callable passed to async_rpc not valid with given arguments.");
-  rpc_t rpc_(rpc_nonce_);
+  bool ready_() const {
+    return slot_().state.load(std::memory_order_acquire) == rpc_slot_::ready;
+  }
+
+  void release_() {
+    if (!valid_ || rpc_slots_ == nullptr) {
+      return;
+    }
+    int expected = rpc_slot_::pending;
+    if (!slot_().state.compare_exchange_strong(expected, rpc_slot_::abandoned,
+                                               std::memory_order_acq_rel)) {
+      slot_().state.store(rpc_slot_::idle, std::memory_order_release);
+    }
+    valid_ = false;
+  }
 
-  rpc_.load(std::forward<Fn>(fn), std::forward<Args>(args)...);
+  uint64_t rpc_id_;
+  bool valid_ = true;
+};
 
-  // bool success = rpc_requests_queue_[rank].push(rpc_);
-  // assert(success);
+template <typename Fn, typename... Args>
+auto issue_rpc_(size_t rank, Fn&& fn, Args&&... args) {
+  static_assert(std::is_invocable<Fn, Args...>::value, "Callable passed to rpc not valid with given arguments.");
+  using invoker = rpc_invoker_<Fn, Args...>;
+  using return_value = typename invoker::return_value;
 
+  uint64_t rpc_id = rpc_nonce_.fetch_add(1, std::memory_order_relaxed);
+  rpc_slot_& slot = rpc_slots_[rpc_id % rpc_max_outstanding];
   Backoff backoff;
-  while (!rpc_requests_queue_[rank].push_atomic_impl_(rpc_, true)) {
+  int expected = rpc_slot_::idle;
+  while (!slot.state.compare_exchange_weak(expected, rpc_slot_::pending,
+                                           std::memory_order_acquire)) {
+    expected = rpc_slot_::idle;
+    progress_rpc();
     backoff.backoff();
   }
+  rpc_outstanding_++;
 
-  using return_value = decltype(std::declval<Fn>()(std::declval<Args>()...));
+  typename invoker::tuple_t packed(std::forward<Args>(args)...);
+  rpc_requests_.append(rank, rpc_id, &packed, sizeof(packed),
+                       get_pi_fnptr_(reinterpret_cast<char*>(+fn)),
+                       get_pi_fnptr_(reinterpret_cast<char*>(&invoker::invoke)));
 
-  return rpc_future<return_value>(rpc_nonce_++);
+  return rpc_future<return_value>(rpc_id);
 }
 
 template <typename Fn, typename... Args>
-auto buffered_rpc(size_t rank, Fn&& fn, Args&&... args) {
-  static_assert(std::is_invocable<Fn, Args...>::value, "Callable passed to buffered_rpc not valid with given arguments.");
-  rpc_t rpc_(rpc_nonce_, true);
-
-  rpc_.load(std::forward<Fn>(fn), std::forward<Args>(args)...);
+auto async_rpc(size_t rank, Fn&& fn, Args&&... args) {
+  auto future = issue_rpc_(rank, std::forward<Fn>(fn), std::forward<Args>(args)...);
+  rpc_requests_.send(rank);
+  return future;
+}
 
-  rpc_mutex_.lock();
-  rpc_requests_buffer_[rank].push_back(rpc_);
+template <typename Fn, typename... Args>
+auto rpc(size_t rank, Fn&& fn, Args&&... args) {
+  return async_rpc(rank, std::forward<Fn>(fn), std::forward<Args>(args)...).get();
+}
 
-  if (rpc_requests_buffer_[rank].size() >= rpc_buffer_size) {
-    std::vector<rpc_t> send_buf = std::move(rpc_requests_buffer_[rank]);
-    rpc_mutex_.unlock();
-    Backoff backoff;
-    while (!rpc_requests_queue_[rank].push_atomic_impl_(send_buf, true)) {
-      backoff.backoff();
-    }
-  } else {
-    rpc_mutex_.unlock();
+// Sent with the next full batch for rank, or by flush_rpc().
+template <typename Fn, typename... Args>
+auto buffered_rpc(size_t rank, Fn&& fn, Args&&... args) {
+  auto future = issue_rpc_(rank, std::forward<Fn>(fn), std::forward<Args>(args)...);
+  if (rpc_requests_.buffered(rank) >= rpc_buffer_size) {
+    rpc_requests_.send(rank);
   }
-
-  using return_value = decltype(std::declval<Fn>()(std::declval<Args>()...));
-
-  return rpc_future<return_value>(rpc_nonce_++);
+  return future;
 }
 
-void finalize_rpc() {
-  BCL::barrier();
-  rpc_t rpc_(rpc_kill_nonce);
-
-  rpc_requests_queue_[BCL::rank()].push_atomic_impl_(rpc_, true);
-
-  rpc_thread_.join();
+// Start sending every buffered RPC.  Does not wait for room in
+// the destinations' rings; waiting on the futures finishes the job.
+inline void flush_rpc() {
+  progress_rpc();
+}
 
-  BCL::barrier();
+inline void flush_signal() {
+  flush_rpc();
 }
 
-void service_rpc() {
-  using results_future_type = typename BCL::CircularQueue<return_value_t>::push_future;
-  using requests_future_type = typename BCL::CircularQueue<rpc_t>::push_future;
-
-  std::list<results_future_type> results_futures;
-  std::list<requests_future_type> requests_futures;
-
-  while (true) {
-    bool idle = true;
-    rpc_t rpc_;
-    return_value_t rv_;
-    if (rpc_requests_queue_[BCL::rank()].pop(rpc_)) {
-      idle = false;
-      if (rpc_.rpc_id_ == rpc_kill_nonce) {
-        return;
-      } else if (rpc_.rpc_id_ == rpc_flush_nonce) {
-        // flush?
-      } else {
-        return_value_t rv = run_rpc(rpc_);
-        if (!rpc_.buffered_) {
-          auto fut = rpc_results_queue_[rpc_.source_rank_].async_push({rv});
-          results_futures.push_back(std::move(fut));
-        } else {
-          rpc_mutex_.lock();
-          rpc_results_buffer_[rpc_.source_rank_].push_back(rv);
-
-          if (rpc_results_buffer_[rpc_.source_rank_].size() >= return_val_buffer_size) {
-            std::vector<return_value_t> send_buf = std::move(rpc_results_buffer_[rpc_.source_rank_]);
-            rpc_mutex_.unlock();
-            auto fut = rpc_results_queue_[rpc_.source_rank_].async_push(std::move(send_buf));
-          } else {
-            rpc_mutex_.unlock();
-          }
+inline void init_rpc(bool progress_thread = false) {
+  rpc_nonce_ = 0;
+  rpc_outstanding_ = 0;
+  rpc_slots_.reset(new rpc_slot_[rpc_max_outstanding]);
+  rpc_requests_.init(rpc_ring_size);
+  rpc_replies_.init(rpc_ring_size);
+  if (BCL::rank() == 0) {
+    rpc_done_ = BCL::alloc<int>(1);
+    *rpc_done_.local() = 0;
+  }
+  rpc_done_ = BCL::broadcast(rpc_done_, 0);
+  rpc_quiesce_calls_ = 0;
+
+  rpc_stop_ = false;
+  if (progress_thread) {
+    rpc_thread_ = std::thread([] {
+      while (!rpc_stop_.load(std::memory_order_relaxed)) {
+        if (serve_rpc_() == 0) {
+          usleep(100);
         }
       }
-    }
-
-    if (rpc_results_queue_[BCL::rank()].pop(rv_)) {
-      std::lock_guard<std::mutex> guard(rpc_mutex_);
-      rpc_results_[rv_.rpc_id_] = rv_;
-      idle = false;
-    }
-
-    for (auto it = results_futures.begin(); it != results_futures.end(); ) {
-      if ((*it).is_ready()) {
-        auto new_val = it;
-        new_val++;
-        results_futures.erase(it);
-        it = new_val;
-      } else {
-        it++;
-      }
-    }
+    });
+  }
 
-    for (auto it = requests_futures.begin(); it != requests_futures.end(); ) {
-      if ((*it).is_ready()) {
-        auto new_val = it;
-        new_val++;
-        requests_futures.erase(it);
-        it = new_val;
-      } else {
-        it++;
-      }
-    }
+  BCL::barrier();
+}
 
-    if (idle) {
-      usleep(100);
-      // std::this_thread::yield();
-    }
+// Collective.  Serve RPCs until every rank's have been answered.
+// A blocking collective here could stall a rank whose requests are
+// still queued on us, so ranks count themselves done with an atomic
+// and keep serving until all have.  An RPC is answered before its
+// issuer counts itself done, so none are in flight after.
+inline void quiesce_rpc() {
+  while (rpc_outstanding_.load() > 0) {
+    progress_rpc();
+  }
+  int target = int(BCL::nprocs())*++rpc_quiesce_calls_;
+  BCL::fetch_and_op<int>(rpc_done_, 1, BCL::plus<int>{});
+  while (BCL::rget(rpc_done_) < target) {
+    progress_rpc();
   }
 }
 
-void flush_signal() {
-  for (size_t i = 0; i < rpc_results_buffer_.size(); i++) {
-    rpc_mutex_.lock();
-    Backoff backoff;
-    std::vector<return_value_t> send_buf = std::move(rpc_results_buffer_[i]);
-    rpc_mutex_.unlock();
-    while (!rpc_results_queue_[i].push_atomic_impl_(send_buf, true)) {
-      backoff.backoff();
-    }
-  }
+inline void finalize_rpc() {
+  quiesce_rpc();
 
-  for (size_t i = 0; i < rpc_requests_buffer_.size(); i++) {
-    Backoff backoff;
-    rpc_mutex_.lock();
-    std::vector<rpc_t> send_buf = std::move(rpc_requests_buffer_[i]);
-    rpc_mutex_.unlock();
-    while (!rpc_requests_queue_[i].push_atomic_impl_(send_buf, true)) {
-      backoff.backoff();
-    }
+  if (rpc_thread_.joinable()) {
+    rpc_stop_ = true;
+    rpc_thread_.join();
   }
-}
 
-// TODO: something more elaborate, a la HashMapBuffer
-void flush_rpc() {
-  flush_signal();
+  BCL::barrier();
+  rpc_requests_.finalize();
+  rpc_replies_.finalize();
+  rpc_slots_.reset();
+  if (BCL::rank() == 0) {
+    BCL::dealloc(rpc_done_);
+  }
 }
 
 } // end BCL
@@ -5,7 +5,6 @@
 #include <cstdlib>
 #include <cstdio>
 #include <stdexcept>
-#include <regex.h>
 #include <cassert>
 #include <array>
 #include <memory>
@@ -42,6 +41,7 @@ enum FileFormat {
   MatrixMarket,
   MatrixMarketZeroIndexed,
   Binary,
+  Tiled,
   Unknown
 };
 
@@ -521,13 +521,8 @@ void CSRMatrix<T, index_type, Allocator>::read_MatrixMarket(const std::string& f
 
   while (!outOfComments) {
     getline(f, buf);
-    regex_t regex;
-    int reti;
 
-    reti = regcomp(&regex, "^%", 0);
-    reti = regexec(&regex, buf.c_str(), 0, NULL, 0);
-
-    if (reti == REG_NOMATCH) {
+    if (buf.empty() || buf[0] != '%') {
       outOfComments = true;
     }
   }
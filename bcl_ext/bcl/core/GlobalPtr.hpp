@@ -14,8 +14,6 @@ namespace BCL {
 extern uint64_t shared_segment_size;
 extern void *smem_base_ptr;
 
-extern inline size_t rank(BCL::Team &&team);
-
 template <class T, class M> M get_member_type(M T:: *);
 #define GET_MEMBER_TYPE(mem) decltype(BCL::get_member_type(mem))
 
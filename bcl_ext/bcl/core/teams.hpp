@@ -1,8 +1,11 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
+#include <memory>
+#include <limits>
 #include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 
 namespace BCL {
 
@@ -11,7 +14,10 @@ namespace backend {
   extern uint64_t nprocs();
 };
 
-// TODO: use CRTP to ensure no vtable overhead?
+// Team is the type-erased interface, for code that picks a team at
+// runtime.  The concrete teams below are final, so a call through a
+// WorldTeam, RangeTeam or UserTeam, or through a container templated
+// on one, is resolved statically and can be inlined.
 struct Team {
   virtual size_t resolve(size_t rank) const = 0;
   virtual size_t nprocs() const noexcept = 0;
@@ -20,7 +26,7 @@ struct Team {
   virtual Team* clone() const = 0;
 };
 
-struct WorldTeam final : virtual Team {
+struct WorldTeam final : Team {
   size_t resolve(size_t rank) const override {
     return rank;
   }
@@ -45,15 +51,22 @@ struct WorldTeam final : virtual Team {
   WorldTeam(const WorldTeam&) = default;
 };
 
-struct UserTeam final : virtual Team {
+struct UserTeam final : Team {
+  constexpr static size_t not_member = std::numeric_limits<size_t>::max();
+
   std::vector<size_t> members_;
-  std::unordered_map<size_t, size_t> mapping_;
+  // Team rank of each world rank up to the largest member,
+  // or not_member.
+  std::vector<size_t> mapping_;
 
   UserTeam(const UserTeam&) = default;
 
   UserTeam(const std::vector<size_t>& members) : members_(members) {
     std::sort(members_.begin(), members_.end());
     members_.erase(std::unique(members_.begin(), members_.end()), members_.end());
+    if (!members_.empty()) {
+      mapping_.resize(members_.back() + 1, not_member);
+    }
     size_t idx = 0;
     for (auto& member : members_) {
       mapping_[member] = idx++;
@@ -65,16 +78,14 @@ struct UserTeam final : virtual Team {
   }
 
   size_t resolve(size_t rank) const override {
-    const auto memb = mapping_.find(rank);
-    if (memb == mapping_.end()) {
+    if (!in_team(rank)) {
       throw std::runtime_error("SQUAWK!!! Error resolving team member (UserTeam)");
     }
-    return memb->second;
+    return mapping_[rank];
   }
 
   bool in_team(size_t rank = BCL::backend::rank()) const noexcept override {
-    const auto memb = mapping_.find(rank);
-    return memb != mapping_.end();
+    return rank < mapping_.size() && mapping_[rank] != not_member;
   }
 
   size_t to_world(size_t rank) const override {
@@ -89,7 +100,7 @@ struct UserTeam final : virtual Team {
   }
 };
 
-struct RangeTeam final : virtual Team {
+struct RangeTeam final : Team {
   size_t bottom_, top_;
 
   RangeTeam(size_t bottom, size_t top) : bottom_(bottom), top_(top) {}
@@ -134,11 +145,52 @@ inline std::vector<BCL::RangeTeam> split_world(size_t c) {
   return teams;
 }
 
-inline bool in_team(const BCL::Team& team, size_t rank = BCL::backend::rank()) {
+// Holds a team by value, so that calls on it dispatch on its
+// static type.  team_holder<Team> holds any team through a pointer.
+template <typename TeamType>
+struct team_holder {
+  static_assert(std::is_base_of<Team, TeamType>::value,
+                "BCL::team_holder: TeamType must be a BCL team.");
+
+  TeamType team_;
+
+  team_holder(const TeamType& team = TeamType()) : team_(team) {}
+
+  const TeamType& get() const noexcept {
+    return team_;
+  }
+};
+
+template <>
+struct team_holder<Team> {
+  std::unique_ptr<Team> team_;
+
+  team_holder() : team_(new WorldTeam()) {}
+  team_holder(const Team& team) : team_(team.clone()) {}
+  team_holder(const team_holder& other) : team_(other.team_->clone()) {}
+  team_holder(team_holder&&) = default;
+
+  team_holder& operator=(const team_holder& other) {
+    team_.reset(other.team_->clone());
+    return *this;
+  }
+  team_holder& operator=(team_holder&&) = default;
+
+  const Team& get() const noexcept {
+    return *team_;
+  }
+};
+
+template <typename TeamType>
+using enable_if_team_t = std::enable_if_t<std::is_base_of<Team, TeamType>::value>;
+
+template <typename TeamType, typename = enable_if_team_t<TeamType>>
+inline bool in_team(const TeamType& team, size_t rank = BCL::backend::rank()) {
   return team.in_team(rank);
 }
 
-inline size_t rank(const BCL::Team& team) {
+template <typename TeamType, typename = enable_if_team_t<TeamType>>
+inline size_t rank(const TeamType& team) {
   return team.resolve(BCL::backend::rank());
 }
 
@@ -146,7 +198,8 @@ inline size_t rank() {
   return BCL::backend::rank();
 }
 
-inline size_t nprocs(const BCL::Team& team) {
+template <typename TeamType, typename = enable_if_team_t<TeamType>>
+inline size_t nprocs(const TeamType& team) {
   return team.nprocs();
 }
 
@@ -2,6 +2,7 @@
 
 #include <bcl/bcl.hpp>
 #include <string>
+#include <chrono>
 #include <unistd.h>
 
 namespace BCL {
@@ -24,4 +25,10 @@ std::string hostname() {
   return std::string(buf, MH);
 }
 
+// Wall-clock time in seconds, as MPI_Wtime() on any backend.
+inline double wtime() {
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
 } // end BCL
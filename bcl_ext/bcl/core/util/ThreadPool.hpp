@@ -0,0 +1,97 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+namespace BCL {
+
+// A fixed set of worker threads running queued tasks.  Tasks
+// must not make BCL calls; the backends are not thread safe.
+// submit() blocks while max_queued tasks are waiting, so a
+// producer that outruns the workers cannot pile up memory.
+class ThreadPool {
+public:
+  ThreadPool(size_t n_threads, size_t max_queued = 2)
+             : max_queued_(std::max<size_t>(1, max_queued)) {
+    for (size_t i = 0; i < n_threads; i++) {
+      threads_.emplace_back([this] { run_(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    task_ready_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  size_t size() const noexcept {
+    return threads_.size();
+  }
+
+  // With no workers, run fn on the calling thread.
+  void submit(std::function<void()>&& fn) {
+    if (threads_.empty()) {
+      fn();
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_ready_.wait(lock, [this] { return tasks_.size() < max_queued_; });
+    tasks_.push_back(std::move(fn));
+    running_++;
+    lock.unlock();
+    task_ready_.notify_one();
+  }
+
+  // Wait for every submitted task to finish.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return running_ == 0; });
+  }
+
+private:
+  void run_() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_ready_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) {
+        return;
+      }
+      std::function<void()> fn = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+      space_ready_.notify_one();
+
+      fn();
+
+      lock.lock();
+      if (--running_ == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_ready_;
+  std::condition_variable space_ready_;
+  std::condition_variable done_;
+  size_t max_queued_;
+  size_t running_ = 0;
+  bool stop_ = false;
+};
+
+}
@@ -256,10 +256,12 @@ inline T pgas::aget(const pgas::gptr<T> &src, const pgas::mode &mod)
         T                       origin,
 				dst;
         BCL::GlobalPtr<T>       gptr_bcl;
+	const MPI_Datatype	datatype = BCL::get_mpi_atomic_type<T>();
+	const int		count = BCL::get_mpi_atomic_type_impl_<T>::count;
 
         gptr_bcl = src.convert();
-	MPI_Get_accumulate(&origin, 0, MPI_BYTE, &dst, sizeof(T), MPI_BYTE,
-				gptr_bcl.rank, gptr_bcl.ptr, sizeof(T), MPI_BYTE, MPI_NO_OP, BCL::win);
+	MPI_Get_accumulate(&origin, 0, datatype, &dst, count, datatype,
+				gptr_bcl.rank, gptr_bcl.ptr, count, datatype, MPI_NO_OP, BCL::win);
 
         if (mod == pgas::SYNC)
                 MPI_Win_flush(gptr_bcl.rank, BCL::win);
@@ -271,10 +273,12 @@ template <typename T>
 inline void pgas::aput(const T &src, const pgas::gptr<T> &dst, const pgas::mode &mod)
 {
         BCL::GlobalPtr<T>       gptr_bcl;
+	const MPI_Datatype	datatype = BCL::get_mpi_atomic_type<T>();
+	const int		count = BCL::get_mpi_atomic_type_impl_<T>::count;
 
         gptr_bcl = dst.convert();
-	MPI_Accumulate(&src, sizeof(T), MPI_BYTE,
-				gptr_bcl.rank, gptr_bcl.ptr, sizeof(T), MPI_BYTE, MPI_REPLACE, BCL::win);
+	MPI_Accumulate(&src, count, datatype,
+				gptr_bcl.rank, gptr_bcl.ptr, count, datatype, MPI_REPLACE, BCL::win);
 
         if (mod == pgas::SYNC)
                 MPI_Win_flush(gptr_bcl.rank, BCL::win);
@@ -298,26 +302,14 @@ inline T pgas::fao(const pgas::gptr<T> &ptr, const T &val, const pgas::atomic_op
 template <typename T>
 inline T pgas::cas(const pgas::gptr<T> &ptr, const T &oldVal, const T &newVal, const pgas::mode &mod)
 {
-	MPI_Datatype		datatype;
+	static_assert(BCL::get_mpi_atomic_type_impl_<T>::count == 1,
+		"pgas::cas(): T must be of 1, 2, 4 or 8 bytes");
+
 	BCL::GlobalPtr<T>	gptr_bcl;
 	T 			res;
 
-	if (sizeof(T) == 8)
-		datatype = MPI_UINT64_T;
-	else if (sizeof(T) == 4)
-		datatype = MPI_UINT32_T;
-	else if (sizeof(T) == 1)
-	{
-		if (typeid(T) == typeid(bool))
-			datatype = MPI_C_BOOL;
-		else
-			std::cout << "ERROR: the datatype not found!" << std::endl;
-	}
-	else
-		std::cout << "ERROR: the datatype not found!" << std::endl;
-
 	gptr_bcl = ptr.convert();
-	MPI_Compare_and_swap(&newVal, &oldVal, &res, datatype, gptr_bcl.rank, gptr_bcl.ptr, BCL::win);
+	MPI_Compare_and_swap(&newVal, &oldVal, &res, BCL::get_mpi_atomic_type<T>(), gptr_bcl.rank, gptr_bcl.ptr, BCL::win);
 
 	if (mod == pgas::SYNC)
 		MPI_Win_flush(gptr_bcl.rank, BCL::win);
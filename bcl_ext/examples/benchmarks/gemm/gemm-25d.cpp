@@ -0,0 +1,119 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/DMatrix.hpp>
+#include <bcl/containers/algorithms/ca_gemm.hpp>
+
+// Achieved vs. peak FLOP/s of experimental::gemm_25d for a square
+// and a tall-skinny product.  Peak is the rate of one local dgemm
+// (best of a few) on a tile-sized problem, times the worker threads,
+// times nprocs.  That is only a per-thread peak if the BLAS runs
+// single threaded, so with OpenBLAS the benchmark pins it to one
+// thread; with another BLAS, set its thread count to 1 (e.g.
+// MKL_NUM_THREADS=1).  The output says which case it measured.
+//
+// usage: gemm-25d [n] [layers] [depth] [threads] [n_runs]
+
+// Defined only when linked against OpenBLAS.
+extern "C" void openblas_set_num_threads(int) __attribute__((weak));
+
+// Pin the BLAS to one thread if we know how.  Returns whether it did.
+bool pin_blas_threads() {
+  if (openblas_set_num_threads != nullptr) {
+    openblas_set_num_threads(1);
+    return true;
+  }
+  return false;
+}
+
+template <typename T>
+void fill_local(BCL::DMatrix<T>& mat, size_t seed) {
+  for (auto& ptr : mat.ptrs_) {
+    if (ptr.is_local()) {
+      for (size_t i = 0; i < mat.tile_size(); i++) {
+        ptr.local()[i] = T((i*7 + seed) % 13) / 13;
+      }
+    }
+  }
+}
+
+double local_gflops(size_t m, size_t n, size_t k) {
+  std::vector<double> a(m*k, 1.0), b(k*n, 1.0), c(m*n, 0.0);
+  double best = 0;
+  for (size_t rep = 0; rep < 4; rep++) {
+    auto begin = std::chrono::high_resolution_clock::now();
+    BCL::experimental::cblas_gemm_wrapper_(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                                           m, n, k, 1.0, a.data(), k,
+                                           b.data(), n, 1.0, c.data(), n);
+    auto end = std::chrono::high_resolution_clock::now();
+    double duration = std::chrono::duration<double>(end - begin).count();
+    best = std::max(best, 2.0*m*n*k / duration / 1e9);
+  }
+  return best;
+}
+
+void run(const char* label, size_t m, size_t n, size_t k,
+         size_t layers, size_t depth, size_t n_threads, size_t n_runs) {
+  auto pgrid = BCL::factor(BCL::nprocs());
+  size_t pm = pgrid[0];
+  size_t pn = pgrid[1];
+  // Split k into several tiles so there is a pipeline to fill.
+  size_t k_tiles = 4*pn;
+
+  size_t tm = (m + pm - 1) / pm;
+  size_t tn = (n + pn - 1) / pn;
+  size_t tk = (k + k_tiles - 1) / k_tiles;
+
+  BCL::DMatrix<double> a(m, k, BCL::BlockCustom({tm, tk}, {pm, pn}));
+  BCL::DMatrix<double> b(k, n, BCL::BlockCustom({tk, tn}, {pm, pn}));
+  BCL::DMatrix<double> c(m, n, BCL::BlockCustom({tm, tn}, {pm, pn}));
+  fill_local(a, 1);
+  fill_local(b, 2);
+  fill_local(c, 0);
+
+  double peak = local_gflops(tm, tn, tk) * std::max<size_t>(1, n_threads);
+  peak = BCL::allreduce<double>(peak, BCL::sum<double>{});
+
+  double best = 0;
+  for (size_t run = 0; run < n_runs; run++) {
+    BCL::barrier();
+    auto begin = std::chrono::high_resolution_clock::now();
+    BCL::experimental::gemm_25d(a, b, c, layers, depth, n_threads);
+    BCL::barrier();
+    auto end = std::chrono::high_resolution_clock::now();
+    double duration = std::chrono::duration<double>(end - begin).count();
+    double gflops = 2.0*m*n*k / duration / 1e9;
+    best = std::max(best, gflops);
+  }
+
+  BCL::print("%s %lu x %lu x %lu: %.2lf GFLOP/s of %.2lf peak (%.1lf%%)\n",
+             label, m, n, k, best, peak, 100*best / peak);
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n = (argc > 1) ? std::atol(argv[1]) : 2048;
+  size_t layers = (argc > 2) ? std::atol(argv[2]) : 1;
+  size_t depth = (argc > 3) ? std::atol(argv[3]) : 2;
+  size_t n_threads = (argc > 4) ? std::atol(argv[4]) : 1;
+  size_t n_runs = (argc > 5) ? std::atol(argv[5]) : 3;
+
+  bool pinned = pin_blas_threads();
+
+  BCL::print("%lu ranks, %lu layers, depth %lu, %lu threads\n",
+             BCL::nprocs(), layers, depth, n_threads);
+  BCL::print("peak: %lu ranks x %lu threads x one tile dgemm, %s\n",
+             BCL::nprocs(), std::max<size_t>(1, n_threads),
+             pinned ? "BLAS pinned to 1 thread"
+                    : "BLAS threads not pinned (set its thread count to 1 for a per-thread peak)");
+
+  run("square", n, n, n, layers, depth, n_threads, n_runs);
+  run("tall-skinny", 16*n, n/8, n/8, layers, depth, n_threads, n_runs);
+
+  BCL::finalize();
+  return 0;
+}
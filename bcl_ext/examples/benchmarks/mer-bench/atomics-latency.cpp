@@ -6,12 +6,35 @@
 
 #include <bcl/bcl.hpp>
 
+// Times `op(ptr)` on num_ops random locations, returning
+// the latency per op in microseconds.
+template <typename T, typename Op>
+double latency_us(std::vector<BCL::GlobalPtr<T>>& ptrs, size_t local_size,
+                  size_t num_ops, Op&& op) {
+  srand48(BCL::rank());
+
+  BCL::barrier();
+  auto begin = std::chrono::high_resolution_clock::now();
+
+  for (size_t i = 0; i < num_ops; i++) {
+    // Pick a random processor p'
+    size_t dest_rank = lrand48() % BCL::nprocs();
+    size_t rand_loc = lrand48() % local_size;
+
+    op(ptrs[dest_rank] + rand_loc);
+  }
+
+  BCL::barrier();
+  auto end = std::chrono::high_resolution_clock::now();
+
+  double duration = std::chrono::duration<double>(end - begin).count();
+  return 1e6*duration / num_ops;
+}
+
 int main(int argc, char** argv) {
   BCL::init();
   using T = int;
 
-  std::vector<BCL::GlobalPtr<T>> ptrs(BCL::nprocs(), nullptr);
-
   // Global data size, in bytes.
   size_t global_data_size = 256*1024*size_t(1024);
   // Number of ops ("hash table accesses") to perform, per processor
@@ -20,6 +43,8 @@ int main(int argc, char** argv) {
   size_t global_size = global_data_size / sizeof(T);
   size_t local_size = (global_size + BCL::nprocs() - 1) / BCL::nprocs();
 
+  std::vector<BCL::GlobalPtr<T>> ptrs(BCL::nprocs(), nullptr);
+
   for (size_t i = 0; i < BCL::nprocs(); i++) {
     if (BCL::rank() == i) {
       ptrs[i] = BCL::alloc<int>(local_size);
@@ -31,30 +56,51 @@ int main(int argc, char** argv) {
     }
   }
 
-  srand48(BCL::rank());
+  // Perform a global atomic `compare_and_swap()` on an integer variable
+  double cas_us = latency_us(ptrs, local_size, num_ops, [](BCL::GlobalPtr<T> ptr) {
+    BCL::compare_and_swap<int>(ptr, 0, 1);
+  });
 
-  BCL::barrier();
-  auto begin = std::chrono::high_resolution_clock::now();
-
-  for (size_t i = 0; i < num_ops; i++) {
-    // Pick a random processor p'
-    size_t dest_rank = lrand48() % BCL::nprocs();
-    size_t rand_loc = lrand48() % local_size;
+  BCL::print("Measured latency %lf us\n", cas_us);
 
-    // Perform a global atomic `compare_and_swap()` on an integer variable
-    BCL::compare_and_swap<int>(ptrs[dest_rank] + rand_loc, 0, 1);
+  // Atomic get/put of 64-bit words, as the DDS structures issue
+  // them on their pointers and counters.
+  using W = uint64_t;
+  size_t local_words = local_size * sizeof(T) / sizeof(W);
+  std::vector<BCL::GlobalPtr<W>> words;
+  for (auto& ptr : ptrs) {
+    words.push_back(BCL::reinterpret_pointer_cast<W>(ptr));
   }
 
-  BCL::barrier();
-  auto end = std::chrono::high_resolution_clock::now();
-
-  double duration = std::chrono::duration<double>(end - begin).count();
-
-  double latency = duration / num_ops;
-  double latency_us = latency*1e6;
-
-  BCL::print("Atomics latency benchmark completed in %lfs.\n", duration);
-  BCL::print("Measured latency %lf us\n", latency_us);
+  double aget_us = latency_us(words, local_words, num_ops, [](BCL::GlobalPtr<W> ptr) {
+    volatile W value = BCL::aget_sync(ptr);
+  });
+  double aput_us = latency_us(words, local_words, num_ops, [](BCL::GlobalPtr<W> ptr) {
+    BCL::aput_sync(W(1), ptr);
+  });
+
+  BCL::print("Typed aget_sync latency %lf us\n", aget_us);
+  BCL::print("Typed aput_sync latency %lf us\n", aput_us);
+
+#if !defined(SHMEM) && !defined(GASNET_EX) && !defined(UPCXX)
+  // The same ops as MPI_CHAR byte arrays, which MPI
+  // implementations execute in software.
+  double byte_aget_us = latency_us(words, local_words, num_ops, [](BCL::GlobalPtr<W> ptr) {
+    W origin, value;
+    MPI_Get_accumulate(&origin, 0, MPI_CHAR, &value, sizeof(W), MPI_CHAR,
+                       ptr.rank, ptr.ptr, sizeof(W), MPI_CHAR, MPI_NO_OP, BCL::win);
+    MPI_Win_flush(ptr.rank, BCL::win);
+  });
+  double byte_aput_us = latency_us(words, local_words, num_ops, [](BCL::GlobalPtr<W> ptr) {
+    W value = 1;
+    MPI_Accumulate(&value, sizeof(W), MPI_CHAR, ptr.rank, ptr.ptr, sizeof(W),
+                   MPI_CHAR, MPI_REPLACE, BCL::win);
+    MPI_Win_flush(ptr.rank, BCL::win);
+  });
+
+  BCL::print("Byte aget latency %lf us\n", byte_aget_us);
+  BCL::print("Byte aput latency %lf us\n", byte_aput_us);
+#endif
 
   BCL::finalize();
   return 0;
@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <deque>
+#include <array>
+#include <algorithm>
+#include <chrono>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/experimental/rpc.hpp>
+
+// Latency and throughput of rpc/async_rpc/buffered_rpc against
+// payload size, outstanding requests (depth) and, for buffered
+// RPCs, rpc_buffer_size.  Every rank sends to random ranks while
+// serving the others.
+//
+// Each RPC's time is split into push (the issuing call: packing
+// and, unless buffered, the put), request (until the body runs on
+// the target) and reply (until the future completes).  The split
+// takes the body's clock reading, so it is only meaningful when
+// ranks share a clock, i.e. on one node.
+//
+// Columns: p50 is averaged over ranks, p99 is the worst rank,
+// ops/s is per rank.
+//
+// usage: rpc-bench [n_ops]
+
+double now() {
+  auto time = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration<double>(time).count();
+}
+
+struct sample {
+  double issue, pushed, served, done;
+};
+
+void report(const char* mode, size_t payload, size_t buffer, size_t depth,
+            std::vector<sample>& samples, double duration) {
+  std::vector<double> latency;
+  double push = 0, request = 0, reply = 0;
+  for (const auto& s : samples) {
+    latency.push_back(s.done - s.issue);
+    push += s.pushed - s.issue;
+    request += s.served - s.pushed;
+    reply += s.done - s.served;
+  }
+  std::sort(latency.begin(), latency.end());
+  double n = samples.size();
+  double p50 = latency[latency.size() / 2];
+  double p99 = latency[std::min(latency.size() - 1, size_t(0.99*latency.size()))];
+  double ops = n / duration;
+
+  double nprocs = BCL::nprocs();
+  p50 = BCL::allreduce<double>(p50, BCL::sum<double>{}) / nprocs;
+  p99 = BCL::allreduce<double>(p99, BCL::max<double>{});
+  ops = BCL::allreduce<double>(ops, BCL::sum<double>{}) / nprocs;
+  push = BCL::allreduce<double>(push / n, BCL::sum<double>{}) / nprocs;
+  request = BCL::allreduce<double>(request / n, BCL::sum<double>{}) / nprocs;
+  reply = BCL::allreduce<double>(reply / n, BCL::sum<double>{}) / nprocs;
+
+  BCL::print("%-9s %7lu %7lu %6lu %10.2lf %10.2lf %11.0lf %9.2lf %9.2lf %9.2lf\n",
+             mode, payload, buffer, depth, 1e6*p50, 1e6*p99, ops,
+             1e6*push, 1e6*request, 1e6*reply);
+}
+
+template <size_t N>
+void run(size_t n_ops) {
+  using payload_t = std::array<char, N>;
+  auto serve = [](payload_t payload) -> double {
+                 return now();
+               };
+  using future_type = decltype(BCL::async_rpc(0, serve, payload_t()));
+
+  payload_t payload;
+  payload.fill(1);
+  std::vector<sample> samples(n_ops);
+
+  auto dest = []() { return lrand48() % BCL::nprocs(); };
+
+  // Async RPCs with up to depth in flight; depth 1 is rpc().
+  for (size_t depth : {1, 8, 64}) {
+    std::deque<std::pair<future_type, size_t>> window;
+    BCL::barrier();
+    double begin = now();
+    for (size_t i = 0; i < n_ops; i++) {
+      samples[i].issue = now();
+      window.emplace_back(BCL::async_rpc(dest(), serve, payload), i);
+      samples[i].pushed = now();
+      while (window.size() >= depth || (i+1 == n_ops && !window.empty())) {
+        auto& s = samples[window.front().second];
+        s.served = window.front().first.get();
+        s.done = now();
+        window.pop_front();
+      }
+    }
+    double duration = now() - begin;
+    BCL::quiesce_rpc();
+    report(depth == 1 ? "sync" : "async", N, 0, depth, samples, duration);
+  }
+
+  // Buffered RPCs, issued depth at a time and then flushed.
+  for (size_t buffer : {512, 4096, 16384}) {
+    BCL::rpc_buffer_size = buffer;
+    for (size_t depth : {64, 1024}) {
+      std::vector<future_type> futures;
+      BCL::barrier();
+      double begin = now();
+      for (size_t i = 0; i < n_ops; i += depth) {
+        size_t end = std::min(n_ops, i + depth);
+        for (size_t j = i; j < end; j++) {
+          samples[j].issue = now();
+          futures.push_back(BCL::buffered_rpc(dest(), serve, payload));
+          samples[j].pushed = now();
+        }
+        BCL::flush_rpc();
+        for (size_t j = i; j < end; j++) {
+          samples[j].served = futures[j - i].get();
+          samples[j].done = now();
+        }
+        futures.clear();
+      }
+      double duration = now() - begin;
+      BCL::quiesce_rpc();
+      report("buffered", N, buffer, depth, samples, duration);
+    }
+  }
+  BCL::rpc_buffer_size = 4096;
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+  BCL::init_rpc();
+
+  size_t n_ops = (argc > 1) ? std::atol(argv[1]) : 2000;
+  srand48(BCL::rank());
+
+  BCL::print("%lu ranks, %lu RPCs per rank per run; times in us\n",
+             BCL::nprocs(), n_ops);
+  BCL::print("%-9s %7s %7s %6s %10s %10s %11s %9s %9s %9s\n",
+             "mode", "payload", "buffer", "depth", "p50", "p99", "ops/s",
+             "push", "request", "reply");
+
+  run<8>(n_ops);
+  run<64>(n_ops);
+  run<512>(n_ops);
+  run<2048>(n_ops);
+
+  BCL::finalize_rpc();
+  BCL::finalize();
+  return 0;
+}
@@ -41,7 +41,7 @@ int main(int argc, char** argv) {
     }
   }
 
-  size_t total_count = BCL::allreduce<size_t>(count, std::plus<size_t>{});
+  size_t total_count = BCL::allreduce<size_t>(count, BCL::sum<uint64_t>{});
 
   BCL::print("Popped %lu values total.\n", total_count);
 
@@ -0,0 +1,52 @@
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/BloomFilter.hpp>
+
+// XXX: Bloom filters may give false positives, but never
+//      false negatives.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_inserts = 10000;
+  BCL::BloomFilter<int> filter(n_inserts * BCL::nprocs());
+
+  std::vector<int> vals;
+  for (size_t i = 0; i < n_inserts; i++) {
+    vals.push_back(BCL::rank()*n_inserts + i);
+  }
+
+  // Half of the values are inserted one at a time,
+  // half as a batch.
+  std::vector<int> batch(vals.begin() + n_inserts / 2, vals.end());
+  for (size_t i = 0; i < n_inserts / 2; i++) {
+    filter.insert(vals[i]);
+  }
+  filter.insert_many(batch);
+
+  BCL::barrier();
+
+  std::vector<int> all_vals;
+  for (size_t i = 0; i < n_inserts * BCL::nprocs(); i++) {
+    all_vals.push_back(i);
+  }
+
+  std::vector<bool> found = filter.find_many(all_vals);
+  for (size_t i = 0; i < all_vals.size(); i++) {
+    assert(found[i]);
+    assert(filter.find(all_vals[i]));
+  }
+
+  size_t false_positives = 0;
+  for (size_t i = 0; i < n_inserts; i++) {
+    if (filter.find(n_inserts * BCL::nprocs() + BCL::rank()*n_inserts + i)) {
+      false_positives++;
+    }
+  }
+  assert(false_positives < n_inserts / 10);
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,108 @@
+#include <cassert>
+#include <unordered_map>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/CircularQueue.hpp>
+
+#include <bcl/core/util/Backoff.hpp>
+
+// XXX: Designed to test a sequenced queue with simultaneous pushes and
+//      pops of single values and vectors from every rank, a queue small
+//      enough to wrap many times, and async_push.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_pushes = 1000;
+  size_t push_size = 7;
+
+  for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+    BCL::CircularQueue<int> queue(rank, 64, true);
+
+    // Every rank pushes n_pushes values, alternating single pushes
+    // and vectors, while popping whatever it can.
+    size_t n_values = n_pushes*push_size;
+    size_t pushed = 0;
+    std::unordered_map<int, size_t> counts;
+    size_t popped = 0;
+
+    while (pushed < n_values) {
+      bool success;
+      if (pushed % 2 == 0) {
+        success = queue.push(int(BCL::rank()));
+        pushed += success ? 1 : 0;
+      } else {
+        std::vector<int> vec(std::min(push_size, n_values - pushed), BCL::rank());
+        success = queue.push(vec);
+        pushed += success ? vec.size() : 0;
+      }
+
+      int val;
+      if (queue.pop(val)) {
+        assert(val >= 0 && val < BCL::nprocs());
+        counts[val]++;
+        popped++;
+      }
+    }
+
+    BCL::barrier();
+
+    int val;
+    while (queue.pop(val)) {
+      assert(val >= 0 && val < BCL::nprocs());
+      counts[val]++;
+      popped++;
+    }
+
+    size_t total = BCL::allreduce<uint64_t>(popped, BCL::sum<uint64_t>{});
+    assert(total == n_values*BCL::nprocs());
+
+    for (size_t src = 0; src < BCL::nprocs(); src++) {
+      size_t n = BCL::allreduce<uint64_t>(counts[src], BCL::sum<uint64_t>{});
+      if (n != n_values) {
+        throw std::runtime_error("BCL::CircularQueue05: found " +
+                                 std::to_string(n) + " != " +
+                                 std::to_string(n_values) + " values from " +
+                                 std::to_string(src));
+      }
+    }
+    assert(queue.size() == 0);
+
+    // async_push into a queue drained only by its host.
+    BCL::barrier();
+    if (BCL::rank() != rank) {
+      for (size_t i = 0; i < n_pushes; i++) {
+        auto future = queue.async_push({int(BCL::rank())});
+        BCL::Backoff backoff;
+        while (!future.is_ready()) {
+          backoff.backoff();
+        }
+      }
+    } else {
+      for (size_t i = 0; i < (BCL::nprocs() - 1)*n_pushes; i++) {
+        while (!queue.pop(val, BCL::CircularQueueAL::none)) {}
+        assert(val >= 0 && val < BCL::nprocs() && val != rank);
+      }
+    }
+    BCL::barrier();
+
+    // Partly filled queue survives a resize.
+    if (BCL::rank() == 0) {
+      for (int i = 0; i < 10; i++) {
+        assert(queue.push(i));
+      }
+    }
+    queue.resize(128);
+    if (BCL::rank() == 0) {
+      for (int i = 0; i < 10; i++) {
+        assert(queue.pop(val));
+        assert(val == i);
+      }
+      assert(!queue.pop(val));
+    }
+    BCL::barrier();
+  }
+
+  BCL::finalize();
+  return 0;
+}
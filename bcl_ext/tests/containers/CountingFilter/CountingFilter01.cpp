@@ -0,0 +1,67 @@
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/CountingFilter.hpp>
+
+// XXX: Counts may be overestimated due to fingerprint
+//      collisions, but never underestimated.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_keys = 10000;
+  BCL::CountingFilter<int> filter(n_keys);
+
+  // Every rank inserts every key, half one
+  // at a time and half as a batch.
+  std::vector<int> batch;
+  for (size_t i = 0; i < n_keys; i++) {
+    if (i % 2 == 0) {
+      bool success = filter.insert(i);
+      assert(success);
+    } else {
+      batch.push_back(i);
+    }
+  }
+  bool success = filter.insert_many(batch);
+  assert(success);
+
+  BCL::barrier();
+
+  std::vector<int> keys;
+  for (size_t i = 0; i < n_keys; i++) {
+    keys.push_back(i);
+  }
+
+  std::vector<size_t> counts = filter.count_many(keys);
+  size_t n_exact = 0;
+  for (size_t i = 0; i < n_keys; i++) {
+    assert(counts[i] >= BCL::nprocs());
+    assert(filter.count(keys[i]) == counts[i]);
+    if (counts[i] == BCL::nprocs()) {
+      n_exact++;
+    }
+  }
+  assert(n_exact > n_keys - n_keys / 100);
+
+  BCL::barrier();
+
+  // Remove every key once per rank.
+  success = filter.remove_many(batch);
+  assert(success);
+  for (size_t i = 0; i < n_keys; i += 2) {
+    success = filter.remove(i);
+    assert(success);
+  }
+
+  BCL::barrier();
+
+  counts = filter.count_many(keys);
+  for (size_t i = 0; i < n_keys; i++) {
+    assert(counts[i] == 0);
+  }
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/ElasticQueue.hpp>
+
+#include <bcl/core/util/Backoff.hpp>
+
+// XXX: Designed to test an ElasticQueue that starts small and grows
+//      while every rank pushes to it and its host pops, checking
+//      that each pusher's values come out in order.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_pushes = 2000;
+
+  for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+    BCL::ElasticQueue<int> queue(rank, 8);
+    assert(queue.n_segments() == 1);
+    // The host may grow the queue as soon as it starts pushing.
+    BCL::barrier();
+
+    // Rank r pushes r*n_pushes + i for i in [0, n_pushes).
+    std::vector<int> next(BCL::nprocs());
+    for (size_t src = 0; src < BCL::nprocs(); src++) {
+      next[src] = src*n_pushes;
+    }
+    size_t popped = 0;
+    size_t max_segments = 1;
+
+    auto pop_one = [&]() {
+      int val;
+      if (!queue.pop(val)) {
+        return false;
+      }
+      size_t src = val / n_pushes;
+      assert(src < BCL::nprocs());
+      assert(val == next[src]);
+      next[src]++;
+      popped++;
+      return true;
+    };
+
+    size_t n_to_pop = BCL::rank() == rank ? n_pushes*BCL::nprocs() : 0;
+
+    for (size_t i = 0; i < n_pushes; i++) {
+      int val = BCL::rank()*n_pushes + i;
+      BCL::Backoff backoff;
+      while (!queue.push(val)) {
+        if (BCL::rank() == rank) {
+          pop_one();
+        } else {
+          backoff.backoff();
+        }
+      }
+      if (BCL::rank() == rank && i % 4 == 0) {
+        pop_one();
+        max_segments = std::max(max_segments, queue.n_segments());
+      }
+    }
+
+    while (popped < n_to_pop) {
+      pop_one();
+    }
+
+    if (BCL::rank() == rank) {
+      assert(!pop_one());
+      assert(queue.size() == 0);
+      // Pushes outran the pops, so the queue must have grown.
+      assert(queue.capacity() > 8 || max_segments > 1);
+    }
+
+    queue.shrink_to_fit();
+
+    // Still usable after shrinking.
+    if (BCL::rank() == 0) {
+      for (int i = 0; i < 6; i++) {
+        bool success = queue.push(i);
+        assert(success);
+      }
+    }
+    BCL::barrier();
+    if (BCL::rank() == rank) {
+      int val;
+      for (int i = 0; i < 6; i++) {
+        while (!queue.pop(val)) {}
+        assert(val == i);
+      }
+    }
+    BCL::barrier();
+  }
+
+  BCL::finalize();
+  return 0;
+}
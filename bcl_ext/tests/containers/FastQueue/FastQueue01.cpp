@@ -0,0 +1,102 @@
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/FastQueue.hpp>
+
+// XXX: Designed to test pops running concurrently with
+//      pushes (no barrier in between), batches that
+//      wrap around the end of the ring, and many producers
+//      and consumers sharing a ring smaller than the data.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_batches = 100;
+  size_t batch_size = 7;
+  size_t n_pushes = n_batches * batch_size;
+
+  BCL::FastQueue<int> queue(0, n_pushes * BCL::nprocs());
+
+  std::vector<int> batch(batch_size, BCL::rank());
+  for (size_t i = 0; i < n_batches; i++) {
+    bool success = queue.push(batch.data(), batch.size());
+    assert(success);
+  }
+
+  if (BCL::rank() == 0) {
+    std::vector<size_t> counts(BCL::nprocs(), 0);
+    std::vector<int> vals(batch_size);
+    for (size_t i = 0; i < n_batches * BCL::nprocs(); ) {
+      if (queue.pop(vals.data(), vals.size())) {
+        for (int val : vals) {
+          assert(val >= 0 && val < BCL::nprocs());
+          counts[val]++;
+        }
+        i++;
+      }
+    }
+    for (size_t count : counts) {
+      assert(count == n_pushes);
+    }
+  }
+
+  BCL::barrier();
+
+  // Wrap around a small ring on each rank.
+  BCL::FastQueue<int> ring(5);
+  int next_push = 0;
+  int next_pop = 0;
+  for (size_t i = 0; i < 20; i++) {
+    std::vector<int> vals = {next_push, next_push + 1, next_push + 2};
+    bool success = ring.push(vals.data(), vals.size());
+    assert(success);
+    next_push += 3;
+
+    std::vector<int> popped(3);
+    success = ring.pop(popped.data(), popped.size());
+    assert(success);
+    for (int val : popped) {
+      assert(val == next_pop);
+      next_pop++;
+    }
+  }
+  assert(ring.empty());
+
+  BCL::barrier();
+
+  // Every rank pushes and pops through one small ring.
+  BCL::FastQueue<int> shared(0, 16);
+  size_t n_vals = 600;
+  size_t pushed = 0;
+  size_t popped = 0;
+  uint64_t popped_sum = 0;
+  while (pushed < n_vals || popped < n_vals) {
+    if (pushed < n_vals) {
+      std::vector<int> vals = {int(BCL::rank()*n_vals + pushed),
+                               int(BCL::rank()*n_vals + pushed + 1),
+                               int(BCL::rank()*n_vals + pushed + 2)};
+      if (shared.push(vals.data(), vals.size())) {
+        pushed += vals.size();
+      }
+    }
+    if (popped < n_vals) {
+      int val;
+      if (shared.pop(val)) {
+        assert(val >= 0 && val < n_vals*BCL::nprocs());
+        popped_sum += val;
+        popped++;
+      }
+    }
+  }
+
+  uint64_t n_total = n_vals*BCL::nprocs();
+  uint64_t total_sum = BCL::allreduce<uint64_t>(popped_sum, BCL::sum<uint64_t>{});
+  assert(total_sum == n_total*(n_total - 1) / 2);
+
+  BCL::barrier();
+  assert(shared.empty());
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <cassert>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/HashMap.hpp>
+#include <bcl/containers/HashMapBuffer.hpp>
+
+// XXX: Designed to test HashMapBuffer with and without node aggregation,
+//      with queues small enough that pushes fail until peers drain them,
+//      flushing with flush() or with flush_buffers() and flush_queues().
+
+template <typename Buffer, typename Map>
+void insert_and_check(Buffer& buffer, Map& map, size_t n_to_insert, int offset,
+                      bool split = false) {
+  for (size_t i = 0; i < n_to_insert; i++) {
+    buffer.insert(n_to_insert*BCL::rank() + i, i + offset);
+    if (i % 64 == 0) {
+      buffer.progress();
+    }
+  }
+  bool success;
+  if (split) {
+    success = buffer.flush_buffers();
+    assert(success);
+    success = buffer.flush_queues();
+  } else {
+    success = buffer.flush();
+  }
+  assert(success);
+
+  for (size_t i = 0; i < n_to_insert; i++) {
+    size_t rank = (BCL::rank() + 1) % BCL::nprocs();
+    int value;
+    success = map.find_atomic_impl_(n_to_insert*rank + i, value);
+    assert(success);
+    assert(value == i + offset);
+  }
+  BCL::barrier();
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_to_insert = 2000;
+
+  BCL::HashMap<int, int> map(2*n_to_insert*BCL::nprocs());
+
+  {
+    BCL::HashMapBuffer<int, int> buffer(map, 256, 16);
+    insert_and_check(buffer, map, n_to_insert, 0);
+    // Counters must be reset between flushes.
+    insert_and_check(buffer, map, n_to_insert, 3);
+    insert_and_check(buffer, map, n_to_insert, 5, true);
+    insert_and_check(buffer, map, n_to_insert, 6);
+  }
+
+  // Two ranks per node, whatever the real placement.
+  {
+    BCL::HashMapBuffer<int, int> buffer(map, 256, 16, BCL::NodeMap(2));
+    insert_and_check(buffer, map, n_to_insert, 1);
+    insert_and_check(buffer, map, n_to_insert, 4);
+    insert_and_check(buffer, map, n_to_insert, 7, true);
+  }
+
+  {
+    BCL::NodeMap nodes;
+    assert(nodes.n_nodes() >= 1 && nodes.n_nodes() <= BCL::nprocs());
+    assert(nodes.ranks(nodes.node())[nodes.local_rank()] == BCL::rank());
+
+    BCL::HashMapBuffer<int, int> buffer(map, 256, 16, nodes);
+    insert_and_check(buffer, map, n_to_insert, 2);
+  }
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <string>
+#include <cassert>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/HashMap.hpp>
+
+// XXX: Designed to test HashMaps stored on a subset of ranks, with
+//      the team type fixed at compile time and chosen at runtime.
+
+template <typename Map>
+void insert_and_find(Map& map) {
+  if (map.team().in_team()) {
+    bool success = map.insert_atomic_impl_(BCL::rank(), BCL::rank());
+    assert(success);
+  }
+
+  BCL::barrier();
+
+  for (size_t rank = 0; rank < BCL::nprocs(); rank++) {
+    int value;
+    bool found = map.find_atomic_impl_(rank, value);
+    assert(found == map.team().in_team(rank));
+    assert(!found || value == rank);
+  }
+
+  BCL::barrier();
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  std::vector<size_t> evens;
+  for (size_t rank = 0; rank < BCL::nprocs(); rank += 2) {
+    evens.push_back(rank);
+  }
+  BCL::UserTeam even_team(evens);
+  assert(BCL::nprocs(even_team) == evens.size());
+  assert(even_team.in_team() == (BCL::rank() % 2 == 0));
+  assert(!even_team.in_team(BCL::nprocs()));
+  if (even_team.in_team()) {
+    assert(BCL::rank(even_team) == BCL::rank() / 2);
+  }
+
+  BCL::RangeTeam top_team(BCL::nprocs() / 2, BCL::nprocs());
+
+  {
+    BCL::HashMap<int, int> map(1000);
+    insert_and_find(map);
+  }
+
+  {
+    BCL::HashMap<int, int, std::hash<int>, BCL::serialize<int>,
+                 BCL::serialize<int>, BCL::UserTeam> map(1000, even_team);
+    insert_and_find(map);
+  }
+
+  {
+    BCL::HashMap<int, int, std::hash<int>, BCL::serialize<int>,
+                 BCL::serialize<int>, BCL::RangeTeam> map(1000, top_team);
+    insert_and_find(map);
+  }
+
+  {
+    BCL::HashMap<int, int, std::hash<int>, BCL::serialize<int>,
+                 BCL::serialize<int>, BCL::Team> map(1000, top_team);
+    insert_and_find(map);
+  }
+
+  BCL::finalize();
+  return 0;
+}
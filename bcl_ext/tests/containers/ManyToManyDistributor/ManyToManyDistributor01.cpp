@@ -0,0 +1,51 @@
+#include <cassert>
+#include <cstdlib>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/ManyToManyDistributor.hpp>
+
+// XXX: Designed to test streaming mode, with queues far
+//      smaller than the data so senders must wait on credit,
+//      and a second stream through the same distributor.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  size_t n_vals = 5000;
+  size_t queue_size = 16 * BCL::nprocs();
+  size_t message_size = 8;
+
+  BCL::ManyToManyDistributor<int> distributor(queue_size, message_size);
+
+  size_t n_received = 0;
+  uint64_t received_sum = 0;
+  distributor.set_handler([&](const int& val) {
+    assert(val % BCL::nprocs() == BCL::rank());
+    received_sum += val;
+    n_received++;
+  });
+
+  srand48(BCL::rank());
+  for (size_t round = 0; round < 2; round++) {
+    n_received = 0;
+    received_sum = 0;
+    uint64_t sent_sum = 0;
+    for (size_t i = 0; i < n_vals; i++) {
+      int val = lrand48() % 1000000;
+      bool success = distributor.insert(val, val % BCL::nprocs());
+      assert(success);
+      sent_sum += val;
+    }
+    distributor.flush();
+
+    uint64_t total_received = BCL::allreduce<uint64_t>(n_received, BCL::sum<uint64_t>{});
+    uint64_t total_received_sum = BCL::allreduce<uint64_t>(received_sum, BCL::sum<uint64_t>{});
+    uint64_t total_sent_sum = BCL::allreduce<uint64_t>(sent_sum, BCL::sum<uint64_t>{});
+    assert(total_received == n_vals * BCL::nprocs());
+    assert(total_received_sum == total_sent_sum);
+  }
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/detail/MatrixMarket.hpp>
+
+// XXX: Designed to test the parallel MatrixMarket reader with
+//      chunks far smaller than a line, so that both chunk and
+//      rank boundaries fall mid-line, on a file with comments,
+//      blank lines, CRLF endings and no final newline.
+
+using entry_type = BCL::MatrixMarketEntry<double>;
+
+bool entry_less(const entry_type& a, const entry_type& b) {
+  return std::tie(a.i, a.j, a.value) < std::tie(b.i, b.j, b.value);
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  int pid = getpid();
+  pid = BCL::broadcast(pid, 0);
+  std::string fname = "/tmp/bcl_read_MatrixMarket_" + std::to_string(pid) + ".mtx";
+  size_t m = 37;
+  size_t n = 23;
+  size_t nnz = 300;
+  const char* values[] = {"1.5", "-2e-3", "7", "3.25E+2", "0.1",
+                          "-0.000123456789", "12345678901234567890.5"};
+
+  std::vector<entry_type> all;
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(fname.c_str(), "w");
+    assert(f != NULL);
+    fprintf(f, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(f, "%% a comment\n");
+    fprintf(f, "%lu %lu %lu\n", m, n, nnz);
+    for (size_t k = 0; k < nnz; k++) {
+      if (k == nnz / 3) {
+        fprintf(f, "%% another comment\n\n");
+      }
+      const char* end = (k + 1 == nnz) ? "" : (k % 5 == 0) ? "\r\n" : "\n";
+      fprintf(f, "%lu %lu %s%s", (k*7) % m + 1, (k*11) % n + 1,
+              values[k % 7], end);
+    }
+    fclose(f);
+  }
+  BCL::barrier();
+
+  for (size_t k = 0; k < nnz; k++) {
+    all.push_back(entry_type{(k*7) % m, (k*11) % n, strtod(values[k % 7], NULL)});
+  }
+
+  BCL::MatrixMarketInfo info = BCL::read_MatrixMarket_header(fname);
+  assert(info.m == m && info.n == n && info.nnz == nnz);
+
+  auto owner = [](size_t i, size_t j) {
+    return (i + j) % BCL::nprocs();
+  };
+
+  std::vector<entry_type> expected;
+  for (const auto& entry : all) {
+    if (owner(entry.i, entry.j) == BCL::rank()) {
+      expected.push_back(entry);
+    }
+  }
+  std::sort(expected.begin(), expected.end(), entry_less);
+
+  for (size_t chunk_size : {1, 2, 5, 13, 64, 16*1024*1024}) {
+    std::vector<entry_type> received;
+    BCL::read_MatrixMarket_distributed<double>(fname, info, true, owner,
+      [&](const entry_type& entry) {
+        assert(owner(entry.i, entry.j) == BCL::rank());
+        received.push_back(entry);
+      }, chunk_size);
+
+    std::sort(received.begin(), received.end(), entry_less);
+    assert(received.size() == expected.size());
+    for (size_t k = 0; k < expected.size(); k++) {
+      assert(received[k].i == expected[k].i);
+      assert(received[k].j == expected[k].j);
+      assert(received[k].value == expected[k].value);
+    }
+    BCL::barrier();
+  }
+
+  if (BCL::rank() == 0) {
+    remove(fname.c_str());
+  }
+
+  BCL::finalize();
+  return 0;
+}
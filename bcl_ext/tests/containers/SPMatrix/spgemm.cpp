@@ -0,0 +1,111 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/algorithms/spgemm.hpp>
+
+// XXX: Designed to test BCL::spgemm against a dense sequential
+//      product, on shapes that send the C tiles to each of the
+//      SPA (dense output), heap (two partials) and hash (many
+//      sparse partials) accumulators.
+
+struct entry {
+  size_t i, j;
+  double value;
+};
+
+// Random m x n matrix with about density*m*n entries, written
+// by rank 0 to fname and returned densely on every rank.
+std::vector<double> write_random(const std::string& fname, size_t m, size_t n,
+                                 double density, long seed) {
+  std::vector<entry> entries;
+  srand48(seed);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < n; j++) {
+      if (drand48() < density) {
+        entries.push_back({i, j, double(lrand48() % 19) - 9});
+      }
+    }
+  }
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(fname.c_str(), "w");
+    assert(f != NULL);
+    fprintf(f, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(f, "%lu %lu %lu\n", m, n, entries.size());
+    for (const auto& e : entries) {
+      fprintf(f, "%lu %lu %lf\n", e.i + 1, e.j + 1, e.value);
+    }
+    fclose(f);
+  }
+  BCL::barrier();
+
+  std::vector<double> dense(m*n, 0);
+  for (const auto& e : entries) {
+    dense[e.i*n + e.j] = e.value;
+  }
+  return dense;
+}
+
+void test_spgemm(size_t m, size_t k, size_t n, size_t tile_m, size_t tile_k,
+                 size_t tile_n, double density, const std::string& prefix) {
+  std::string a_fname = prefix + "_a.mtx";
+  std::string b_fname = prefix + "_b.mtx";
+  std::vector<double> a_dense = write_random(a_fname, m, k, density, m + k);
+  std::vector<double> b_dense = write_random(b_fname, k, n, density, k + n + 1);
+
+  BCL::SPMatrix<double> a(a_fname, BCL::BlockCustom({tile_m, tile_k}, {1, BCL::nprocs()}));
+  BCL::SPMatrix<double> b(b_fname, BCL::BlockCustom({tile_k, tile_n}, {1, BCL::nprocs()}));
+  BCL::SPMatrix<double> c(m, n, a.dry_product_block(b));
+
+  BCL::spgemm(a, b, c);
+
+  std::vector<double> c_dense(m*n, 0);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t l = 0; l < k; l++) {
+      for (size_t j = 0; j < n; j++) {
+        c_dense[i*n + j] += a_dense[i*k + l]*b_dense[l*n + j];
+      }
+    }
+  }
+
+  auto c_local = c.get();
+  assert(c_local.m_ == m && c_local.n_ == n);
+  std::vector<double> result(m*n, 0);
+  for (size_t i = 0; i < m; i++) {
+    for (auto l = c_local.row_ptr_[i]; l < c_local.row_ptr_[i+1]; l++) {
+      result[i*n + c_local.col_ind_[l]] += c_local.vals_[l];
+    }
+  }
+  for (size_t idx = 0; idx < m*n; idx++) {
+    assert(std::abs(result[idx] - c_dense[idx]) < 1e-9);
+  }
+
+  BCL::barrier();
+  if (BCL::rank() == 0) {
+    remove(a_fname.c_str());
+    remove(b_fname.c_str());
+  }
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  int pid = getpid();
+  pid = BCL::broadcast(pid, 0);
+  std::string prefix = "/tmp/bcl_spgemm_" + std::to_string(pid);
+
+  // Dense output tiles: SPA.
+  test_spgemm(20, 24, 20, 8, 8, 8, 0.5, prefix);
+  // Two partials per tile: heap.
+  test_spgemm(40, 16, 40, 20, 8, 20, 0.03, prefix);
+  // Many sparse partials: hash.
+  test_spgemm(40, 400, 40, 20, 10, 20, 0.01, prefix);
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/DArray.hpp>
+#include <bcl/containers/DMatrix.hpp>
+#include <bcl/containers/algorithms/spmv.hpp>
+
+// XXX: Designed to test BCL::spmv and BCL::spmm against a
+//      sequential product, with one column panel per tile and
+//      with panels of a few rows of x, reusing each plan for a
+//      second multiply with new x values.
+
+struct entry {
+  size_t i, j;
+  double value;
+};
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  int pid = getpid();
+  pid = BCL::broadcast(pid, 0);
+  std::string fname = "/tmp/bcl_spmv_" + std::to_string(pid) + ".mtx";
+
+  size_t m = 53;
+  size_t n = 71;
+  size_t width = 3;
+
+  std::vector<entry> entries;
+  srand48(m + n);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < n; j++) {
+      if (drand48() < 0.15) {
+        entries.push_back({i, j, double(lrand48() % 19) - 9});
+      }
+    }
+  }
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(fname.c_str(), "w");
+    assert(f != NULL);
+    fprintf(f, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(f, "%lu %lu %lu\n", m, n, entries.size());
+    for (const auto& e : entries) {
+      fprintf(f, "%lu %lu %lf\n", e.i + 1, e.j + 1, e.value);
+    }
+    fclose(f);
+  }
+  BCL::barrier();
+
+  BCL::SPMatrix<double> a(fname, BCL::BlockCustom({16, 24}, {1, BCL::nprocs()}));
+
+  for (size_t panel_bytes : {BCL::spmv_panel_bytes, 4*sizeof(double)}) {
+    BCL::DArray<double> x(n);
+    BCL::DArray<double> y(m);
+    BCL::SpMVPlan<double, int> plan(a, x, y, panel_bytes);
+
+    for (size_t round = 0; round < 2; round++) {
+      std::vector<double> x_local(n);
+      for (size_t j = 0; j < n; j++) {
+        x_local[j] = double(j % 7) + round;
+      }
+      if (BCL::rank() == 0) {
+        for (size_t j = 0; j < n; j++) {
+          x[j] = x_local[j];
+        }
+      }
+
+      BCL::spmv(a, x, y, plan);
+      BCL::barrier();
+
+      std::vector<double> y_ref(m, 0);
+      for (const auto& e : entries) {
+        y_ref[e.i] += e.value*x_local[e.j];
+      }
+      for (size_t i = 0; i < m; i++) {
+        double value = y[i];
+        assert(std::abs(value - y_ref[i]) < 1e-9);
+      }
+      BCL::barrier();
+    }
+
+    BCL::DMatrix<double> xs(n, width, BCL::BlockCustom({8, width}, {BCL::nprocs(), 1}));
+    BCL::DMatrix<double> ys(m, width, BCL::BlockCustom({8, width}, {BCL::nprocs(), 1}));
+    if (BCL::rank() == 0) {
+      for (size_t j = 0; j < n; j++) {
+        for (size_t l = 0; l < width; l++) {
+          xs(j, l) = double((j + l) % 5);
+        }
+      }
+    }
+    BCL::SpMVPlan<double, int> plan_mm(a, xs, ys, panel_bytes);
+    BCL::spmm(a, xs, ys, plan_mm);
+    BCL::barrier();
+
+    std::vector<double> ys_ref(m*width, 0);
+    for (const auto& e : entries) {
+      for (size_t l = 0; l < width; l++) {
+        ys_ref[e.i*width + l] += e.value*double((e.j + l) % 5);
+      }
+    }
+    std::vector<double> ys_local = ys.get_matrix();
+    for (size_t idx = 0; idx < m*width; idx++) {
+      assert(std::abs(ys_local[idx] - ys_ref[idx]) < 1e-9);
+    }
+    BCL::barrier();
+  }
+
+  if (BCL::rank() == 0) {
+    remove(fname.c_str());
+  }
+
+  BCL::finalize();
+  return 0;
+}
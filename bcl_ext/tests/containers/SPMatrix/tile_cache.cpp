@@ -0,0 +1,181 @@
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/DMatrix.hpp>
+
+// XXX: Designed to test that the tile cache answers repeat
+//      fetches of remote DMatrix and SPMatrix tiles, that a
+//      write through arput_tile invalidates only the writing
+//      rank's copy, that a collective invalidate_cache() drops
+//      everyone's, and that a fetch in flight across a write is
+//      not cached.
+
+size_t n_remote_tiles(const BCL::DMatrix<float>& a) {
+  size_t count = 0;
+  for (size_t i = 0; i < a.grid_shape()[0]; i++) {
+    for (size_t j = 0; j < a.grid_shape()[1]; j++) {
+      if (!a.tile_ptr(i, j).is_local()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+// Check tile (i, j) of a holds value(row, column) everywhere.
+template <typename Fn>
+void check_tile(const BCL::DMatrix<float>& a, size_t i, size_t j, Fn&& value) {
+  auto tile = std::get<0>(a.arget_tile(i, j)).get();
+  assert(tile.size() == a.tile_size());
+  for (size_t ii = 0; ii < a.tile_shape()[0]; ii++) {
+    for (size_t jj = 0; jj < a.tile_shape()[1]; jj++) {
+      size_t row = i*a.tile_shape()[0] + ii;
+      size_t column = j*a.tile_shape()[1] + jj;
+      assert(tile[ii*a.tile_shape()[1] + jj] == value(row, column));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  auto& cache = BCL::tile_cache();
+
+  size_t m = 32;
+  size_t n = 48;
+  BCL::DMatrix<float> a(m, n, BCL::BlockCustom({8, 8}, {1, BCL::nprocs()}));
+  auto old_value = [](size_t i, size_t j) { return float(i*100 + j); };
+  auto new_value = [](size_t i, size_t j) { return -float(i*100 + j); };
+  if (BCL::rank() == 0) {
+    for (size_t i = 0; i < m; i++) {
+      for (size_t j = 0; j < n; j++) {
+        a(i, j) = old_value(i, j);
+      }
+    }
+  }
+  BCL::barrier();
+
+  // Off by default: nothing is counted.
+  assert(!cache.enabled());
+  check_tile(a, 0, 0, old_value);
+  assert(cache.stats().hits == 0 && cache.stats().misses == 0);
+
+  cache.set_capacity(1024*1024);
+  size_t n_remote = n_remote_tiles(a);
+
+  // First pass misses on every remote tile, second pass hits.
+  for (size_t pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < a.grid_shape()[0]; i++) {
+      for (size_t j = 0; j < a.grid_shape()[1]; j++) {
+        check_tile(a, i, j, old_value);
+      }
+    }
+  }
+  assert(cache.stats().misses == n_remote);
+  assert(cache.stats().hits == n_remote);
+  assert(cache.size() == n_remote*a.tile_size()*sizeof(float));
+  BCL::barrier();
+
+  // Rank 0 overwrites tile (0, 1).  Only rank 0's cache hears
+  // of it; other ranks keep serving the old tile from cache.
+  size_t ti = 0;
+  size_t tj = 1;
+  if (BCL::rank() == 0) {
+    std::vector<float> tile(a.tile_size());
+    for (size_t ii = 0; ii < a.tile_shape()[0]; ii++) {
+      for (size_t jj = 0; jj < a.tile_shape()[1]; jj++) {
+        tile[ii*a.tile_shape()[1] + jj] = new_value(ti*a.tile_shape()[0] + ii,
+                                                    tj*a.tile_shape()[1] + jj);
+      }
+    }
+    a.arput_tile(ti, tj, std::move(tile)).get();
+  }
+  BCL::barrier();
+
+  bool remote = !a.tile_ptr(ti, tj).is_local();
+  cache.reset_stats();
+  if (BCL::rank() == 0) {
+    check_tile(a, ti, tj, new_value);
+    assert(cache.stats().misses == (remote ? 1 : 0));
+  } else {
+    check_tile(a, ti, tj, remote ? old_value : new_value);
+    assert(cache.stats().hits == (remote ? 1 : 0));
+  }
+  BCL::barrier();
+
+  // A collective invalidate_cache() drops every rank's copy.
+  a.invalidate_cache();
+  cache.reset_stats();
+  check_tile(a, ti, tj, new_value);
+  assert(cache.stats().hits == 0);
+  assert(cache.stats().misses == (remote ? 1 : 0));
+  BCL::barrier();
+
+  // A fetch issued before a write is not inserted.
+  a.invalidate_cache();
+  cache.reset_stats();
+  {
+    auto tile = a.arget_tile(ti, tj);
+    a.invalidate_cache();
+    std::get<0>(tile).get();
+  }
+  check_tile(a, ti, tj, new_value);
+  assert(cache.stats().hits == 0);
+  assert(cache.stats().misses == (remote ? 2 : 0));
+  BCL::barrier();
+
+  // SPMatrix tiles are cached as vals, row_ptr and col_ind.
+  int pid = getpid();
+  pid = BCL::broadcast(pid, 0);
+  std::string fname = "/tmp/bcl_tile_cache_" + std::to_string(pid) + ".mtx";
+  size_t nnz = 200;
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(fname.c_str(), "w");
+    assert(f != NULL);
+    fprintf(f, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(f, "%lu %lu %lu\n", m, n, nnz);
+    for (size_t k = 0; k < nnz; k++) {
+      fprintf(f, "%lu %lu %lf\n", (k*7) % m + 1, (k*13 + k/m) % n + 1, 0.5*k);
+    }
+    fclose(f);
+  }
+  BCL::barrier();
+
+  BCL::SPMatrix<double> b(fname, BCL::BlockCustom({8, 8}, {1, BCL::nprocs()}));
+  cache.reset_stats();
+  size_t n_sp_remote = 0;
+  for (size_t i = 0; i < b.grid_shape()[0]; i++) {
+    for (size_t j = 0; j < b.grid_shape()[1]; j++) {
+      auto fetched = b.arget_tile(i, j).get();
+      auto cached = b.arget_tile(i, j).get();
+      assert(cached.nnz_ == b.tile_nnz(i, j));
+      assert(cached.vals_ == fetched.vals_);
+      assert(cached.row_ptr_ == fetched.row_ptr_);
+      assert(cached.col_ind_ == fetched.col_ind_);
+      if (!b.vals_[j + i*b.grid_shape()[1]].is_local()) {
+        n_sp_remote++;
+      }
+    }
+  }
+  assert(cache.stats().misses == n_sp_remote);
+  assert(cache.stats().hits == n_sp_remote);
+
+  // Shrinking the cache evicts.
+  size_t cached_bytes = cache.size();
+  size_t evictions = cache.stats().evictions;
+  cache.set_capacity(1);
+  assert(cache.size() == 0);
+  assert((cache.stats().evictions > evictions) == (cached_bytes > 0));
+
+  BCL::barrier();
+  if (BCL::rank() == 0) {
+    remove(fname.c_str());
+  }
+
+  BCL::finalize();
+  return 0;
+}
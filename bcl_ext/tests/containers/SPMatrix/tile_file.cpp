@@ -0,0 +1,92 @@
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/SPMatrix.hpp>
+#include <bcl/containers/DMatrix.hpp>
+
+// XXX: Designed to test that SPMatrix and DMatrix checkpoints
+//      written with save() read back identical, with more tiles
+//      than ranks, and that a file that is not a checkpoint is
+//      rejected on every rank.
+
+int main(int argc, char** argv) {
+  BCL::init();
+
+  int pid = getpid();
+  pid = BCL::broadcast(pid, 0);
+  std::string prefix = "/tmp/bcl_tile_file_" + std::to_string(pid);
+  std::string mtx_fname = prefix + ".mtx";
+  std::string sp_fname = prefix + ".sp";
+  std::string dense_fname = prefix + ".dense";
+
+  size_t m = 29;
+  size_t n = 41;
+  size_t nnz = 200;
+  if (BCL::rank() == 0) {
+    FILE* f = fopen(mtx_fname.c_str(), "w");
+    assert(f != NULL);
+    fprintf(f, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(f, "%lu %lu %lu\n", m, n, nnz);
+    for (size_t k = 0; k < nnz; k++) {
+      fprintf(f, "%lu %lu %lf\n", (k*7) % m + 1, (k*13 + k/m) % n + 1, 0.5*k);
+    }
+    fclose(f);
+  }
+  BCL::barrier();
+
+  BCL::SPMatrix<double> a(mtx_fname, BCL::BlockCustom({8, 8}, {1, BCL::nprocs()}));
+  a.save(sp_fname);
+  BCL::SPMatrix<double> b(sp_fname, BCL::BlockOpt(), BCL::FileFormat::Tiled);
+
+  assert(b.shape() == a.shape());
+  assert(b.tile_shape() == a.tile_shape());
+  assert(b.nnz() == a.nnz());
+  for (size_t i = 0; i < a.grid_shape()[0]; i++) {
+    for (size_t j = 0; j < a.grid_shape()[1]; j++) {
+      assert(b.tile_nnz(i, j) == a.tile_nnz(i, j));
+    }
+  }
+  auto a_local = a.get();
+  auto b_local = b.get();
+  assert(b_local.vals_ == a_local.vals_);
+  assert(b_local.col_ind_ == a_local.col_ind_);
+  assert(b_local.row_ptr_ == a_local.row_ptr_);
+
+  BCL::DMatrix<float> c(m, n, BCL::BlockCustom({8, 8}, {1, BCL::nprocs()}));
+  if (BCL::rank() == 0) {
+    for (size_t i = 0; i < m; i++) {
+      for (size_t j = 0; j < n; j++) {
+        c(i, j) = i*100 + j;
+      }
+    }
+  }
+  BCL::barrier();
+  c.save(dense_fname);
+  BCL::DMatrix<float> d(dense_fname);
+
+  assert(d.shape() == c.shape());
+  assert(d.tile_shape() == c.tile_shape());
+  assert(d.get_matrix() == c.get_matrix());
+
+  bool rejected = false;
+  try {
+    BCL::DMatrix<float> e(mtx_fname);
+  } catch (std::runtime_error& e) {
+    rejected = true;
+  }
+  assert(rejected);
+
+  BCL::barrier();
+  if (BCL::rank() == 0) {
+    remove(mtx_fname.c_str());
+    remove(sp_fname.c_str());
+    remove(dense_fname.c_str());
+  }
+
+  BCL::finalize();
+  return 0;
+}
@@ -21,7 +21,7 @@ void future_barrier(std::vector<Future>& futures) {
   do {
     BCL::flush_rpc();
     size_t success_count = ready(futures);
-    success_count = BCL::allreduce<size_t>(success_count, std::plus<size_t>{});
+    success_count = BCL::allreduce<uint64_t>(success_count, BCL::sum<uint64_t>{});
     success = success_count == BCL::nprocs();
   } while (!success);
 }
@@ -0,0 +1,71 @@
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/experimental/rpc.hpp>
+
+// XXX: Designed to test synchronous, async and buffered RPCs with
+//      argument and return payloads wider than 8 bytes, serviced
+//      without a progress thread, plus dropped futures.
+
+struct point {
+  double x, y, z;
+};
+
+int calls = 0;
+
+int main(int argc, char** argv) {
+  BCL::init();
+  BCL::init_rpc();
+
+  auto scale = [](point p, double a) -> point {
+                 return point{a*p.x, a*p.y, a*p.z};
+               };
+  auto sum = [](std::array<int, 32> vals) -> long {
+               long total = 0;
+               for (auto val : vals) {
+                 total += val;
+               }
+               return total;
+             };
+  auto count = [](int n) -> void {
+                 calls += n;
+               };
+
+  size_t next = (BCL::rank() + 1) % BCL::nprocs();
+
+  point p = BCL::rpc(next, scale, point{1, 2, 3}, 2.0);
+  assert(p.x == 2 && p.y == 4 && p.z == 6);
+
+  std::array<int, 32> vals;
+  for (size_t i = 0; i < vals.size(); i++) {
+    vals[i] = i + BCL::rank();
+  }
+  auto future = BCL::async_rpc(next, sum, vals);
+  assert(future.get() == 496 + 32*long(BCL::rank()));
+
+  // Enough buffered RPCs to wrap every ring several times.
+  size_t n_rpcs = 2000;
+  using future_type = decltype(BCL::buffered_rpc(0, sum, vals));
+  std::vector<future_type> futures;
+  for (size_t i = 0; i < n_rpcs; i++) {
+    size_t rank = (BCL::rank() + i) % BCL::nprocs();
+    vals[0] = i;
+    futures.push_back(BCL::buffered_rpc(rank, sum, vals));
+    BCL::buffered_rpc(rank, count, 1);
+  }
+  BCL::flush_rpc();
+
+  for (size_t i = 0; i < n_rpcs; i++) {
+    long expected = 496 + 31*long(BCL::rank()) + i;
+    assert(futures[i].get() == expected);
+  }
+
+  BCL::finalize_rpc();
+
+  assert(calls == n_rpcs);
+
+  BCL::finalize();
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include <cassert>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/experimental/rpc.hpp>
+
+// XXX: Designed to test RPC bodies that issue RPCs and wait on
+//      them, with every rank's chain of nested calls running at
+//      once and crossing the others, serviced without a progress
+//      thread.
+
+// Walk hops ranks around the ring, one nested RPC per hop, and
+// return the sum of the ranks visited.
+long walk(int hops) {
+  long rank = BCL::rank();
+  if (hops == 0) {
+    return rank;
+  }
+  size_t next = (BCL::rank() + 1) % BCL::nprocs();
+  return rank + BCL::rpc(next, walk, hops - 1);
+}
+
+int main(int argc, char** argv) {
+  BCL::init();
+  BCL::init_rpc();
+
+  int nprocs = BCL::nprocs();
+  for (int hops : {1, nprocs, 3*nprocs + 1}) {
+    size_t next = (BCL::rank() + 1) % BCL::nprocs();
+    long expected = 0;
+    for (int hop = 0; hop <= hops; hop++) {
+      expected += (next + hop) % nprocs;
+    }
+    assert(BCL::rpc(next, walk, hops) == expected);
+  }
+
+  BCL::finalize_rpc();
+
+  BCL::finalize();
+  return 0;
+}
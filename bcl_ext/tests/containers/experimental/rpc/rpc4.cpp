@@ -0,0 +1,58 @@
+#include <cassert>
+#include <vector>
+
+#include <bcl/bcl.hpp>
+#include <bcl/containers/experimental/rpc.hpp>
+
+// XXX: Designed to test RPC bodies that issue RPCs and wait on
+//      them while served by the progress thread, so that nested
+//      calls are issued from the progress thread at the same time
+//      as the main thread issues its own.
+
+// Walk hops ranks around the ring, one nested RPC per hop, and
+// return the sum of the ranks visited.
+long walk(int hops) {
+  long rank = BCL::rank();
+  if (hops == 0) {
+    return rank;
+  }
+  size_t next = (BCL::rank() + 1) % BCL::nprocs();
+  return rank + BCL::rpc(next, walk, hops - 1);
+}
+
+long expected_walk(size_t start, int hops) {
+  long expected = 0;
+  for (int hop = 0; hop <= hops; hop++) {
+    expected += (start + hop) % BCL::nprocs();
+  }
+  return expected;
+}
+
+int main(int argc, char** argv) {
+  BCL::init(1, true);
+  BCL::init_rpc(true);
+
+  int nprocs = BCL::nprocs();
+  size_t next = (BCL::rank() + 1) % BCL::nprocs();
+
+  for (int hops : {1, nprocs, 3*nprocs + 1}) {
+    assert(BCL::rpc(next, walk, hops) == expected_walk(next, hops));
+  }
+
+  // Many walks in flight at once, from every rank.
+  size_t n_walks = 256;
+  std::vector<BCL::rpc_future<long>> futures;
+  for (size_t i = 0; i < n_walks; i++) {
+    size_t dest = (BCL::rank() + i) % BCL::nprocs();
+    futures.push_back(BCL::async_rpc(dest, walk, int(i % (2*nprocs + 1))));
+  }
+  for (size_t i = 0; i < n_walks; i++) {
+    size_t dest = (BCL::rank() + i) % BCL::nprocs();
+    assert(futures[i].get() == expected_walk(dest, int(i % (2*nprocs + 1))));
+  }
+
+  BCL::finalize_rpc();
+
+  BCL::finalize();
+  return 0;
+}
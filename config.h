@@ -33,16 +33,18 @@ namespace dds
 	uint64_t	bk_init_master	=	exp2l(1);	//us
 	uint64_t	bk_max_master	=	exp2l(20);	//us
 	
-	//tracing
+	//tracing (per group of structures; TRACING turns all of them on)
 	#ifdef  TRACING
-        	uint64_t	succ_cs		= 0;
-		uint64_t	succ_ea 	= 0;
-		uint64_t	fail_cs 	= 0;
-		uint64_t	fail_ea 	= 0;
-		double		fail_time	= 0;
-		uint64_t	elem_re		= 0;
+		const bool	TRACE		=	true;
+	#else
+		const bool	TRACE		=	false;
 	#endif
+	const bool	TRACE_TS	=	TRACE;		//Treiber's stacks
+	const bool	TRACE_EBS	=	TRACE;		//Elimination-backoff stacks
+	const bool	TRACE_MEM	=	TRACE;		//Memory managers
 
 } /* namespace dds */
 
+#include "lib/trace.h"		//Tracing (needs MASTER_UNIT)
+
 #endif /* CONFIG_H */
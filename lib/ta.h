@@ -1,6 +1,8 @@
 #ifndef TA_H
 #define TA_H
 
+#include <bcl/containers/detail/NodeMap.hpp>
+
 namespace ta
 {
 
@@ -13,11 +15,13 @@ namespace ta
 		int		node_id;
 		int		node_id_master;
 		int		node_num;
-		MPI_Comm	nodeComm;
 
 		na();
 		~na();
 		void print();
+
+	private:
+		BCL::NodeMap	nodes;
 	};
 
 	class sa
@@ -29,39 +33,14 @@ namespace ta
 
 ta::na::na()
 {
-	MPI_Comm	leaderComm;
-	MPI_Group	group,
-			nodeGroup;
-	int		*temp,
-			color;
-
-	MPI_Comm_split_type(BCL::comm, MPI_COMM_TYPE_SHARED, BCL::rank(), BCL::info, &nodeComm);
-	MPI_Comm_size(nodeComm, &size);
+	node_id = nodes.node(BCL::rank());
+	node_num = nodes.n_nodes();
+	node_id_master = nodes.node(0);
+	rank = nodes.local_rank(BCL::rank());
+	size = nodes.n_local(node_id);
 	table = new int [size];
-	temp = new int [size];
 	for (int i = 0; i < size; ++i)
-                temp[i] = i;
-	MPI_Comm_group(BCL::comm, &group);
-	MPI_Comm_group(nodeComm, &nodeGroup);
-        MPI_Group_translate_ranks(nodeGroup, size, temp, group, table);
-	delete[] temp;
-
-        MPI_Comm_rank(nodeComm, &rank);
-	if (rank == 0)
-		color = 0;
-	else //if (rank == 0)
-		color = MPI_UNDEFINED;
-	MPI_Comm_split(BCL::comm, color, BCL::rank(), &leaderComm);
-	if (color == 0)
-	{
-		MPI_Comm_rank(leaderComm, &node_id);
-		MPI_Comm_size(leaderComm, &node_num);
-	}
-	MPI_Bcast(&node_id, 1, MPI_INT, 0, nodeComm);
-	MPI_Bcast(&node_num, 1, MPI_INT, 0, nodeComm);
-	if (BCL::rank() == 0)
-		node_id_master = node_id;
-	MPI_Bcast(&node_id_master, 1, MPI_INT, 0, BCL::comm);
+		table[i] = nodes.ranks(node_id)[i];
 }
 
 ta::na::~na()
@@ -0,0 +1,345 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <algorithm>
+#include "../config.h"		//Configurations (MASTER_UNIT)
+
+namespace trace
+{
+
+	/* Constants */
+	enum counter {SUCC_CS, FAIL_CS, SUCC_EA, FAIL_EA, ELEM_RE,
+			RMA_GET, RMA_PUT, RMA_CAS, RMA_FAO,	//remote ops issued, by kind
+			NUM_COUNTERS};
+	enum op {PUSH, POP, NUM_OPS};
+	enum format {JSON, CSV};
+
+	const char * const	COUNTER_NAMES[NUM_COUNTERS] = {"succ_cs", "fail_cs", "succ_ea", "fail_ea", "elem_re",
+							"rma_get", "rma_put", "rma_cas", "rma_fao"};
+	const char * const	OP_NAMES[NUM_OPS] = {"push", "pop"};
+
+	/* Data types */
+
+	//HDR-style histogram of latencies (ns): values below 2^SUB_BITS are
+	//exact, larger ones fall in 2^SUB_BITS linear buckets per power of 2,
+	//i.e. within ~3% of their value
+	class histogram
+	{
+	public:
+		static const uint32_t	SUB_BITS = 5;
+		static const uint32_t	SUB_COUNT = 1 << SUB_BITS;
+		static const uint32_t	NUM_BUCKETS = (65 - SUB_BITS) * SUB_COUNT;
+
+		uint64_t	buckets[NUM_BUCKETS] = {};
+		uint64_t	sum = 0;	//of all values
+		uint64_t	max = 0;
+
+		void record(const uint64_t &val);
+		uint64_t count() const;
+		uint64_t percentile(const double &p) const;	//p in [0, 100]
+
+		static uint32_t index(const uint64_t &val);
+		static uint64_t highest(const uint32_t &idx);	//highest value of a bucket
+	};
+
+	struct record
+	{
+		std::string	name;
+		uint64_t	counters[NUM_COUNTERS] = {};
+		uint64_t	fail_time = 0;		//of failed attempts and backoff (ns)
+		histogram	latency[NUM_OPS];
+	};
+
+	//records of all structures, one per name, in the order their names were
+	//first constructed; structures of the same name share a record. Records
+	//are never removed, so every unit must construct the same names in the
+	//same order for dump() to match them up
+	inline std::deque<record> &records();
+
+	//times an op from construction to destruction
+	template <bool ENABLED>
+	class timer;
+
+	//counters and latencies of a structure; all calls compile to nothing
+	//when ENABLED is false
+	template <bool ENABLED>
+	class recorder;
+
+	template <>
+	class timer<true>
+	{
+	public:
+		timer(record *rec, const op &o);
+		~timer();
+
+	private:
+		record		*rec;
+		op		o;
+		double		start;
+	};
+
+	template <>
+	class recorder<true>
+	{
+	public:
+		recorder(const std::string &name);	//collective, joins the record of name
+		void count(const counter &c);
+		double start() const;			//starts timing an attempt
+		void fail(const double &start);		//adds a failed attempt to fail_time
+		timer<true> time(const op &o);
+		uint64_t get(const counter &c) const;
+		uint64_t get_fail_time() const;		//ns
+
+	private:
+		record		*rec;
+	};
+
+	template <>
+	class timer<false>
+	{
+	public:
+		~timer() {}
+	};
+
+	template <>
+	class recorder<false>
+	{
+	public:
+		recorder(const std::string &name) {}
+		void count(const counter &c) {}
+		double start() const { return 0; }
+		void fail(const double &start) {}
+		timer<false> time(const op &o) { return {}; }
+		uint64_t get(const counter &c) const { return 0; }
+		uint64_t get_fail_time() const { return 0; }
+	};
+
+	/* Functions */
+
+	//sums the records of all units and writes them from MASTER_UNIT to path
+	//(stdout if empty); collective
+	inline void dump(const std::string &path = "", const format &fmt = JSON);
+
+} /* namespace trace */
+
+inline void trace::histogram::record(const uint64_t &val)
+{
+	++buckets[index(val)];
+	sum += val;
+	if (val > max)
+		max = val;
+}
+
+inline uint64_t trace::histogram::count() const
+{
+	uint64_t	res = 0;
+
+	for (uint32_t i = 0; i < NUM_BUCKETS; ++i)
+		res += buckets[i];
+
+	return res;
+}
+
+inline uint64_t trace::histogram::percentile(const double &p) const
+{
+	uint64_t	total = count(),
+			seen = 0;
+
+	if (total == 0)
+		return 0;
+
+	uint64_t	rank = (p / 100) * total;
+	if (rank == 0)
+		rank = 1;
+	for (uint32_t i = 0; i < NUM_BUCKETS; ++i)
+	{
+		seen += buckets[i];
+		if (seen >= rank)
+			return std::min(highest(i), max);
+	}
+
+	return max;
+}
+
+inline uint32_t trace::histogram::index(const uint64_t &val)
+{
+	if (val < SUB_COUNT)
+		return val;
+
+	uint32_t	exp = 63 - __builtin_clzll(val);
+
+	return (exp - SUB_BITS + 1) * SUB_COUNT + (val >> (exp - SUB_BITS)) - SUB_COUNT;
+}
+
+inline uint64_t trace::histogram::highest(const uint32_t &idx)
+{
+	if (idx < SUB_COUNT)
+		return idx;
+
+	uint32_t	group = idx / SUB_COUNT,
+			sub = idx % SUB_COUNT;
+	uint64_t	lowest = ((uint64_t) SUB_COUNT + sub) << (group - 1);
+
+	return lowest + ((uint64_t) 1 << (group - 1)) - 1;
+}
+
+inline std::deque<trace::record> &trace::records()
+{
+	static std::deque<record>	res;
+
+	return res;
+}
+
+inline trace::timer<true>::timer(record *rec, const op &o)
+{
+	this->rec = rec;
+	this->o = o;
+	start = BCL::wtime();
+}
+
+inline trace::timer<true>::~timer()
+{
+	rec->latency[o].record((BCL::wtime() - start) * 1e9);
+}
+
+inline trace::recorder<true>::recorder(const std::string &name)
+{
+	for (record &r: records())
+		if (r.name == name)
+		{
+			rec = &r;
+			return;
+		}
+
+	//a deque keeps the other records in place
+	records().emplace_back();
+	rec = &records().back();
+	rec->name = name;
+}
+
+inline void trace::recorder<true>::count(const counter &c)
+{
+	++rec->counters[c];
+}
+
+inline double trace::recorder<true>::start() const
+{
+	return BCL::wtime();
+}
+
+inline void trace::recorder<true>::fail(const double &start)
+{
+	rec->fail_time += (BCL::wtime() - start) * 1e9;
+}
+
+inline trace::timer<true> trace::recorder<true>::time(const op &o)
+{
+	return timer<true>(rec, o);
+}
+
+inline uint64_t trace::recorder<true>::get(const counter &c) const
+{
+	return rec->counters[c];
+}
+
+inline uint64_t trace::recorder<true>::get_fail_time() const
+{
+	return rec->fail_time;
+}
+
+inline void trace::dump(const std::string &path, const format &fmt)
+{
+	FILE		*out = nullptr;
+	bool		first = true;
+
+	if (BCL::rank() == dds::MASTER_UNIT)
+	{
+		out = path.empty() ? stdout : fopen(path.c_str(), "w");
+		if (out == nullptr)
+			printf("ERROR: Cannot open %s!\n", path.c_str());
+		else if (fmt == JSON)
+			fprintf(out, "{\n\t\"units\": %lu,\n\t\"structures\": [", BCL::nprocs());
+		else //if (fmt == CSV)
+			fprintf(out, "structure,metric,value\n");
+	}
+
+	for (record &rec: records())
+	{
+		record		total;
+		double		fail_time = rec.fail_time,
+				max_fail_time;
+
+		BCL::reduce(rec.counters, total.counters, dds::MASTER_UNIT, BCL::plus<uint64_t>{}, NUM_COUNTERS);
+		BCL::reduce(&rec.fail_time, &total.fail_time, dds::MASTER_UNIT, BCL::plus<uint64_t>{}, 1);
+		BCL::reduce(&fail_time, &max_fail_time, dds::MASTER_UNIT, BCL::max<double>{}, 1);
+		for (uint32_t o = 0; o < NUM_OPS; ++o)
+		{
+			double	max = rec.latency[o].max,
+				total_max;
+
+			BCL::reduce(rec.latency[o].buckets, total.latency[o].buckets, dds::MASTER_UNIT,
+					BCL::plus<uint64_t>{}, histogram::NUM_BUCKETS);
+			BCL::reduce(&rec.latency[o].sum, &total.latency[o].sum, dds::MASTER_UNIT, BCL::plus<uint64_t>{}, 1);
+			BCL::reduce(&max, &total_max, dds::MASTER_UNIT, BCL::max<double>{}, 1);
+			total.latency[o].max = total_max;
+		}
+
+		if (out == nullptr)
+			continue;
+
+		if (fmt == JSON)
+		{
+			fprintf(out, "%s\n\t\t{\n\t\t\t\"name\": \"%s\",\n\t\t\t\"counters\": {", first ? "" : ",", rec.name.c_str());
+			for (uint32_t c = 0; c < NUM_COUNTERS; ++c)
+				fprintf(out, "%s\"%s\": %lu", c == 0 ? "" : ", ", COUNTER_NAMES[c], total.counters[c]);
+			fprintf(out, "},\n\t\t\t\"fail_time_ns\": {\"sum\": %lu, \"max\": %lu},\n\t\t\t\"latency_ns\": {",
+					total.fail_time, (uint64_t) max_fail_time);
+			for (uint32_t o = 0; o < NUM_OPS; ++o)
+			{
+				const histogram	&h = total.latency[o];
+				uint64_t	count = h.count();
+
+				fprintf(out, "%s\n\t\t\t\t\"%s\": {\"count\": %lu, \"mean\": %lu, \"p50\": %lu, \"p90\": %lu, "
+						"\"p99\": %lu, \"p999\": %lu, \"max\": %lu}", o == 0 ? "" : ",", OP_NAMES[o], count,
+						count == 0 ? 0 : h.sum / count, h.percentile(50), h.percentile(90),
+						h.percentile(99), h.percentile(99.9), h.max);
+			}
+			fprintf(out, "\n\t\t\t}\n\t\t}");
+		}
+		else //if (fmt == CSV)
+		{
+			for (uint32_t c = 0; c < NUM_COUNTERS; ++c)
+				fprintf(out, "%s,%s,%lu\n", rec.name.c_str(), COUNTER_NAMES[c], total.counters[c]);
+			fprintf(out, "%s,fail_time_sum_ns,%lu\n", rec.name.c_str(), total.fail_time);
+			fprintf(out, "%s,fail_time_max_ns,%lu\n", rec.name.c_str(), (uint64_t) max_fail_time);
+			for (uint32_t o = 0; o < NUM_OPS; ++o)
+			{
+				const histogram	&h = total.latency[o];
+				uint64_t	count = h.count();
+
+				fprintf(out, "%s,%s_count,%lu\n", rec.name.c_str(), OP_NAMES[o], count);
+				fprintf(out, "%s,%s_mean_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], count == 0 ? 0 : h.sum / count);
+				fprintf(out, "%s,%s_p50_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], h.percentile(50));
+				fprintf(out, "%s,%s_p90_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], h.percentile(90));
+				fprintf(out, "%s,%s_p99_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], h.percentile(99));
+				fprintf(out, "%s,%s_p999_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], h.percentile(99.9));
+				fprintf(out, "%s,%s_max_ns,%lu\n", rec.name.c_str(), OP_NAMES[o], h.max);
+			}
+		}
+		first = false;
+	}
+
+	if (out != nullptr)
+	{
+		if (fmt == JSON)
+			fprintf(out, "\n\t]\n}\n");
+		if (out != stdout)
+			fclose(out);
+	}
+}
+
+#endif /* TRACE_H */
@@ -12,4 +12,6 @@
 
 #include "memory_dang3.h"	//Using no Reclamation
 
+#include "memory_tag.h"		//Using Tagged Pointers
+
 #endif /* MEMORY_H */
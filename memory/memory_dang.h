@@ -36,6 +36,7 @@ namespace dang
                 uint64_t			capacity;       //contains global memory capacity (bytes)
 		sds::list<gptr<T>>		listAlloc;	//contains allocated elems
 		sds::list<gptr<T>>		listRecla;	//contains reclaimed elems
+		trace::recorder<TRACE_MEM>		tr{"DANG"};		//counts reclaimed elems and remote ops
 
 		void scan();
 	};
@@ -75,9 +76,7 @@ dds::gptr<T> dds::dang::memory<T>::malloc()
 	if (listRecla.remove(addr) != EMPTY)
 	{
 		//tracing
-		#ifdef  TRACING
-			++elem_re;
-		#endif
+		tr.count(trace::ELEM_RE);
 
 		temp = {addr->value.rank, addr->value.ptr - sizeof(temp.rank)};
 		BCL::store(true, temp);
@@ -104,9 +103,7 @@ dds::gptr<T> dds::dang::memory<T>::malloc()
                         if (listRecla.remove(addr) != EMPTY)
                         {
 				//tracing
-				#ifdef  TRACING
-					++elem_re;
-				#endif
+				tr.count(trace::ELEM_RE);
 
 				temp = {addr->value.rank, addr->value.ptr - sizeof(temp.rank)};
                         	BCL::store(true, temp);
@@ -127,6 +124,7 @@ void dds::dang::memory<T>::free(const gptr<T> &addr)
 {
 	gptr<bool> temp = {addr.rank, addr.ptr - sizeof(addr.rank)};
 	BCL::aput_sync(false, temp);
+	tr.count(trace::RMA_PUT);
 
         if (listAlloc.size() >= HP_WINDOW)
                 scan();
@@ -151,6 +149,7 @@ void dds::dang::memory<T>::scan()
 		for (uint32_t j = 0; j < HPS_PER_UNIT; ++j)
 		{
 			hptr = BCL::aget_sync(hpTemp);
+			tr.count(trace::RMA_GET);
 			if (hptr != nullptr)
 				plist[p++] = hptr;
 			++hpTemp;
@@ -166,6 +165,7 @@ void dds::dang::memory<T>::scan()
         while (listAlloc.remove(addr) != EMPTY)
 	{
 		temp.ptr = addr->value.ptr - sizeof(addr->value.rank);
+		tr.count(trace::RMA_GET);
 		if (BCL::aget_sync(temp).taken || sds::binary_search(addr->value, plist, p))
 			new_dlist.insert(addr);
 		else
@@ -28,6 +28,7 @@ namespace hp
                 uint64_t		capacity;	//contains global memory capacity (bytes)
                 sds::list<gptr<T>>      listDelet;      //contains deleted elems
                 sds::list<gptr<T>>      listRecla;      //contains reclaimed elems
+                trace::recorder<TRACE_MEM>      tr{"HP"};      //counts reclaimed elems and remote ops
 
                 void scan();
         };
@@ -65,9 +66,7 @@ dds::gptr<T> dds::hp::memory<T>::malloc()
         if (listRecla.remove(addr) != EMPTY)
 	{
 		//tracing
-		#ifdef	TRACING
-			++elem_re;
-		#endif
+		tr.count(trace::ELEM_RE);
 
                 return addr;
 	}
@@ -82,9 +81,7 @@ dds::gptr<T> dds::hp::memory<T>::malloc()
 			if (listRecla.remove(addr) != EMPTY)
 			{
 				//tracing
-				#ifdef  TRACING
-					++elem_re;
-				#endif
+				tr.count(trace::ELEM_RE);
 
 				return addr;
 			}
@@ -120,6 +117,7 @@ void dds::hp::memory<T>::scan()
 		for (uint32_t j = 0; j < HPS_PER_UNIT; ++j)
 		{
 			hptr = BCL::aget_sync(hpTemp);
+			tr.count(trace::RMA_GET);
 			if (hptr != nullptr)
 				plist[p++] = hptr;
 			++hpTemp;
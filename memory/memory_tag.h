@@ -0,0 +1,205 @@
+#ifndef MEMORY_TAG_H
+#define MEMORY_TAG_H
+
+#include <vector>
+
+namespace dds
+{
+
+namespace tag
+{
+
+	/* Constants */
+	const uint32_t	RANK_BITS	= 20;
+	const uint32_t	INDEX_BITS	= 24;
+	const uint32_t	TAG_BITS	= 64 - RANK_BITS - INDEX_BITS;
+
+	/* Data types */
+
+	//Tagged global pointer: (rank, element index, generation) packed into 64 bits,
+	//so that it can be compared and swapped with a single MPI_Compare_and_swap.
+	//Index 0 is null, elements are numbered from 1. A null pointer may carry a tag,
+	//e.g. the next field of a node, so that a stale CAS on it fails after reuse.
+	template <typename T>
+	struct tptr
+	{
+		uint64_t	bits;
+
+				tptr();
+				tptr(const std::nullptr_t &null);
+				tptr(const uint64_t &rank, const uint64_t &index, const uint64_t &tag);
+		uint64_t	rank() const;
+		uint64_t	index() const;
+		uint64_t	tag() const;
+		tptr<T>		retag() const;		//returns the next generation of the pointer
+		tptr<T>		null() const;		//returns a null pointer with the same tag
+		bool		operator==(const std::nullptr_t &null) const;
+		bool		operator==(const tptr<T> &p) const;
+		bool		operator!=(const std::nullptr_t &null) const;
+		bool		operator!=(const tptr<T> &p) const;
+		void		print() const;
+	};
+
+	//Element-indexed pool: freed elems are reused by the unit that frees them,
+	//with the generation of their tagged pointers incremented on every reuse.
+	template <typename T>
+	class memory
+	{
+	public:
+		memory();				//collective
+		~memory();				//collective
+		tptr<T> malloc();			//allocates global memory
+		void free(const tptr<T> &);		//deallocates global memory
+		gptr<T> convert(const tptr<T> &) const;	//returns the global address of an elem
+
+	private:
+		gptr<T>			pool;		//contains the local part of the pool
+		uint64_t		next;		//contains the index of the next unused elem
+		std::vector<uint64_t>	bases;		//contains the pool offsets of all units
+		sds::list<tptr<T>>	listRecla;	//contains reclaimed elems
+		trace::recorder<TRACE_MEM>	tr{"TAG"};	//counts reclaimed elems
+	};
+
+} /* namespace tag */
+
+} /* namespace dds */
+
+template <typename T>
+dds::tag::tptr<T>::tptr()
+{
+	//do nothing
+}
+
+template <typename T>
+dds::tag::tptr<T>::tptr(const std::nullptr_t &null)
+{
+	bits = 0;
+}
+
+template <typename T>
+dds::tag::tptr<T>::tptr(const uint64_t &rank, const uint64_t &index, const uint64_t &tag)
+{
+	bits = (rank << (INDEX_BITS + TAG_BITS)) | (index << TAG_BITS) | (tag & ((1ULL << TAG_BITS) - 1));
+}
+
+template <typename T>
+uint64_t dds::tag::tptr<T>::rank() const
+{
+	return bits >> (INDEX_BITS + TAG_BITS);
+}
+
+template <typename T>
+uint64_t dds::tag::tptr<T>::index() const
+{
+	return (bits >> TAG_BITS) & ((1ULL << INDEX_BITS) - 1);
+}
+
+template <typename T>
+uint64_t dds::tag::tptr<T>::tag() const
+{
+	return bits & ((1ULL << TAG_BITS) - 1);
+}
+
+template <typename T>
+dds::tag::tptr<T> dds::tag::tptr<T>::retag() const
+{
+	return tptr<T>(rank(), index(), tag() + 1);
+}
+
+template <typename T>
+dds::tag::tptr<T> dds::tag::tptr<T>::null() const
+{
+	return tptr<T>(0, 0, tag());
+}
+
+template <typename T>
+bool dds::tag::tptr<T>::operator==(const std::nullptr_t &null) const
+{
+	return index() == 0;
+}
+
+template <typename T>
+bool dds::tag::tptr<T>::operator==(const tptr<T> &p) const
+{
+	return bits == p.bits;
+}
+
+template <typename T>
+bool dds::tag::tptr<T>::operator!=(const std::nullptr_t &null) const
+{
+	return index() != 0;
+}
+
+template <typename T>
+bool dds::tag::tptr<T>::operator!=(const tptr<T> &p) const
+{
+	return bits != p.bits;
+}
+
+template <typename T>
+void dds::tag::tptr<T>::print() const
+{
+	printf("(%lu: %lu, %lu)\n", rank(), index(), tag());
+}
+
+template <typename T>
+dds::tag::memory<T>::memory()
+{
+	if (BCL::rank() == MASTER_UNIT)
+		mem_manager = "TAG";
+
+	if (BCL::nprocs() > (1ULL << RANK_BITS) || ELEMS_PER_UNIT >= (1ULL << INDEX_BITS))
+		throw std::runtime_error("dds::tag::memory: pool does not fit into a tagged pointer");
+
+	pool = BCL::alloc<T>(ELEMS_PER_UNIT);
+	next = 1;
+
+	//exchange pool offsets, since they may differ between units
+	bases.resize(BCL::nprocs());
+	for (uint64_t i = 0; i < BCL::nprocs(); ++i)
+	{
+		uint64_t base = pool.ptr;
+		BCL::broadcast(base, i);
+		bases[i] = base;
+	}
+}
+
+template <typename T>
+dds::tag::memory<T>::~memory()
+{
+	BCL::dealloc<T>(pool);
+}
+
+template <typename T>
+dds::tag::tptr<T> dds::tag::memory<T>::malloc()
+{
+	tptr<T>		addr;
+
+	//determine the tagged address of the new element
+	if (listRecla.remove(addr) != EMPTY)
+	{
+		//tracing
+		tr.count(trace::ELEM_RE);
+
+		return addr.retag();
+	}
+	else if (next <= ELEMS_PER_UNIT)	//the list of reclaimed global memory is empty
+		return tptr<T>(BCL::rank(), next++, 0);
+	else //if (next > ELEMS_PER_UNIT)
+		return nullptr;
+}
+
+template <typename T>
+void dds::tag::memory<T>::free(const tptr<T> &addr)
+{
+	//the elem can be reused at once, a stale CAS on it fails on the tag
+	listRecla.insert(addr);
+}
+
+template <typename T>
+dds::gptr<T> dds::tag::memory<T>::convert(const tptr<T> &addr) const
+{
+	return gptr<T>(addr.rank(), bases[addr.rank()] + (addr.index() - 1) * sizeof(T));
+}
+
+#endif /* MEMORY_TAG_H */
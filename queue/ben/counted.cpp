@@ -0,0 +1,94 @@
+#include <vector>
+#include <bcl/bcl.hpp>
+#include "../inc/queue.h"
+
+using namespace dds;
+using namespace dds::msq_tag;
+
+//Every unit alternates enqueues and dequeues on the queue using tagged pointers, so
+//that freed elems are reused while other units still hold pointers to them, then
+//drains it. Every enqueued value must be dequeued exactly once: the counts and sums
+//must match. Each unit must also see the values of every other unit in FIFO order.
+int main()
+{
+	uint32_t		i,
+				value;
+	uint64_t		num_ops,
+				num_enqueued,
+				num_dequeued,
+				sum_enqueued,
+				sum_dequeued;
+	double			start,
+				end,
+				total_time;
+	bool			passed;
+
+	BCL::init();
+
+	queue<uint32_t> myQueue;
+	num_ops = ELEMS_PER_UNIT / BCL::nprocs();
+	num_enqueued = num_dequeued = sum_enqueued = sum_dequeued = 0;
+	passed = true;
+
+	//the next value expected from each unit is at least this
+	std::vector<uint64_t> next(BCL::nprocs(), 0);
+	auto check = [&](const uint32_t &value)
+	{
+		uint64_t unit = value / num_ops;
+
+		passed &= unit < BCL::nprocs() && value % num_ops >= next[unit];
+		if (unit < BCL::nprocs())
+			next[unit] = value % num_ops + 1;
+		++num_dequeued;
+		sum_dequeued += value;
+	};
+
+	start = BCL::wtime();
+
+	for (i = 0; i < num_ops / 2; ++i)
+	{
+		value = BCL::rank() * num_ops + i;
+		if (myQueue.enqueue(value))
+		{
+			++num_enqueued;
+			sum_enqueued += value;
+		}
+
+		if (myQueue.dequeue(value))
+			check(value);
+	}
+
+	end = BCL::wtime();
+
+	//drain what the other units left
+	BCL::barrier();
+	while (myQueue.dequeue(value))
+		check(value);
+	BCL::barrier();
+
+	num_enqueued = BCL::allreduce<uint64_t>(num_enqueued, BCL::sum<uint64_t>{});
+	num_dequeued = BCL::allreduce<uint64_t>(num_dequeued, BCL::sum<uint64_t>{});
+	sum_enqueued = BCL::allreduce<uint64_t>(sum_enqueued, BCL::sum<uint64_t>{});
+	sum_dequeued = BCL::allreduce<uint64_t>(sum_dequeued, BCL::sum<uint64_t>{});
+	passed = BCL::allreduce<uint64_t>(passed, BCL::sum<uint64_t>{}) == BCL::nprocs();
+	passed &= num_enqueued == num_dequeued && sum_enqueued == sum_dequeued;
+
+	total_time = BCL::reduce(end - start, MASTER_UNIT, BCL::max<double>{});
+	if (BCL::rank() == MASTER_UNIT)
+	{
+		printf("*********************************************************\n");
+		printf("*\tBENCHMARK\t:\tCounted\t\t\t*\n");
+		printf("*\tNUM_UNITS\t:\t%lu\t\t\t*\n", BCL::nprocs());
+		printf("*\tNUM_OPS\t\t:\t%lu (ops/unit)\t\t*\n", num_ops);
+		printf("*\tENQUEUED\t:\t%lu\t\t\t*\n", num_enqueued);
+		printf("*\tDEQUEUED\t:\t%lu\t\t\t*\n", num_dequeued);
+		printf("*\tCHECK\t\t:\t%s\t\t\t*\n", passed ? "PASSED" : "FAILED");
+		printf("*\tEXEC_TIME\t:\t%f (s)\t\t*\n", total_time);
+		printf("*\tTHROUGHPUT\t:\t%f (ops/s)\t*\n", num_ops * BCL::nprocs() / total_time);
+		printf("*********************************************************\n");
+	}
+
+	BCL::finalize();
+
+	return passed ? 0 : 1;
+}
@@ -1,8 +1,12 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
-#include "../../lib/common.h"	//Common
+#include "../../config.h"		//Configurations
+
+#include "../../memory/memory.h"	//Global Memory Management
 
 #include "queue_blocking.h"
 
+#include "queue_ms_tag.h"
+
 #endif /* QUEUE_H */
@@ -0,0 +1,194 @@
+#ifndef QUEUE_MS_TAG_H
+#define QUEUE_MS_TAG_H
+
+#include "../../memory/memory_tag.h"
+
+namespace dds
+{
+
+namespace msq_tag
+{
+
+        /* Macros */
+        using namespace tag;
+
+	/* Data types */
+	template <typename T>
+	struct elem
+	{
+		tptr<elem<T>>	next;
+		T		value;
+	};
+
+	template <typename T>
+	class queue
+	{
+	public:
+		queue();			//collective
+		~queue();			//collective
+		bool enqueue(const T &);	//non-collective
+		bool dequeue(T &);		//non-collective
+		void print();			//collective
+
+	private:
+		memory<elem<T>>		mem;
+		gptr<tptr<elem<T>>>	front;
+		gptr<tptr<elem<T>>>	rear;
+
+		gptr<tptr<elem<T>>> next(const tptr<elem<T>> &);	//returns the global address of the next field
+	};
+
+} /* namespace msq_tag */
+
+} /* namespace dds */
+
+template <typename T>
+dds::msq_tag::queue<T>::queue()
+{
+	//synchronize
+	BCL::barrier();
+
+        front = BCL::alloc<tptr<elem<T>>>(1);
+	rear = BCL::alloc<tptr<elem<T>>>(1);
+
+        if (BCL::rank() == MASTER_UNIT)
+        {
+		tptr<elem<T>> dummy = mem.malloc();
+		BCL::store({dummy.null(), T()}, mem.convert(dummy));
+                BCL::store(dummy, front);
+		BCL::store(dummy, rear);
+                printf("*\tQUEUE\t\t:\tMSQ_TAG\t\t\t*\n");
+        }
+        else //if (BCL::rank() != MASTER_UNIT)
+                front.rank = rear.rank = MASTER_UNIT;
+
+	//synchronize
+	BCL::barrier();
+}
+
+template <typename T>
+dds::msq_tag::queue<T>::~queue()
+{
+	if (BCL::rank() != MASTER_UNIT)
+		front.rank = rear.rank = BCL::rank();
+	BCL::dealloc<tptr<elem<T>>>(front);
+	BCL::dealloc<tptr<elem<T>>>(rear);
+}
+
+template <typename T>
+bool dds::msq_tag::queue<T>::enqueue(const T &value)
+{
+        tptr<elem<T>>   	oldRearAddr,
+                        	newRearAddr,
+				oldRearNext;
+
+        //allocate global memory to the new elem
+        newRearAddr = mem.malloc();
+        if (newRearAddr == nullptr)
+                return false;
+
+        //update new element (global memory), its null next carries its tag
+        BCL::rput_sync({newRearAddr.null(), value}, mem.convert(newRearAddr));
+
+	while (true)
+	{
+        	//get rear
+        	oldRearAddr = BCL::aget_sync(rear);
+
+		//get successor of rear
+		oldRearNext = BCL::aget_sync(next(oldRearAddr));
+
+		//are rear and its successor consistent?
+		if (oldRearAddr == BCL::aget_sync(rear))
+		{
+			if (oldRearNext == nullptr)
+			{
+				//fails if rear has been reused since, the tag of its next differs
+				if (BCL::cas_sync(next(oldRearAddr), oldRearNext, newRearAddr) == oldRearNext)
+				       break;
+			}
+			else //help to swing rear
+				BCL::cas_sync(rear, oldRearAddr, oldRearNext);
+		}
+	}
+	BCL::cas_sync(rear, oldRearAddr, newRearAddr);
+
+	return true;
+}
+
+template <typename T>
+bool dds::msq_tag::queue<T>::dequeue(T &value)
+{
+        tptr<elem<T>>   oldFrontAddr,
+			oldFrontNext,
+			oldRearAddr;
+
+	while (true)
+	{
+        	//get front
+        	oldFrontAddr = BCL::aget_sync(front);
+
+		//get rear
+		oldRearAddr = BCL::aget_sync(rear);
+
+		//get successor of front
+		oldFrontNext = BCL::aget_sync(next(oldFrontAddr));
+
+		//are front, its successor and rear consistent?
+		if (oldFrontAddr == BCL::aget_sync(front))
+		{
+			if (oldFrontAddr == oldRearAddr)
+			{
+				if (oldFrontNext == nullptr)
+					return false;
+				BCL::cas_sync(rear, oldRearAddr, oldFrontNext);
+			}
+			else
+			{
+				//get value before CAS, otherwise another dequeue might free next node
+				value = BCL::rget_sync(mem.convert(oldFrontNext)).value;
+				if (BCL::cas_sync(front, oldFrontAddr, oldFrontNext) == oldFrontAddr)
+					break;
+			}
+		}
+	}
+
+        //deallocate global memory of the old dummy elem
+        mem.free(oldFrontAddr);
+
+        return true;
+}
+
+template <typename T>
+void dds::msq_tag::queue<T>::print()
+{
+        //synchronize
+        BCL::barrier();
+
+        if (BCL::rank() == MASTER_UNIT)
+        {
+                tptr<elem<T>>   frontAddr;
+                elem<T>         frontVal;
+
+		frontAddr = BCL::rget_sync(mem.convert(BCL::load(front))).next;
+                for (; frontAddr != nullptr; frontAddr = frontVal.next)
+                {
+                        frontVal = BCL::rget_sync(mem.convert(frontAddr));
+                        printf("value = %d\n", frontVal.value);
+                        frontVal.next.print();
+                }
+        }
+
+        //synchronize
+        BCL::barrier();
+}
+
+template <typename T>
+dds::gptr<dds::tag::tptr<dds::msq_tag::elem<T>>> dds::msq_tag::queue<T>::next(const tptr<elem<T>> &addr)
+{
+	gptr<elem<T>> temp = mem.convert(addr);
+
+	return gptr<tptr<elem<T>>>(temp.rank, temp.ptr);
+}
+
+#endif /* QUEUE_MS_TAG_H */
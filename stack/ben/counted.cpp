@@ -0,0 +1,89 @@
+#include <bcl/bcl.hpp>
+#include "../inc/stack.h"
+
+using namespace dds;
+using namespace dds::ts_tag;
+
+//Every unit alternates pushes and pops on the stack using tagged pointers, so that
+//freed elems are reused while other units still hold pointers to them, then drains
+//it. Every pushed value must be popped exactly once: the counts and sums must match.
+int main()
+{
+	uint32_t	i,
+			value;
+	uint64_t	num_ops,
+			num_pushed,
+			num_popped,
+			sum_pushed,
+			sum_popped;
+	double		start,
+			end,
+			total_time;
+	bool		passed;
+
+	BCL::init();
+
+	stack<uint32_t> myStack;
+	num_ops = ELEMS_PER_UNIT / BCL::nprocs();
+	num_pushed = num_popped = sum_pushed = sum_popped = 0;
+
+	start = BCL::wtime();
+
+	for (i = 0; i < num_ops / 2; ++i)
+	{
+		value = BCL::rank() * num_ops + i;
+		if (myStack.push(value))
+		{
+			++num_pushed;
+			sum_pushed += value;
+		}
+
+		if (myStack.pop(value))
+		{
+			++num_popped;
+			sum_popped += value;
+		}
+	}
+
+	end = BCL::wtime();
+
+	//drain what the other units left
+	BCL::barrier();
+	while (myStack.pop(value))
+	{
+		++num_popped;
+		sum_popped += value;
+	}
+	BCL::barrier();
+
+	num_pushed = BCL::allreduce<uint64_t>(num_pushed, BCL::sum<uint64_t>{});
+	num_popped = BCL::allreduce<uint64_t>(num_popped, BCL::sum<uint64_t>{});
+	sum_pushed = BCL::allreduce<uint64_t>(sum_pushed, BCL::sum<uint64_t>{});
+	sum_popped = BCL::allreduce<uint64_t>(sum_popped, BCL::sum<uint64_t>{});
+	passed = num_pushed == num_popped && sum_pushed == sum_popped;
+
+	total_time = BCL::reduce(end - start, MASTER_UNIT, BCL::max<double>{});
+	if (BCL::rank() == MASTER_UNIT)
+	{
+		printf("*********************************************************\n");
+		printf("*\tBENCHMARK\t:\tCounted\t\t\t*\n");
+		printf("*\tNUM_UNITS\t:\t%lu\t\t\t*\n", BCL::nprocs());
+		printf("*\tNUM_OPS\t\t:\t%lu (ops/unit)\t\t*\n", num_ops);
+		printf("*\tSTACK\t\t:\t%s\t\t\t*\n", stack_name.c_str());
+		printf("*\tPUSHED\t\t:\t%lu\t\t\t*\n", num_pushed);
+		printf("*\tPOPPED\t\t:\t%lu\t\t\t*\n", num_popped);
+		printf("*\tCHECK\t\t:\t%s\t\t\t*\n", passed ? "PASSED" : "FAILED");
+		printf("*\tEXEC_TIME\t:\t%f (s)\t\t*\n", total_time);
+		printf("*\tTHROUGHPUT\t:\t%f (ops/s)\t*\n", num_ops * BCL::nprocs() / total_time);
+		printf("*********************************************************\n");
+	}
+
+	//tracing
+	#ifdef  TRACING
+		trace::dump();
+	#endif
+
+	BCL::finalize();
+
+	return passed ? 0 : 1;
+}
@@ -2,7 +2,6 @@
 #include <chrono>
 #include <bcl/bcl.hpp>
 #include "../inc/stack.h"
-#include "../../lib/ta.h"
 
 using namespace dds;
 using namespace dds::ts;
@@ -28,7 +27,7 @@ int main()
         stack<uint32_t> myStack(ELEMS_PER_UNIT / 2);
 	num_ops = ELEMS_PER_UNIT / BCL::nprocs();
 
-	start = MPI_Wtime();
+	start = BCL::wtime();
 
 	if (BCL::rank() % 2 == 0)
 	{
@@ -55,7 +54,7 @@ int main()
 			std::this_thread::sleep_for(std::chrono::microseconds(WORKLOAD));
 		}
 
-	end = MPI_Wtime();
+	end = BCL::wtime();
 
 	elapsed_time = (end - start) - ((double) num_ops * WORKLOAD) / 1000000;
 
@@ -76,29 +75,7 @@ int main()
 
 	//tracing
 	#ifdef  TRACING
-		uint64_t	total_elem_re,
-				total_succ_cs,
-				total_fail_cs,
-				total_succ_ea,
-				total_fail_ea;
-		double		node_time,
-				total_fail_time;
-		ta::na          na;
-
-		if (na.node_num == 1)
-			printf("[Proc %lu]%f (s), %f (s), %lu, %lu, %lu, %lu, %lu\n", BCL::rank(),
-				elapsed_time, fail_time, succ_cs, fail_cs, succ_ea, fail_ea, elem_re);
-
-		MPI_Reduce(&elem_re, &total_elem_re, 1, MPI_UINT64_T, MPI_SUM, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&succ_cs, &total_succ_cs, 1, MPI_UINT64_T, MPI_SUM, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&fail_cs, &total_fail_cs, 1, MPI_UINT64_T, MPI_SUM, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&succ_ea, &total_succ_ea, 1, MPI_UINT64_T, MPI_SUM, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&fail_ea, &total_fail_ea, 1, MPI_UINT64_T, MPI_SUM, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&elapsed_time, &node_time, 1, MPI_DOUBLE, MPI_MAX, MASTER_UNIT, na.nodeComm);
-		MPI_Reduce(&fail_time, &total_fail_time, 1, MPI_DOUBLE, MPI_MAX, MASTER_UNIT, na.nodeComm);
-		if (na.rank == MASTER_UNIT)
-			printf("[Node %d]%f (s), %f (s), %lu, %lu, %lu, %lu, %lu\n", na.node_id, node_time,
-				total_fail_time, total_succ_cs, total_fail_cs, total_succ_ea, total_fail_ea, total_elem_re);
+		trace::dump();
 	#endif
 
 	BCL::finalize();
@@ -223,7 +223,7 @@ inline double work_time(stack<T> *my_stack, const uint64_t &num_ops, const uint3
 	bk_init = exp2l(left);
 	bk_max = exp2l(right);
 
-	start = MPI_Wtime();
+	start = BCL::wtime();
 
 	for (i = 0; i < num_ops / 2; ++i)
 	{
@@ -239,7 +239,7 @@ inline double work_time(stack<T> *my_stack, const uint64_t &num_ops, const uint3
 		std::this_thread::sleep_for(std::chrono::microseconds(WORKLOAD));
 	}
 
-	end = MPI_Wtime();
+	end = BCL::wtime();
 
 	elapsed_time = (end - start) - ((double) num_ops * WORKLOAD) / 1000000;
 
@@ -13,6 +13,8 @@
 
 #include "stack_treiber_test.h"		//Treiber's Stack
 
+#include "stack_treiber_tag.h"		//Treiber's Stack using Tagged Pointers
+
 #include "stack_eb.h"			//Elimination-Backoff Stack
 
 #include "stack_eb2.h"			//Elimination-Backoff Stack 2
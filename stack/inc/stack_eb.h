@@ -66,6 +66,7 @@ namespace ebs
                 const bool        		ENLARGE =	false;
 
 		memory<elem<T>>			mem;		//contains essential stuffs to manage globmem of elems
+		trace::recorder<TRACE_EBS>	tr{"EBS"};	//counts and times ops
                 gptr<gptr<elem<T>>>		top;		//contains global memory address of the dummy node
 		gptr<gptr<unit_info<T>>>	location;	//contains global mem add of a gptr of a @unit_info
 		gptr<unit_info<T>>		p;
@@ -166,6 +167,7 @@ dds::ebs::stack<T>::~stack()
 template<typename T>
 bool dds::ebs::stack<T>::push(const T &value)
 {
+	trace::timer<TRACE_EBS>	op_timer = tr.time(trace::PUSH);
 	unit_info<T> 	temp;
 	gptr<T>		tempAddr;
 
@@ -178,8 +180,8 @@ bool dds::ebs::stack<T>::push(const T &value)
 		//tracing
 		#ifdef	TRACING
                 	printf("The stack is FULL\n");
-			++fail_cs;
 		#endif
+		tr.count(trace::FAIL_CS);
 
 		return false;
 	}
@@ -187,6 +189,7 @@ bool dds::ebs::stack<T>::push(const T &value)
 	tempAddr = {temp.itsElem.rank, temp.itsElem.ptr + sizeof(gptr<elem<T>>)};
 	#ifdef MEM_REC
 		BCL::rput_sync(value, tempAddr);
+		tr.count(trace::RMA_PUT);
 	#else
 		BCL::store(value, tempAddr);
 	#endif
@@ -200,6 +203,7 @@ bool dds::ebs::stack<T>::push(const T &value)
 template<typename T>
 bool dds::ebs::stack<T>::pop(T &value)
 {
+	trace::timer<TRACE_EBS>	op_timer = tr.time(trace::POP);
 	unit_info<T> temp;
 
 	temp.rank = BCL::rank();
@@ -224,6 +228,7 @@ bool dds::ebs::stack<T>::pop(T &value)
 	{
 		gptr<T>	tempAddr3 = {tempAddr2.rank, tempAddr2.ptr + sizeof(gptr<elem<T>>)};
 		value = BCL::rget_sync(tempAddr3);
+		tr.count(trace::RMA_GET);
 
                 //deallocate global memory of the popped elem
                 mem.free(tempAddr2);
@@ -302,16 +307,19 @@ bool dds::ebs::stack<T>::try_perform_stack_op()
 
 		//get top (from global memory to local memory)
 		oldTopAddr = BCL::aget_sync(top);
+		tr.count(trace::RMA_GET);
 
 		//update new element (global memory)
         	tempAddr = {pVal.itsElem.rank, pVal.itsElem.ptr};
 		#ifdef MEM_REC
 			BCL::rput_sync(oldTopAddr, tempAddr);
+			tr.count(trace::RMA_PUT);
 		#else
 			BCL::store(oldTopAddr, tempAddr);
 		#endif
 
 		//update top (global memory)
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(top, oldTopAddr, pVal.itsElem) == oldTopAddr)
 			return true;
 		return false;
@@ -327,6 +335,7 @@ bool dds::ebs::stack<T>::try_perform_stack_op()
 		//do {
 			//get top (from global memory to local memory)
 			oldTopAddr = BCL::aget_sync(top);
+			tr.count(trace::RMA_GET);
 
 			if (oldTopAddr == nullptr)
 			{
@@ -344,8 +353,10 @@ bool dds::ebs::stack<T>::try_perform_stack_op()
 
 		//get node (from global memory to local memory)
 		newTopVal = BCL::rget_sync(oldTopAddr);
+		tr.count(trace::RMA_GET);
 
 		//update top
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(top, oldTopAddr, newTopVal.next) == oldTopAddr)
 		{
 			BCL::store(oldTopAddr, tempAddr);
@@ -411,6 +422,7 @@ bool dds::ebs::stack<T>::try_collision(const gptr<unit_info<T>> &q, const uint32
 	unit_info<T> pVal = BCL::load(p);
 	if (pVal.op == PUSH)
 	{
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(location, q, p) == q)
 			return true;
 		else
@@ -421,9 +433,11 @@ bool dds::ebs::stack<T>::try_collision(const gptr<unit_info<T>> &q, const uint32
 	}
 	else //if (pVal.op == POP)
 	{
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(location, q, NULL_PTR_U) == q)
 		{
 			gptr<elem<T>> tempVal = BCL::rget_sync((gptr<gptr<elem<T>>>) {q.rank, q.ptr});
+			tr.count(trace::RMA_GET);
 			BCL::store(tempVal, (gptr<gptr<elem<T>>>) {p.rank, p.ptr});
 
 			return true;
@@ -444,8 +458,10 @@ void dds::ebs::stack<T>::finish_collision()
 	{
 		location.rank = BCL::rank();
                 gptr<elem<T>> tempVal = BCL::aget_sync((gptr<gptr<elem<T>>>) {location.rank, location.ptr});
+                tr.count(trace::RMA_GET);
                 BCL::store(tempVal, (gptr<gptr<elem<T>>>) {p.rank, p.ptr});
 		BCL::aput_sync(NULL_PTR_U, location);;
+		tr.count(trace::RMA_PUT);
 	}
 }
 
@@ -461,45 +477,45 @@ void dds::ebs::stack<T>::less_op()
 	backoff::backoff	bk(bk_init, bk_max);
 
 	//tracing
-	#ifdef	TRACING
-		double		start;
-	#endif
+	double		start;
 
 	while (true)
 	{
 		//tracing
-		#ifdef	TRACING
-			start = MPI_Wtime();
-		#endif
+		start = tr.start();
 
 		location.rank = myUID;
 		BCL::aput_sync(p, location);
+		tr.count(trace::RMA_PUT);
 		pos = get_position();
 
 		collision.rank = pos;
 		do {
 			him = BCL::aget_sync(collision);
+			tr.count(trace::RMA_GET);
+			tr.count(trace::RMA_CAS);
 		} while (BCL::cas_sync(collision, him, myUID) != him);
 
 		if (him != NULL_UNIT)
 		{
 			location.rank = him;
 			q = BCL::aget_sync(location);
+			tr.count(trace::RMA_GET);
 			if (q != nullptr)
 			{
 				qVal = BCL::rget_sync(q);
+				tr.count(trace::RMA_GET);
 				pVal = BCL::load(p);
 				if (qVal.rank == him && pVal.op != qVal.op)
 				{
 					location.rank = myUID;
+					tr.count(trace::RMA_CAS);
 					if (BCL::cas_sync(location, p, NULL_PTR_U) == p)
 					{
 						if (try_collision(q, him))
 						{
 							//tracing
-							#ifdef	TRACING
-								++succ_ea;
-							#endif
+							tr.count(trace::SUCC_EA);
 
 							return;
 						}
@@ -511,9 +527,7 @@ void dds::ebs::stack<T>::less_op()
 						finish_collision();
 
 						//tracing
-						#ifdef	TRACING
-							++succ_ea;
-						#endif
+						tr.count(trace::SUCC_EA);
 
 						return;
 					}
@@ -525,42 +539,35 @@ void dds::ebs::stack<T>::less_op()
 		adapt_width(SHRINK);
 
 		location.rank = myUID;
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(location, p, NULL_PTR_U) != p)
 		{
 			finish_collision();
 
 			//tracing
-			#ifdef TRACING
-				++succ_ea;
-			#endif
+			tr.count(trace::SUCC_EA);
 
 			return;
 		}
 
 	label:
 		//tracing
-		#ifdef	TRACING
-			fail_time += (MPI_Wtime() - start);
-			++fail_ea;
-			start = MPI_Wtime();
-		#endif
+		tr.fail(start);
+		tr.count(trace::FAIL_EA);
+		start = tr.start();
 
 		if (try_perform_stack_op())
 		{
 			//tracing
-			#ifdef	TRACING
-				++succ_cs;
-			#endif
+			tr.count(trace::SUCC_CS);
 
 			return;
 		}
 		else
 		{
 			//tracing
-			#ifdef	TRACING
-				fail_time += (MPI_Wtime() - start);
-				++fail_cs;
-			#endif
+			tr.fail(start);
+			tr.count(trace::FAIL_CS);
 		}
 	}
 }
@@ -569,24 +576,18 @@ template<typename T>
 void dds::ebs::stack<T>::stack_op()
 {
 	//tracing
-	#ifdef  TRACING
-		double start = MPI_Wtime();
-	#endif
+	double start = tr.start();
 
 	if (try_perform_stack_op())
 	{
 		//tracing
-		#ifdef	TRACING
-			++succ_cs;
-		#endif
+		tr.count(trace::SUCC_CS);
 	}
 	else
 	{
 		//tracing
-		#ifdef	TRACING
-			fail_time += (MPI_Wtime() - start);
-			++fail_cs;
-		#endif
+		tr.fail(start);
+		tr.count(trace::FAIL_CS);
 
 		less_op();
 	}
@@ -41,6 +41,7 @@ namespace ts
         	const gptr<elem<T>> 	NULL_PTR = nullptr; 	//is a null constant
 
 		memory<elem<T>>		mem;	//handles global memory
+		trace::recorder<TRACE_TS>	tr{"TS"};	//counts and times ops
                 gptr<gptr<elem<T>>>	top;	//points to global address of the top
 
 		bool push_fill(const T &value);
@@ -102,14 +103,13 @@ dds::ts::stack<T>::~stack()
 template<typename T>
 bool dds::ts::stack<T>::push(const T &value)
 {
+	trace::timer<TRACE_TS>	op_timer = tr.time(trace::PUSH);
         gptr<elem<T>> 		oldTopAddr,
 				newTopAddr;
 	backoff::backoff        bk(bk_init, bk_max);
 
 	//tracing
-	#ifdef	TRACING
-		double		start;
-	#endif
+	double		start;
 
 	//allocate global memory to the new elem
 	newTopAddr = mem.malloc();
@@ -118,8 +118,8 @@ bool dds::ts::stack<T>::push(const T &value)
 		//tracing
 		#ifdef	TRACING
 			printf("The stack is FULL\n");
-			++fail_cs;
 		#endif
+		tr.count(trace::FAIL_CS);
 
 		return false;
 	}
@@ -127,27 +127,26 @@ bool dds::ts::stack<T>::push(const T &value)
 	while (true)
 	{
 		//tracing
-		#ifdef	TRACING
-			start = MPI_Wtime();
-		#endif
+		start = tr.start();
 
 		//get top (from global memory to local memory)
 		oldTopAddr = BCL::aget_sync(top);
+		tr.count(trace::RMA_GET);
 
 		//update new element (global memory)
 		#ifdef MEM_REC
                 	BCL::rput_sync({oldTopAddr, value}, newTopAddr);
+                	tr.count(trace::RMA_PUT);
 		#else
                 	BCL::store({oldTopAddr, value}, newTopAddr);
 		#endif
 
 		//update top (global memory)
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(top, oldTopAddr, newTopAddr) == oldTopAddr)
 		{
 			//tracing
-			#ifdef	TRACING
-				++succ_cs;
-			#endif
+			tr.count(trace::SUCC_CS);
 
 			return true;
 		}
@@ -156,10 +155,8 @@ bool dds::ts::stack<T>::push(const T &value)
 			bk.delay_dbl();
 
 			//tracing
-			#ifdef	TRACING
-				fail_time += (MPI_Wtime() - start);
-				++fail_cs;
-			#endif
+			tr.fail(start);
+			tr.count(trace::FAIL_CS);
 		}
 	}
 }
@@ -167,38 +164,37 @@ bool dds::ts::stack<T>::push(const T &value)
 template<typename T>
 bool dds::ts::stack<T>::pop(T &value)
 {
+	trace::timer<TRACE_TS>	op_timer = tr.time(trace::POP);
 	elem<T> 		oldTopVal;
 	gptr<elem<T>> 		oldTopAddr,
 				oldTopAddr2;
 	backoff::backoff        bk(bk_init, bk_max);
 
 	//tracing
-	#ifdef  TRACING
-		double		start;
-	#endif
+	double		start;
 
 	while (true)
 	{
 		//tracing
-		#ifdef	TRACING
-			start = MPI_Wtime();
-		#endif
+		start = tr.start();
 
 		//get top (from global memory to local memory)
 		oldTopAddr = BCL::aget_sync(top);
+		tr.count(trace::RMA_GET);
 
 		if (oldTopAddr == nullptr)
 		{
 			//update hazard pointers
 			#ifdef MEM_REC
         			BCL::aput_sync(NULL_PTR, mem.hp);
+        			tr.count(trace::RMA_PUT);
 			#endif
 
 			//tracing
 			#ifdef	TRACING
 				printf("The stack is EMPTY\n");
-				++succ_cs;
 			#endif
+			tr.count(trace::SUCC_CS);
 
 			return false;
 		}
@@ -206,21 +202,23 @@ bool dds::ts::stack<T>::pop(T &value)
 		//update hazard pointers
 		#ifdef MEM_REC
 			BCL::aput_sync(oldTopAddr, mem.hp);
+			tr.count(trace::RMA_PUT);
 			oldTopAddr2 = BCL::aget_sync(top);
+			tr.count(trace::RMA_GET);
 			if (oldTopAddr != oldTopAddr2)
 				continue;
 		#endif
 
 		//get node (from global memory to local memory)
 		oldTopVal = BCL::rget_sync(oldTopAddr);
+		tr.count(trace::RMA_GET);
 
 		//update top
+		tr.count(trace::RMA_CAS);
 		if (BCL::cas_sync(top, oldTopAddr, oldTopVal.next) == oldTopAddr)
 		{
 			//tracing
-			#ifdef	TRACING
-				++succ_cs;
-			#endif
+			tr.count(trace::SUCC_CS);
 
 			break;
 		}
@@ -229,16 +227,15 @@ bool dds::ts::stack<T>::pop(T &value)
 			bk.delay_dbl();
 
 			//tracing
-			#ifdef	TRACING
-				fail_time += (MPI_Wtime() - start);
-				++fail_cs;
-			#endif
+			tr.fail(start);
+			tr.count(trace::FAIL_CS);
 		}
 	}
 
 	//update hazard pointers
 	#ifdef MEM_REC
 		BCL::aput_sync(NULL_PTR, mem.hp);
+		tr.count(trace::RMA_PUT);
 	#endif
 
 	//return the value of the popped elem
@@ -0,0 +1,265 @@
+#ifndef STACK_TREIBER_TAG_H
+#define STACK_TREIBER_TAG_H
+
+#include "../../lib/backoff.h"
+#include "../../memory/memory_tag.h"
+
+namespace dds
+{
+
+namespace ts_tag
+{
+
+	/* Macros */
+	using namespace tag;
+
+	/* Data types */
+        template <typename T>
+        struct elem
+        {
+                tptr<elem<T>>   next;
+                T               value;
+        };
+
+	template <typename T>
+	class stack
+	{
+	public:
+		stack();			//collective
+		stack(const uint64_t &num);	//collective
+		~stack();			//collective
+		bool push(const T &value);	//non-collective
+		bool pop(T &value);		//non-collective
+		void print();			//collective
+
+	private:
+        	const tptr<elem<T>> 	NULL_PTR = nullptr; 	//is a null constant
+
+		memory<elem<T>>		mem;	//handles global memory
+		trace::recorder<TRACE_TS>	tr{"TS_TAG"};	//counts and times ops
+                gptr<tptr<elem<T>>>	top;	//points to global address of the top
+
+		bool push_fill(const T &value);
+	};
+
+} /* namespace ts_tag */
+
+} /* namespace dds */
+
+template<typename T>
+dds::ts_tag::stack<T>::stack()
+{
+	//synchronize
+	BCL::barrier();
+
+	top = BCL::alloc<tptr<elem<T>>>(1);
+	if (BCL::rank() == MASTER_UNIT)
+	{
+                BCL::store(NULL_PTR, top);
+		stack_name = "TS_TAG";
+	}
+	else
+		top.rank = MASTER_UNIT;
+
+	//synchronize
+	BCL::barrier();
+}
+
+template<typename T>
+dds::ts_tag::stack<T>::stack(const uint64_t &num)
+{
+	//synchronize
+	BCL::barrier();
+
+	top = BCL::alloc<tptr<elem<T>>>(1);
+	if (BCL::rank() == MASTER_UNIT)
+	{
+		BCL::store(NULL_PTR, top);
+		stack_name = "TS_TAG";
+
+		for (uint64_t i = 0; i < num; ++i)
+			push_fill(i);
+	}
+	else
+		top.rank = MASTER_UNIT;
+
+        //synchronize
+        BCL::barrier();
+}
+
+template<typename T>
+dds::ts_tag::stack<T>::~stack()
+{
+	if (BCL::rank() != MASTER_UNIT)
+		top.rank = BCL::rank();
+	BCL::dealloc<tptr<elem<T>>>(top);
+}
+
+template<typename T>
+bool dds::ts_tag::stack<T>::push(const T &value)
+{
+	trace::timer<TRACE_TS>	op_timer = tr.time(trace::PUSH);
+        tptr<elem<T>> 		oldTopAddr,
+				newTopAddr;
+	backoff::backoff        bk(bk_init, bk_max);
+
+	//tracing
+	double		start;
+
+	//allocate global memory to the new elem
+	newTopAddr = mem.malloc();
+	if (newTopAddr == nullptr)
+	{
+		//tracing
+		#ifdef	TRACING
+			printf("The stack is FULL\n");
+		#endif
+		tr.count(trace::FAIL_CS);
+
+		return false;
+	}
+
+	while (true)
+	{
+		//tracing
+		start = tr.start();
+
+		//get top (from global memory to local memory)
+		oldTopAddr = BCL::aget_sync(top);
+		tr.count(trace::RMA_GET);
+
+		//update new element (global memory)
+               	BCL::rput_sync({oldTopAddr, value}, mem.convert(newTopAddr));
+		tr.count(trace::RMA_PUT);
+
+		//update top (global memory)
+		tr.count(trace::RMA_CAS);
+		if (BCL::cas_sync(top, oldTopAddr, newTopAddr) == oldTopAddr)
+		{
+			//tracing
+			tr.count(trace::SUCC_CS);
+
+			return true;
+		}
+		else //if (BCL::cas_sync(top, oldTopAddr, newTopAddr) != oldTopAddr)
+		{
+			bk.delay_dbl();
+
+			//tracing
+			tr.fail(start);
+			tr.count(trace::FAIL_CS);
+		}
+	}
+}
+
+template<typename T>
+bool dds::ts_tag::stack<T>::pop(T &value)
+{
+	trace::timer<TRACE_TS>	op_timer = tr.time(trace::POP);
+	elem<T> 		oldTopVal;
+	tptr<elem<T>> 		oldTopAddr;
+	backoff::backoff        bk(bk_init, bk_max);
+
+	//tracing
+	double		start;
+
+	while (true)
+	{
+		//tracing
+		start = tr.start();
+
+		//get top (from global memory to local memory)
+		oldTopAddr = BCL::aget_sync(top);
+		tr.count(trace::RMA_GET);
+
+		if (oldTopAddr == nullptr)
+		{
+			//tracing
+			#ifdef	TRACING
+				printf("The stack is EMPTY\n");
+			#endif
+			tr.count(trace::SUCC_CS);
+
+			return false;
+		}
+
+		//get node (from global memory to local memory), no hazard pointer is
+		//needed: if the node has been reused meanwhile, the tag of top differs
+		oldTopVal = BCL::rget_sync(mem.convert(oldTopAddr));
+		tr.count(trace::RMA_GET);
+
+		//update top
+		tr.count(trace::RMA_CAS);
+		if (BCL::cas_sync(top, oldTopAddr, oldTopVal.next) == oldTopAddr)
+		{
+			//tracing
+			tr.count(trace::SUCC_CS);
+
+			break;
+		}
+		else //if (BCL::cas_sync(top, oldTopAddr, oldTopVal.next) != oldTopAddr)
+		{
+			bk.delay_dbl();
+
+			//tracing
+			tr.fail(start);
+			tr.count(trace::FAIL_CS);
+		}
+	}
+
+	//return the value of the popped elem
+	value = oldTopVal.value;
+
+	//deallocate global memory of the popped elem
+	mem.free(oldTopAddr);
+
+	return true;
+}
+
+template<typename T>
+void dds::ts_tag::stack<T>::print()
+{
+	//synchronize
+	BCL::barrier();
+
+	if (BCL::rank() == MASTER_UNIT)
+	{
+		tptr<elem<T>>	topAddr;
+		elem<T>		topVal;
+
+		for (topAddr = BCL::load(top); topAddr != nullptr; topAddr = topVal.next)
+		{
+			topVal = BCL::rget_sync(mem.convert(topAddr));
+                	printf("value = %d\n", topVal.value);
+                	topVal.next.print();
+		}
+	}
+
+	//synchronize
+	BCL::barrier();
+}
+
+template<typename T>
+bool dds::ts_tag::stack<T>::push_fill(const T &value)
+{
+	tptr<elem<T>>		oldTopAddr,
+				newTopAddr;
+
+	//allocate global memory to the new elem
+	newTopAddr = mem.malloc();
+	if (newTopAddr == nullptr)
+		return false;
+
+	//get top (from global memory to local memory)
+	oldTopAddr = BCL::load(top);
+
+	//update new element (global memory)
+	BCL::store({oldTopAddr, value}, mem.convert(newTopAddr));
+
+	//update top (global memory)
+	BCL::store(newTopAddr, top);
+
+	return true;
+}
+
+#endif /* STACK_TREIBER_TAG_H */